@@ -70,6 +70,18 @@
 *                           fix bug on clock reference time in satpos_ssr()
 *                           fix bug on wrong value with ura=15 in var_ura()
 *                           use integer types in stdint.h
+*           2026/10/17 1.15 select ephemeris by ephemeris index if available
+*                           add API setephindex()
+*                           add API satcacheinit(),satcachefree()
+*                           cache satellite state by broadcast ephemeris
+*                           cache glonass integration steps in ephpos()
+*                           compute satellites in satposs() with one dispatch
+*                           of ephemeris option and peph2poss()
+*                           fix bug on variance of broadcast clock set to the
+*                           first satellite in satposs()
+*                           access satellite state cache without lock
+*                           add API satcacheshare()
+*                           integrate glonass orbit out of lock in ephpos()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -109,6 +121,7 @@
 static int eph_sel[]={ /* GPS,GLO,GAL,QZS,BDS,IRN,SBS */
     0,0,0,0,0,0,0
 };
+static int eph_idx=1; /* ephemeris index (0:off,1:on,2:on and validate) */
 
 /* variance by ura ephemeris -------------------------------------------------*/
 static double var_uraeph(int sys, int ura)
@@ -325,6 +338,48 @@ static void glorbit(double t, double *x, const double *acc)
     deq(w,k4,acc);
     for (i=0;i<6;i++) x[i]+=(k1[i]+2.0*k2[i]+2.0*k3[i]+k4[i])*t/6.0;
 }
+/* glonass position by numerical integration with cached steps ----------------
+* states after full integration steps from toe are stored to and restored from
+* the orbit state st (NULL: no cache). the steps and the results are the same
+* as without cache.
+*-----------------------------------------------------------------------------*/
+static void geph2pos_(gtime_t time, const geph_t *geph, glostate_t *st,
+                      double *rs, double *dts, double *var)
+{
+    double t,tt,x[6];
+    int i,n,d;
+    
+    trace(4,"geph2pos: time=%s sat=%2d\n",time_str(time,3),geph->sat);
+    
+    t=timediff(time,geph->toe);
+    
+    *dts=-geph->taun+geph->gamn*t;
+    trace(4,"geph2pos: sat=%d\n",geph->sat);
+
+    for (i=0;i<3;i++) {
+        x[i  ]=geph->pos[i];
+        x[i+3]=geph->vel[i];
+    }
+    d=t<0.0?0:1;
+    
+    for (tt=t<0.0?-TSTEP:TSTEP,n=0;fabs(t)>1E-9;t-=tt,n++) {
+        if (fabs(t)<TSTEP) tt=t;
+        else if (st&&n<MAXGLOSTEP) { /* full step */
+            if (n<st->n[d]) {
+                for (i=0;i<6;i++) x[i]=st->x[d][n][i];
+                continue;
+            }
+            glorbit(tt,x,geph->acc);
+            for (i=0;i<6;i++) st->x[d][n][i]=x[i];
+            st->n[d]=n+1;
+            continue;
+        }
+        glorbit(tt,x,geph->acc);
+    }
+    for (i=0;i<3;i++) rs[i]=x[i];
+    
+    *var=SQR(ERREPH_GLO);
+}
 /* glonass ephemeris to satellite clock bias -----------------------------------
 * compute satellite clock bias with glonass ephemeris
 * args   : gtime_t time     I   time by satellite clock (gpst)
@@ -361,27 +416,7 @@ extern double geph2clk(gtime_t time, const geph_t *geph)
 extern void geph2pos(gtime_t time, const geph_t *geph, double *rs, double *dts,
                      double *var)
 {
-    double t,tt,x[6];
-    int i;
-    
-    trace(4,"geph2pos: time=%s sat=%2d\n",time_str(time,3),geph->sat);
-    
-    t=timediff(time,geph->toe);
-    
-    *dts=-geph->taun+geph->gamn*t;
-    trace(4,"geph2pos: sat=%d\n",geph->sat);
-
-    for (i=0;i<3;i++) {
-        x[i  ]=geph->pos[i];
-        x[i+3]=geph->vel[i];
-    }
-    for (tt=t<0.0?-TSTEP:TSTEP;fabs(t)>1E-9;t-=tt) {
-        if (fabs(t)<TSTEP) tt=t;
-        glorbit(tt,x,geph->acc);
-    }
-    for (i=0;i<3;i++) rs[i]=x[i];
-    
-    *var=SQR(ERREPH_GLO);
+    geph2pos_(time,geph,NULL,rs,dts,var);
 }
 /* sbas ephemeris to satellite clock bias --------------------------------------
 * compute satellite clock bias with sbas ephemeris
@@ -432,12 +467,12 @@ extern void seph2pos(gtime_t time, const seph_t *seph, double *rs, double *dts,
     *var=var_uraeph(SYS_SBS,seph->sva);
 }
 /* select ephemeris ƥ--------------------------------------------------------*/
-static eph_t *seleph(gtime_t time, int sat, int iode, const nav_t *nav)
+static int seleph_(gtime_t time, int sat, int iode, const nav_t *nav, int scan,
+                   double *tmin)
 {
-    double t,tmax,tmin;
-    int i,j=-1,sys,sel=0;
-    
-    trace(4,"seleph  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
+    const int *idx=NULL;
+    double t,tmax;
+    int i,k,n,j=-1,sys,sel=0;
     
     sys=satsys(sat,NULL);
     switch (sys) {/*ϵͳo,nļʱֵ*/
@@ -448,9 +483,14 @@ static eph_t *seleph(gtime_t time, int sat, int iode, const nav_t *nav)
         case SYS_IRN: tmax=MAXDTOE_IRN+1.0; sel=eph_sel[5]; break;
         default: tmax=MAXDTOE+1.0; break;
     }
-    tmin=tmax+1.0;
+    *tmin=tmax+1.0;
     
-    for (i=0;i<nav->n;i++) {/**/
+    /* ephemerides around time by index or all by linear scan */
+    if (scan||(n=ephindexwin(nav,0,sat,time,tmax,&idx))<0) {
+        idx=NULL; n=nav->n;
+    }
+    for (k=0;k<n;k++) {/**/
+        i=idx?idx[k]:k;
         if (nav->eph[i].sat!=sat) continue;/*/ɸѡ-ͬprn*/
         if (iode>=0&&nav->eph[i].iode!=iode) continue;/*/ɸѡ-ͬiode;ephclk()ñʱiodeΪ-1,iode*/
         if (sys==SYS_GAL) {
@@ -465,56 +505,115 @@ static eph_t *seleph(gtime_t time, int sat, int iode, const nav_t *nav)
             if (timediff(nav->eph[i].toe,time)>=0.0) continue; /* AOD<=0 */
         }
         if ((t=fabs(timediff(nav->eph[i].toe,time)))>tmax) continue;/*/ɸѡ-n,oļʱֵ*/
-        if (iode>=0) return nav->eph+i;/*/еiode>0,eph+iָǰѭԪ*/
+        if (iode>=0) {/*/еiode>0,eph+iָǰѭԪ*/
+            if (j<0||i<j) j=i; /* first one in array */
+            if (!idx) break; else continue;
+        }
         /*/iode<0ʱ,ֵ,ҪҳС,j¼λ*/
-        if (t<=tmin) {j=i; tmin=t;} /* toe closest to time oļtoe¼*/
+        if (t<*tmin||(t==*tmin&&i>j)) {j=i; *tmin=t;} /* toe closest to time oļtoe¼*/
+    }
+    return j;
+    /*úʵֵЧ: iodeֵ>0,iodeֵƥ,ڵͬiodeֵ
+                       iodeֵ<0,򲻽ҪʱСֵ,ʱС*/
+}
+/* select ephemeris ----------------------------------------------------------*/
+static eph_t *seleph(gtime_t time, int sat, int iode, const nav_t *nav)
+{
+    double tmin,tmin_s;
+    int j,j_s;
+    
+    trace(4,"seleph  : time=%s sat=%2d iode=%d\n",time_str(time,3),sat,iode);
+    
+    j=seleph_(time,sat,iode,nav,!eph_idx,&tmin);
+    
+    if (eph_idx==2&&(j_s=seleph_(time,sat,iode,nav,1,&tmin_s))!=j) {
+        trace(1,"seleph: index mismatch sat=%2d j=%d scan=%d\n",sat,j,j_s);
+        j=j_s; tmin=tmin_s;
     }
-    if (iode>=0||j<0) {/*/iode0,ʱ>ֵƥʧ*/
+    if (j<0) {
         trace(2,"no broadcast ephemeris: %s sat=%2d iode=%3d\n",time_str(time,0),
               sat,iode);
         return NULL;
     }
-    /*/,iode<0,صСֵʱ*/
-    trace(4,"seleph: sat=%d dt=%.0f\n",sat,tmin);
+    if (iode<0) trace(4,"seleph: sat=%d dt=%.0f\n",sat,tmin);
     return nav->eph+j;
-    /*úʵֵЧ: iodeֵ>0,iodeֵƥ,ڵͬiodeֵ
-                       iodeֵ<0,򲻽ҪʱСֵ,ʱС*/
 }
 /* select glonass ephememeris ------------------------------------------------*/
-static geph_t *selgeph(gtime_t time, int sat, int iode, const nav_t *nav)
+static int selgeph_(gtime_t time, int sat, int iode, const nav_t *nav, int scan,
+                    double *tmin)
 {
-    double t,tmax=MAXDTOE_GLO,tmin=tmax+1.0;
-    int i,j=-1;
+    const int *idx=NULL;
+    double t,tmax=MAXDTOE_GLO;
+    int i,k,n,j=-1;
     
-    trace(4,"selgeph : time=%s sat=%2d iode=%2d\n",time_str(time,3),sat,iode);
+    *tmin=tmax+1.0;
     
-    for (i=0;i<nav->ng;i++) {
+    if (scan||(n=ephindexwin(nav,1,sat,time,tmax,&idx))<0) {
+        idx=NULL; n=nav->ng;
+    }
+    for (k=0;k<n;k++) {
+        i=idx?idx[k]:k;
         if (nav->geph[i].sat!=sat) continue;
         if (iode>=0&&nav->geph[i].iode!=iode) continue;
         if ((t=fabs(timediff(nav->geph[i].toe,time)))>tmax) continue;
-        if (iode>=0) return nav->geph+i;
-        if (t<=tmin) {j=i; tmin=t;} /* toe closest to time */
+        if (iode>=0) {
+            if (j<0||i<j) j=i; /* first one in array */
+            if (!idx) break; else continue;
+        }
+        if (t<*tmin||(t==*tmin&&i>j)) {j=i; *tmin=t;} /* toe closest to time */
     }
-    if (iode>=0||j<0) {
+    return j;
+}
+static geph_t *selgeph(gtime_t time, int sat, int iode, const nav_t *nav)
+{
+    double tmin,tmin_s;
+    int j,j_s;
+    
+    trace(4,"selgeph : time=%s sat=%2d iode=%2d\n",time_str(time,3),sat,iode);
+    
+    j=selgeph_(time,sat,iode,nav,!eph_idx,&tmin);
+    
+    if (eph_idx==2&&(j_s=selgeph_(time,sat,iode,nav,1,&tmin_s))!=j) {
+        trace(1,"selgeph: index mismatch sat=%2d j=%d scan=%d\n",sat,j,j_s);
+        j=j_s; tmin=tmin_s;
+    }
+    if (j<0) {
         trace(3,"no glonass ephemeris  : %s sat=%2d iode=%2d\n",time_str(time,0),
               sat,iode);
         return NULL;
     }
-    trace(4,"selgeph: sat=%d dt=%.0f\n",sat,tmin);
+    if (iode<0) trace(4,"selgeph: sat=%d dt=%.0f\n",sat,tmin);
     return nav->geph+j;
 }
 /* select sbas ephememeris ---------------------------------------------------*/
-static seph_t *selseph(gtime_t time, int sat, const nav_t *nav)
+static int selseph_(gtime_t time, int sat, const nav_t *nav, int scan)
 {
+    const int *idx=NULL;
     double t,tmax=MAXDTOE_SBS,tmin=tmax+1.0;
-    int i,j=-1;
-    
-    trace(4,"selseph : time=%s sat=%2d\n",time_str(time,3),sat);
+    int i,k,n,j=-1;
     
-    for (i=0;i<nav->ns;i++) {
+    if (scan||(n=ephindexwin(nav,2,sat,time,tmax,&idx))<0) {
+        idx=NULL; n=nav->ns;
+    }
+    for (k=0;k<n;k++) {
+        i=idx?idx[k]:k;
         if (nav->seph[i].sat!=sat) continue;
         if ((t=fabs(timediff(nav->seph[i].t0,time)))>tmax) continue;
-        if (t<=tmin) {j=i; tmin=t;} /* toe closest to time */
+        if (t<tmin||(t==tmin&&i>j)) {j=i; tmin=t;} /* toe closest to time */
+    }
+    return j;
+}
+static seph_t *selseph(gtime_t time, int sat, const nav_t *nav)
+{
+    int j,j_s;
+    
+    trace(4,"selseph : time=%s sat=%2d\n",time_str(time,3),sat);
+    
+    j=selseph_(time,sat,nav,!eph_idx);
+    
+    if (eph_idx==2&&(j_s=selseph_(time,sat,nav,1))!=j) {
+        trace(1,"selseph: index mismatch sat=%2d j=%d scan=%d\n",sat,j,j_s);
+        j=j_s;
     }
     if (j<0) {
         trace(3,"no sbas ephemeris     : %s sat=%2d\n",time_str(time,0),sat);
@@ -555,6 +654,114 @@ static int ephclk(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     
     return 1;
 }
+/* load satellite state from cache -------------------------------------------*/
+static int loadsatc(const nav_t *nav, int sat, const void *eph, gtime_t toe,
+                    int iode, gtime_t time, satstate_t *key, double *rs,
+                    double *dts, double *var, int *svh)
+{
+    satcache_t *sc=nav->sc;
+    satstate_t *s;
+    double dt;
+    int i,j;
+    
+    key->time=time; key->eph=eph; key->toe=toe; key->iode=iode;
+    
+    if (!sc||sat<=0||sat>MAXSAT) return 0;
+    
+    for (j=0;j<2;j++) {
+        s=sc->sat[sat-1]+j;
+        if (s->eph!=eph||s->iode!=iode||s->toe.time!=toe.time||
+            s->toe.sec!=toe.sec) continue;
+        if (fabs(dt=timediff(time,s->time))>sc->tol) continue;
+        
+        /* extrapolate cached state to time */
+        for (i=0;i<3;i++) {
+            rs[i  ]=s->rs[i]+s->rs[i+3]*dt;
+            rs[i+3]=s->rs[i+3];
+        }
+        dts[0]=s->dts[0]+s->dts[1]*dt;
+        dts[1]=s->dts[1];
+        *var=s->var;
+        *svh=s->svh;
+        sc->nhit++;
+        return 1;
+    }
+    sc->nmiss++;
+    return 0;
+}
+/* save satellite state to cache ---------------------------------------------*/
+static void savesatc(const nav_t *nav, int sat, const satstate_t *key,
+                     const double *rs, const double *dts, double var, int svh)
+{
+    satcache_t *sc=nav->sc;
+    satstate_t *s;
+    double dt[2];
+    int i;
+    
+    if (!sc||sat<=0||sat>MAXSAT) return;
+    
+    /* replace state of farther time */
+    s=sc->sat[sat-1];
+    dt[0]=fabs(timediff(key->time,s[0].time));
+    dt[1]=fabs(timediff(key->time,s[1].time));
+    if (dt[0]<dt[1]) s++;
+    *s=*key;
+    for (i=0;i<6;i++) s->rs[i]=rs[i];
+    s->dts[0]=dts[0];
+    s->dts[1]=dts[1];
+    s->var=var;
+    s->svh=svh;
+}
+/* get glonass orbit state of ephemeris from table --------------------------*/
+static glostate_t *glostate(glotbl_t *glo, const geph_t *geph)
+{
+    glostate_t *st;
+    int prn;
+    
+    if (!glo||satsys(geph->sat,&prn)!=SYS_GLO||prn<MINPRNGLO||
+        prn>MAXPRNGLO) return NULL;
+    
+    st=glo->st+prn-MINPRNGLO;
+    if (st->eph!=geph||st->iode!=geph->iode||st->toe.time!=geph->toe.time||
+        st->toe.sec!=geph->toe.sec) {
+        st->eph=geph; st->toe=geph->toe; st->iode=geph->iode;
+        st->n[0]=st->n[1]=0;
+    }
+    return st;
+}
+/* load/save glonass orbit state of ephemeris from/to table -----------------*/
+static int loadglo(glotbl_t *glo, const geph_t *geph, glostate_t *st)
+{
+    glostate_t *s;
+    int d;
+    
+    lock(&glo->lock);
+    if ((s=glostate(glo,geph))) {
+        st->eph=s->eph; st->toe=s->toe; st->iode=s->iode;
+        for (d=0;d<2;d++) {
+            st->n[d]=s->n[d];
+            memcpy(st->x[d],s->x[d],sizeof(double)*6*s->n[d]);
+        }
+    }
+    unlock(&glo->lock);
+    return s!=NULL;
+}
+static void saveglo(glotbl_t *glo, const geph_t *geph, const glostate_t *st)
+{
+    glostate_t *s;
+    int d;
+    
+    lock(&glo->lock);
+    if ((s=glostate(glo,geph))) {
+        for (d=0;d<2;d++) {
+            if (st->n[d]<=s->n[d]) continue;
+            memcpy(s->x[d]+s->n[d],st->x[d]+s->n[d],
+                   sizeof(double)*6*(st->n[d]-s->n[d]));
+            s->n[d]=st->n[d];
+        }
+    }
+    unlock(&glo->lock);
+}
 /* satellite position and clock by broadcast ephemeris -----------------------*/
 static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
                   int iode, double *rs, double *dts, double *var, int *svh)
@@ -562,6 +769,9 @@ static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     eph_t  *eph;
     geph_t *geph;
     seph_t *seph;
+    satstate_t key;
+    glotbl_t *glo;
+    glostate_t st;
     double rst[3],dtst[1],tt=1E-3;
     int i,sys;
     
@@ -573,6 +783,8 @@ static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     
     if (sys==SYS_GPS||sys==SYS_GAL||sys==SYS_QZS||sys==SYS_CMP||sys==SYS_IRN) {
         if (!(eph=seleph(teph,sat,iode,nav))) return 0;/*/ƥ,ʧ*/
+        if (loadsatc(nav,sat,eph,eph->toe,eph->iode,time,&key,rs,dts,var,
+                     svh)) return 1;
         eph2pos(time,eph,rs,dts,var);/*/λúӲ,rsdts*/
         time=timeadd(time,tt);/*/Ϊʱ,ǵλúӲ(ͨŶǵٶȺƯ,עⲻǽܻ)*/
         eph2pos(time,eph,rst,dtst,var);/*/ǵλúӲ,rstdtst*/
@@ -580,13 +792,24 @@ static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     }
     else if (sys==SYS_GLO) {
         if (!(geph=selgeph(teph,sat,iode,nav))) return 0;
-        geph2pos(time,geph,rs,dts,var);
+        if (loadsatc(nav,sat,geph,geph->toe,geph->iode,time,&key,rs,dts,var,
+                     svh)) return 1;
+        
+        /* integrate orbit on local copy of cached steps */
+        if (!(glo=nav->sc?nav->sc->glo:NULL)||!loadglo(glo,geph,&st)) {
+            glo=NULL;
+        }
+        geph2pos_(time,geph,glo?&st:NULL,rs,dts,var);
         time=timeadd(time,tt);
-        geph2pos(time,geph,rst,dtst,var);
+        geph2pos_(time,geph,glo?&st:NULL,rst,dtst,var);
+        if (glo) saveglo(glo,geph,&st);
         *svh=geph->svh;
     }
     else if (sys==SYS_SBS) {
         if (!(seph=selseph(teph,sat,nav))) return 0;
+        if (loadsatc(nav,sat,seph,seph->t0,0,time,&key,rs,dts,var,svh)) {
+            return 1;
+        }
         seph2pos(time,seph,rs,dts,var);
         time=timeadd(time,tt);
         seph2pos(time,seph,rst,dtst,var);
@@ -598,6 +821,7 @@ static int ephpos(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
     for (i=0;i<3;i++) rs[i+3]=(rst[i]-rs[i])/tt;
     dts[1]=(dtst[0]-dts[0])/tt;
     
+    savesatc(nav,sat,&key,rs,dts,*var,*svh);
     return 1;
 }
 /* satellite position and clock with sbas correction -------------------------*/
@@ -741,6 +965,7 @@ static int satpos_ssr(gtime_t time, gtime_t teph, int sat, const nav_t *nav,
 * return : status (1:ok,0:error)
 * notes  : satellite position is referenced to antenna phase center
 *          satellite clock does not include code bias correction (tgd or bgd)
+*          satellite state cache nav->sc is updated if not NULL
 *-----------------------------------------------------------------------------*/
 extern int satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
                   const nav_t *nav, double *rs, double *dts, double *var,
@@ -762,6 +987,93 @@ extern int satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
     *svh=-1;
     return 0;
 }
+/* satellite positions and clocks of satellites --------------------------------
+* compute positions, velocities and clocks of satellites at given times with
+* one dispatch of ephemeris option for all satellites
+* (time[i]={0}: not computed, outputs in the same layout as satposs())
+*-----------------------------------------------------------------------------*/
+static void satposs_(gtime_t teph, int ephopt, const nav_t *nav,
+                     const int *sat, const gtime_t *time, int n, double *rs,
+                     double *dts, double *var, int *svh, int *stat)
+{
+    int i,j;
+    
+    for (i=0;i<n;i++) {
+        for (j=0;j<6;j++) rs [j+i*6]=0.0;
+        for (j=0;j<2;j++) dts[j+i*2]=0.0;
+        var[i]=0.0; svh[i]=stat[i]=0;
+    }
+    switch (ephopt) {
+        case EPHOPT_BRDC:
+            for (i=0;i<n;i++) {
+                if (time[i].time==0) continue;
+                stat[i]=ephpos(time[i],teph,sat[i],nav,-1,rs+i*6,dts+i*2,var+i,
+                               svh+i);
+            }
+            break;
+        case EPHOPT_SBAS:
+            for (i=0;i<n;i++) {
+                if (time[i].time==0) continue;
+                stat[i]=satpos_sbas(time[i],teph,sat[i],nav,rs+i*6,dts+i*2,
+                                    var+i,svh+i);
+            }
+            break;
+        case EPHOPT_SSRAPC:
+        case EPHOPT_SSRCOM:
+            for (i=0;i<n;i++) {
+                if (time[i].time==0) continue;
+                stat[i]=satpos_ssr(time[i],teph,sat[i],nav,
+                                   ephopt==EPHOPT_SSRCOM,rs+i*6,dts+i*2,var+i,
+                                   svh+i);
+            }
+            break;
+        case EPHOPT_PREC:
+            peph2poss(time,sat,n,nav,1,rs,dts,var,stat);
+            for (i=0;i<n;i++) if (time[i].time!=0&&!stat[i]) svh[i]=-1;
+            break;
+        default:
+            for (i=0;i<n;i++) if (time[i].time!=0) svh[i]=-1;
+            break;
+    }
+    for (i=0;i<n;i++) {
+        if (!stat[i]) {
+            if (time[i].time!=0) {
+                trace(3,"no ephemeris %s sat=%2d\n",time_str(time[i],3),sat[i]);
+            }
+            continue;
+        }
+        /* if no precise clock available, use broadcast clock instead */
+        if (dts[i*2]==0.0) {
+            if (!ephclk(time[i],teph,sat[i],nav,dts+i*2)) continue;
+            dts[1+i*2]=0.0;
+            var[i]=SQR(STD_BRDCCLK);
+        }
+    }
+}
+/* signal transmission time by pseudorange and broadcast clock ---------------*/
+static int sattxtime(gtime_t teph, const obsd_t *obs, const nav_t *nav,
+                     gtime_t *time, double *dt, double *pr)
+{
+    int j;
+    
+    /* search any pseudorange */
+    for (j=0,*pr=0.0;j<NFREQ;j++) if ((*pr=obs->P[j])!=0.0) break;
+    
+    if (j>=NFREQ) {
+        trace(2,"no pseudorange %s sat=%2d\n",time_str(obs->time,3),obs->sat);
+        return 0;
+    }
+    /* transmission time by satellite clock */
+    *time=timeadd(obs->time,-*pr/CLIGHT);
+    
+    /* satellite clock bias by broadcast ephemeris */
+    if (!ephclk(*time,teph,obs->sat,nav,dt)) {
+        trace(3,"no broadcast clock %s sat=%2d\n",time_str(*time,3),obs->sat);
+        return 0;
+    }
+    *time=timeadd(*time,-*dt);
+    return 1;
+}
 /* satellite positions and clocks ----------------------------------------------
 * compute satellite positions, velocities and clocks
 * args   : gtime_t teph     I   time to select ephemeris (gpst)
@@ -785,57 +1097,35 @@ extern int satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
 *          satellite clock does not include code bias correction (tgd or bgd)
 *          any pseudorange and broadcast ephemeris are always needed to get
 *          signal transmission time
+*          satellite state cache nav->sc is updated if not NULL
 *-----------------------------------------------------------------------------*/
 extern void satposs(gtime_t teph, const obsd_t *obs, int n, const nav_t *nav,
                     int ephopt, double *rs, double *dts, double *var, int *svh)
 {
-    gtime_t time[2*MAXOBS]={{0}};
-    double dt,pr;
-    int i,j;
+    gtime_t time[2*MAXOBS],time0={0};
+    double dt[2*MAXOBS],pr[2*MAXOBS];
+    int i,m,sat[2*MAXOBS],stat[2*MAXOBS];
     
     trace(3,"satposs : teph=%s n=%d ephopt=%d\n",time_str(teph,3),n,ephopt);
     
-    for (i=0;i<n&&i<2*MAXOBS;i++) {/*/ʼ*/
-        for (j=0;j<6;j++) rs [j+i*6]=0.0;
-        for (j=0;j<2;j++) dts[j+i*2]=0.0;
-        var[i]=0.0; svh[i]=0;
-        
-        /* search any pseudorange Ѱα probs.p(۲α)*/
-        for (j=0,pr=0.0;j<NFREQ;j++) if ((pr=obs[i].P[j])!=0.0) break;
-        
-        if (j>=NFREQ) {
-            trace(2,"no pseudorange %s sat=%2d\n",time_str(obs[i].time,3),obs[i].sat);
-            continue;
-        }
-        /* transmission time by satellite clock ջt-ʱ(ԼαԹ)Ƿʱ̵ź(gpst)*/
-        time[i]=timeadd(obs[i].time,-pr/CLIGHT);/*δ޸ӲӲԶڴʱ,time[i]һΪԵźŷʱ̵ʱ*/
+    for (i=0;i<n&&i<2*MAXOBS;i++) {
+        sat[i]=obs[i].sat;
         
-        /* satellite clock bias by broadcast ephemeris ɹ㲥Ƿʱ̵Ӳ
-        ephclk ƥʵephṹ,ephдnļе,ұڽṹnav*/
-        if (!ephclk(time[i],teph,obs[i].sat,nav,&dt)) {
-            trace(3,"no broadcast clock %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
-            continue;
-        }
-        time[i]=timeadd(time[i],-dt);/*/Ӳ(t-ӲźŷʱӲֵ)*/
-
-        /* satellite position and clock at transmission time ǷźʱλٶȺӲ*/
-        if (!satpos(time[i],teph,obs[i].sat,ephopt,nav,rs+i*6,dts+i*2,var+i,
-                    svh+i)) {/*/rsÿһ6Ԫ,x y z;vx vy vz;dtsÿһԪطֱΪӲ*/
-            trace(3,"no ephemeris %s sat=%2d\n",time_str(time[i],3),obs[i].sat);
-            continue;
-        }
-        /* if no precise clock available, use broadcast clock instead */
-        if (dts[i*2]==0.0) {
-            if (!ephclk(time[i],teph,obs[i].sat,nav,dts+i*2)) continue;
-            dts[1+i*2]=0.0;
-            *var=SQR(STD_BRDCCLK);
-        }
+        /* signal transmission time */
+        if (!sattxtime(teph,obs+i,nav,time+i,dt+i,pr+i)) time[i]=time0;
+    }
+    m=i;
+    
+    /* satellite positions and clocks at transmission times */
+    satposs_(teph,ephopt,nav,sat,time,m,rs,dts,var,svh,stat);
+    
+    for (i=0;i<m;i++) {
+        if (!stat[i]) continue;
         trace(4,"satposs: %d,time=%.9f dt=%.9f pr=%.3f rs=%13.3f %13.3f %13.3f dts=%12.3f var=%7.3f\n",
-            obs[i].sat,time[i].sec,dt,pr,rs[i*6],rs[1+i*6],rs[2+i*6],dts[i*2]*1E9,
-            var[i]);
-
+            obs[i].sat,time[i].sec,dt[i],pr[i],rs[i*6],rs[1+i*6],rs[2+i*6],
+            dts[i*2]*1E9,var[i]);
     }
-    for (i=0;i<n&&i<2*MAXOBS;i++) {
+    for (i=0;i<m;i++) {
         trace(4,"%s sat=%2d rs=%13.3f %13.3f %13.3f dts=%12.3f var=%7.3f svh=%02X\n",
               time_str(time[i],9),obs[i].sat,rs[i*6],rs[1+i*6],rs[2+i*6],
               dts[i*2]*1E9,var[i],svh[i]);
@@ -864,6 +1154,137 @@ extern void setseleph(int sys, int sel)
         case SYS_SBS: eph_sel[6]=sel; break;
     }
     }
+/* set ephemeris index mode ----------------------------------------------------
+* Set mode of ephemeris selection by ephemeris index built by ephindex().
+* args   : int    mode      I   ephemeris index mode
+*                                 0: off (linear scan)
+*                                 1: on  (binary search in index) (default)
+*                                 2: on and validate selected ephemeris against
+*                                    linear scan (trace level 1 on mismatch)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void setephindex(int mode)
+{
+    eph_idx=mode;
+}
+/* new satellite state cache without glonass orbit states -------------------*/
+static satcache_t *newsatc(double tol)
+{
+    satcache_t *sc;
+    
+    if (!(sc=(satcache_t *)malloc(sizeof(satcache_t)))) return NULL;
+    sc->tol=tol;
+    sc->nhit=sc->nmiss=0;
+    memset(sc->sat,0,sizeof(sc->sat));
+    sc->glo=NULL;
+    sc->pwin.peph=NULL;
+    sc->pwin.i0=-1;
+    sc->pidx=sc->cidx=0;
+    return sc;
+}
+/* initialize satellite state cache --------------------------------------------
+* Initialize cache of satellite positions and clocks by broadcast ephemeris to
+* share them among satposs() calls in an epoch (rover, base and single point
+* positioning).
+* args   : nav_t  *nav      IO  navigation data
+*          double tol       I   tolerance of time to reuse cached state (s)
+*                               (0: reuse only for the same time)
+* return : status (1:ok,0:memory allocation error)
+* notes  : a cached state is reused for the same satellite and ephemeris if
+*          the time differs within tol, extrapolated by the cached velocity
+*          and clock drift
+*          the cache is updated by satpos(), satposs() and peph2pos() through
+*          const nav_t * without lock, so it shall be used by one thread. a
+*          thread processing the same navigation data concurrently shall use
+*          a copy of nav_t with own cache by satcacheinit() or satcacheshare()
+*-----------------------------------------------------------------------------*/
+extern int satcacheinit(nav_t *nav, double tol)
+{
+    glotbl_t *glo=NULL;
+    int i;
+    
+    trace(3,"satcacheinit: tol=%.3g\n",tol);
+    
+    satcachefree(nav);
+    
+    if (!(nav->sc=newsatc(tol))) {
+        trace(1,"satcacheinit: malloc error\n");
+        return 0;
+    }
+    if (NSATGLO<=0) return 1;
+    
+    if (!(glo=(glotbl_t *)malloc(sizeof(glotbl_t)))||
+        !(glo->st=(glostate_t *)malloc(sizeof(glostate_t)*NSATGLO))) {
+        trace(1,"satcacheinit: malloc error\n");
+        free(glo); free(nav->sc); nav->sc=NULL;
+        return 0;
+    }
+    for (i=0;i<NSATGLO;i++) {
+        glo->st[i].eph=NULL;
+        glo->st[i].n[0]=glo->st[i].n[1]=0;
+    }
+    glo->nref=1;
+    initlock(&glo->lock);
+    nav->sc->glo=glo;
+    return 1;
+}
+/* initialize satellite state cache sharing glonass orbit states ---------------
+* Initialize cache of satellite positions and clocks with own satellite states
+* sharing glonass orbit states with the cache of other navigation data.
+* args   : nav_t  *nav      IO  navigation data
+*          nav_t  *src      I   navigation data with cache to share glonass
+*                               orbit states (same ephemerides as nav)
+* return : status (1:ok,0:memory allocation error or no cache in src)
+* notes  : the glonass orbit states are locked while they are accessed, so
+*          nav and src can be used by different threads. free the cache of nav
+*          by satcachefree() before the cache of src.
+*-----------------------------------------------------------------------------*/
+extern int satcacheshare(nav_t *nav, const nav_t *src)
+{
+    trace(3,"satcacheshare:\n");
+    
+    satcachefree(nav);
+    
+    if (!src->sc) return 0;
+    
+    if (!(nav->sc=newsatc(src->sc->tol))) {
+        trace(1,"satcacheshare: malloc error\n");
+        return 0;
+    }
+    if ((nav->sc->glo=src->sc->glo)) {
+        lock(&nav->sc->glo->lock);
+        nav->sc->glo->nref++;
+        unlock(&nav->sc->glo->lock);
+    }
+    return 1;
+}
+/* free satellite state cache --------------------------------------------------
+* Free cache of satellite positions and clocks.
+* args   : nav_t  *nav      IO  navigation data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void satcachefree(nav_t *nav)
+{
+    glotbl_t *glo;
+    int nref;
+    
+    if (!nav->sc) return;
+    
+    trace(3,"satcachefree: hit=%u miss=%u\n",nav->sc->nhit,nav->sc->nmiss);
+    
+    if ((glo=nav->sc->glo)) {
+        lock(&glo->lock);
+        nref=--glo->nref;
+        unlock(&glo->lock);
+        if (nref<=0) {
+            freelock(&glo->lock);
+            free(glo->st);
+            free(glo);
+        }
+    }
+    free(nav->sc);
+    nav->sc=NULL;
+}
 /* get selected satellite ephemeris -------------------------------------------
 * Get the selected satellite ephemeris.
 * args   : int    sys       I   satellite system (SYS_???)
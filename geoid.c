@@ -13,12 +13,16 @@
 *           2009/12/05 1.2  added api:
 *                               opengeoid(),closegeoid()
 *           2020/11/30 1.3  use integer types in stdint.h
+*           2026/10/17 1.4  map geoid model file to memory instead of reading
+*                           it by file pointer for concurrent calls
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
 static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg) */
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
-static FILE *fp_geoid=NULL;         /* geoid file pointer */
+static const uint8_t *dat_geoid=NULL; /* geoid model data */
+static size_t len_geoid=0;          /* geoid model data length (bytes) */
+static int map_geoid=0;             /* geoid model data mapped (0:loaded) */
 static int model_geoid=GEOID_EMBEDDED; /* geoid model */
 
 /* bilinear interpolation ----------------------------------------------------*/
@@ -47,14 +51,14 @@ static double geoidh_emb(const double *pos)
     y[3]=geoid[i2][j2];
     return interpb(y,a,b);
 }
-/* get 2 byte signed integer from file ---------------------------------------*/
-static int16_t fget2b(FILE *fp, int32_t off)
+/* get 2 byte signed integer from geoid data --------------------------------*/
+static int16_t get2b(size_t off)
 {
-    uint8_t v[2]={0x00};
-    if (fseek(fp,off,SEEK_SET)==EOF||fread(v,2,1,fp)<1) {
-        trace(2,"geoid data file range error: off=%ld\n",off);
+    if (off+2>len_geoid) {
+        trace(2,"geoid data file range error: off=%ld\n",(long)off);
+        return 0;
     }
-    return ((int16_t)v[0]<<8)+v[1]; /* big-endian */
+    return ((int16_t)dat_geoid[off]<<8)+dat_geoid[off+1]; /* big-endian */
 }
 /* egm96 15x15" model --------------------------------------------------------*/
 static double geoidh_egm96(const double *pos)
@@ -64,25 +68,27 @@ static double geoidh_egm96(const double *pos)
     double a,b,y[4];
     int i1,i2,j1,j2;
     
-    if (!fp_geoid) return 0.0;
+    if (!dat_geoid) return 0.0;
     
     a=(pos[1]-lon0)/dlon;
     b=(pos[0]-lat0)/dlat;
     i1=(int)a; a-=i1; i2=i1<nlon-1?i1+1:0;
     j1=(int)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fget2b(fp_geoid,2L*(i1+j1*nlon))*0.01;
-    y[1]=fget2b(fp_geoid,2L*(i2+j1*nlon))*0.01;
-    y[2]=fget2b(fp_geoid,2L*(i1+j2*nlon))*0.01;
-    y[3]=fget2b(fp_geoid,2L*(i2+j2*nlon))*0.01;
+    y[0]=get2b(2L*(i1+j1*nlon))*0.01;
+    y[1]=get2b(2L*(i2+j1*nlon))*0.01;
+    y[2]=get2b(2L*(i1+j2*nlon))*0.01;
+    y[3]=get2b(2L*(i2+j2*nlon))*0.01;
     return interpb(y,a,b);
 }
-/* get 4byte float from file -------------------------------------------------*/
-static float fget4f(FILE *fp, int off)
+/* get 4byte float from geoid data -------------------------------------------*/
+static float get4f(size_t off)
 {
     float v=0.0;
-    if (fseek(fp,(long)off,SEEK_SET)==EOF||fread(&v,4,1,fp)<1) {
-        trace(2,"geoid data file range error: off=%ld\n",off);
+    if (off+4>len_geoid) {
+        trace(2,"geoid data file range error: off=%ld\n",(long)off);
+        return v;
     }
+    memcpy(&v,dat_geoid+off,4);
     return v; /* small-endian */
 }
 /* egm2008 model -------------------------------------------------------------*/
@@ -94,7 +100,7 @@ static double geoidh_egm08(const double *pos, int model)
     int i1,i2,j1,j2;
     int nlon,nlat;
     
-    if (!fp_geoid) return 0.0;
+    if (!dat_geoid) return 0.0;
     
     if (model==GEOID_EGM2008_M25) { /* 2.5 x 2.5" grid */
         dlon= 2.5/60.0;
@@ -120,31 +126,32 @@ static double geoidh_egm08(const double *pos, int model)
     /* (2) Und_min2.5x2.5_egm2008_isw=82_WGS84_TideFree_SE.gz */
 #if 0
     /* not zero-inserted */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon)));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon)));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon)));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon)));
+    y[0]=get4f(4L*(i1+j1*(nlon)));
+    y[1]=get4f(4L*(i2+j1*(nlon)));
+    y[2]=get4f(4L*(i1+j2*(nlon)));
+    y[3]=get4f(4L*(i2+j2*(nlon)));
 #else
     /* zero-inserted version (2009/12/10) */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon+2)+1));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon+2)+1));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon+2)+1));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon+2)+1));
+    y[0]=get4f(4L*(i1+j1*(nlon+2)+1));
+    y[1]=get4f(4L*(i2+j1*(nlon+2)+1));
+    y[2]=get4f(4L*(i1+j2*(nlon+2)+1));
+    y[3]=get4f(4L*(i2+j2*(nlon+2)+1));
 #endif
     return interpb(y,a,b);
 }
 /* get gsi geoid data --------------------------------------------------------*/
-static double fgetgsi(FILE *fp, int nlon, int nlat, int i, int j)
+static double getgsi(int nlon, int nlat, int i, int j)
 {
     const int nf=28,wf=9,nl=nf*wf+2,nr=(nlon-1)/nf+1;
     double v;
-    int off=nl+j*nr*nl+i/nf*nl+i%nf*wf;
+    size_t off=nl+(size_t)j*nr*nl+i/nf*nl+i%nf*wf;
     char buff[16]="";
     
-    if (fseek(fp,(long)off,SEEK_SET)==EOF||fread(buff,wf,1,fp)<1) {
+    if (off+wf>len_geoid) {
         trace(2,"out of range for gsi geoid: i=%d j=%d\n",i,j);
         return 0.0;
     }
+    memcpy(buff,dat_geoid+off,wf);
     if (sscanf(buff,"%lf",&v)<1) {
         trace(2,"gsi geoid data format error: i=%d j=%d buff=%s\n",i,j,buff);
         return 0.0;
@@ -160,7 +167,7 @@ static double geoidh_gsi(const double *pos)
     double a,b,y[4];
     int i1,i2,j1,j2;
     
-    if (!fp_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
+    if (!dat_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
         trace(2,"out of range for gsi geoid: lat=%.3f lon=%.3f\n",pos[0],pos[1]);
         return 0.0;
     }
@@ -168,16 +175,39 @@ static double geoidh_gsi(const double *pos)
     b=(pos[0]-lat0)/dlat;
     i1=(int)a; a-=i1; i2=i1<nlon-1?i1+1:i1;
     j1=(int)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fgetgsi(fp_geoid,nlon,nlat,i1,j1);
-    y[1]=fgetgsi(fp_geoid,nlon,nlat,i2,j1);
-    y[2]=fgetgsi(fp_geoid,nlon,nlat,i1,j2);
-    y[3]=fgetgsi(fp_geoid,nlon,nlat,i2,j2);
+    y[0]=getgsi(nlon,nlat,i1,j1);
+    y[1]=getgsi(nlon,nlat,i2,j1);
+    y[2]=getgsi(nlon,nlat,i1,j2);
+    y[3]=getgsi(nlon,nlat,i2,j2);
     if (y[0]==999.0||y[1]==999.0||y[2]==999.0||y[3]==999.0) {
         trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
         return 0.0;
     }
     return interpb(y,a,b);
 }
+/* load geoid model file to memory -------------------------------------------*/
+static const uint8_t *loadgeoid(const char *file, size_t *size)
+{
+    FILE *fp;
+    uint8_t *p;
+    long len;
+    
+    if (!(fp=fopen(file,"rb"))) return NULL;
+    
+    if (fseek(fp,0,SEEK_END)||(len=ftell(fp))<=0||fseek(fp,0,SEEK_SET)||
+        !(p=(uint8_t *)malloc(len))) {
+        fclose(fp);
+        return NULL;
+    }
+    if (fread(p,len,1,fp)<1) {
+        free(p);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *size=(size_t)len;
+    return p;
+}
 /* open geoid model file -------------------------------------------------------
 * open geoid model file
 * args   : int    model     I   geoid model type
@@ -194,6 +224,9 @@ static double geoidh_gsi(const double *pos)
 *          Und_min1x1_egm2008_isw=82_WGS84_TideFree_SE    : EGM2008 1.0x1.0"
 *          gsigeome_ver4 : GSI geoid 2000 1.0x1.5" (japanese area)
 *          (byte-order of binary files must be compatible to cpu)
+*          the file is mapped to memory (or loaded if mapping is not
+*          available) and shared read-only by geoidh() calls. not thread-safe
+*          with concurrent geoidh() calls.
 *-----------------------------------------------------------------------------*/
 extern int opengeoid(int model, const char *file)
 {
@@ -208,8 +241,15 @@ extern int opengeoid(int model, const char *file)
         trace(2,"invalid geoid model: model=%d file=%s\n",model,file);
         return 0;
     }
-    if (!(fp_geoid=fopen(file,"rb"))) {
+    if ((dat_geoid=mapfile(file,&len_geoid))) {
+        map_geoid=1;
+    }
+    else if ((dat_geoid=loadgeoid(file,&len_geoid))) {
+        map_geoid=0;
+    }
+    else {
         trace(2,"geoid model file open error: model=%d file=%s\n",model,file);
+        len_geoid=0;
         return 0;
     }
     model_geoid=model;
@@ -224,8 +264,15 @@ extern void closegeoid(void)
 {
     trace(3,"closegoid:\n");
     
-    if (fp_geoid) fclose(fp_geoid);
-    fp_geoid=NULL;
+    if (dat_geoid) {
+        if (!map_geoid) {
+            free((void *)dat_geoid);
+        }
+        else unmapfile(dat_geoid,len_geoid);
+    }
+    dat_geoid=NULL;
+    len_geoid=0;
+    map_geoid=0;
     model_geoid=GEOID_EMBEDDED;
 }
 /* geoid height ----------------------------------------------------------------
@@ -235,6 +282,7 @@ extern void closegeoid(void)
 * notes  : to use external geoid model, call function opengeoid() to open
 *          geoid model before calling the function. If the external geoid model
 *          is not open, the function uses embedded geoid model.
+*          the function is thread-safe.
 *-----------------------------------------------------------------------------*/
 extern double geoidh(const double *pos)
 {
@@ -13,47 +13,56 @@
 * version : $Revision: 1.1 $ $Date: 2008/07/17 21:48:06 $
 * history : 2007/01/13 1.0 new
 *           2015/05/31 1.1 add api lambda_reduction(), lambda_search()
+*           2026/10/17 1.2 add api lambdaws(), freelambdaws()
+*                          no memory allocation in search with workspace
+*                          store L and S by row for search
+*                          add search node limit, deadline and threads
+*                          add warm-started reduction by cached Z-transform
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
 /* constants/macros ----------------------------------------------------------*/
 
 #define LOOPMAX     10000           /* maximum count of search loop */
+#define MAXSRCHTH   16              /* max number of search threads */
 
 #define SGN(x)      ((x)<=0.0?-1.0:1.0)
 #define ROUND(x)    (floor((x)+0.5))
 #define SWAP(x,y)   do {double tmp_; tmp_=x; x=y; y=tmp_;} while (0)
+#define MIN(x,y)    ((x)<=(y)?(x):(y))
+#define MAX(x,y)    ((x)>=(y)?(x):(y))
 
-/* LD factorization (Q=L'*diag(D)*L) -----------------------------------------*/
-static int LD(int n, const double *Q, double *L, double *D)
+/* LD factorization (Q=L'*diag(D)*L) (A: work n x n) -------------------------*/
+static int LD(int n, const double *Q, double *L, double *D, double *A)
 {
     int i,j,k,info=0;
-    double a,*A=mat(n,n);
+    double a;
     
     memcpy(A,Q,sizeof(double)*n*n);
     for (i=n-1;i>=0;i--) {
         if ((D[i]=A[i+i*n])<=0.0) {info=-1; break;}
         a=sqrt(D[i]);
         for (j=0;j<=i;j++) L[i+j*n]=A[i+j*n]/a;
-        for (j=0;j<=i-1;j++) for (k=0;k<=j;k++) A[j+k*n]-=L[i+k*n]*L[i+j*n];
+        for (k=0;k<=i-1;k++) for (j=k;j<=i-1;j++) A[j+k*n]-=L[i+k*n]*L[i+j*n];
         for (j=0;j<=i;j++) L[i+j*n]/=L[i+i*n];
     }
-    free(A);
     if (info) fprintf(stderr,"%s : LD factorization error\n",__FILE__);
     return info;
 }
-/* integer gauss transformation ----------------------------------------------*/
-static void gauss(int n, double *L, double *Z, int i, int j)
+/* integer gauss transformation (Zi: Z^-1 or NULL) ---------------------------*/
+static void gauss(int n, double *L, double *Z, double *Zi, int i, int j)
 {
     int k,mu;
     
     if ((mu=(int)ROUND(L[i+j*n]))!=0) {
         for (k=i;k<n;k++) L[k+n*j]-=(double)mu*L[k+i*n];
         for (k=0;k<n;k++) Z[k+n*j]-=(double)mu*Z[k+i*n];
+        if (Zi) for (k=0;k<n;k++) Zi[i+n*k]+=(double)mu*Zi[j+n*k];
     }
 }
-/* permutations --------------------------------------------------------------*/
-static void perm(int n, double *L, double *D, int j, double del, double *Z)
+/* permutations (Zi: Z^-1 or NULL) -------------------------------------------*/
+static void perm(int n, double *L, double *D, int j, double del, double *Z,
+                 double *Zi)
 {
     int k;
     double eta,lam,a0,a1;
@@ -69,71 +78,151 @@ static void perm(int n, double *L, double *D, int j, double del, double *Z)
     L[j+1+j*n]=lam;
     for (k=j+2;k<n;k++) SWAP(L[k+j*n],L[k+(j+1)*n]);
     for (k=0;k<n;k++) SWAP(Z[k+j*n],Z[k+(j+1)*n]);
+    if (Zi) for (k=0;k<n;k++) SWAP(Zi[j+k*n],Zi[j+1+k*n]);
 }
-/* lambda reduction (z=Z'*a, Qz=Z'*Q*Z=L'*diag(D)*L) (ref.[1]) ---------------*/
-static void reduction(int n, double *L, double *D, double *Z)
+/* lambda reduction (z=Z'*a, Qz=Z'*Q*Z=L'*diag(D)*L) (ref.[1]) ---------------
+* Zi is updated to Z^-1 along with Z if not NULL                             */
+static void reduction(int n, double *L, double *D, double *Z, double *Zi)
 {
     int i,j,k;
     double del;
     
     j=n-2; k=n-2;
     while (j>=0) {
-        if (j<=k) for (i=j+1;i<n;i++) gauss(n,L,Z,i,j);
+        if (j<=k) for (i=j+1;i<n;i++) gauss(n,L,Z,Zi,i,j);
         del=D[j]+L[j+1+j*n]*L[j+1+j*n]*D[j+1];
         if (del+1E-6<D[j+1]) { /* compared considering numerical error */
-            perm(n,L,D,j,del,Z);
+            perm(n,L,D,j,del,Z,Zi);
             k=j; j=n-2;
         }
         else j--;
     }
 }
-/* modified lambda (mlambda) search (ref. [2]) -------------------------------
-* args   : n      I  number of float parameters
-*          m      I  number of fixed solution
-           L,D    I  transformed covariance matrix
-           zs     I  transformed double-diff phase biases
-           zn     O  fixed solutions
-           s      O  sum of residuals for fixed solutions                    */
-static int search(int n, int m, const double *L, const double *D,
-                  const double *zs, double *zn, double *s)
+/* mlambda search state shared by search threads ----------------------------*/
+typedef struct {
+    int n,m;                /* number of float parameters and fixed solutions */
+    const double *L,*D;     /* transformed covariance (L by row) */
+    const double *zs;       /* transformed double-diff phase biases */
+    double *zn,*s;          /* fixed solutions and sum of residuals */
+    int nn,imax;            /* number of stored solutions, index of max s */
+    double maxdist;         /* max distance of stored solutions */
+    int nthread;            /* number of search threads */
+    int nnode,maxnode;      /* number of visited nodes, max number of nodes */
+    int deadline;           /* deadline enable flag */
+    uint32_t tdead;         /* deadline (tick) */
+    int stop;               /* stop flag (0:running,1:node limit,2:deadline) */
+    lock_t lock;            /* lock flag (nthread>1) */
+} srch_t;
+
+typedef struct {            /* mlambda search thread */
+    srch_t *sh;             /* shared search state */
+    int t;                  /* thread index (top-level branches t,t+T,...) */
+    double *work;           /* work array (n*(n+1)/2+4*n x 1) */
+    thread_t thread;        /* thread handle */
+} srchth_t;
+
+/* store candidate and return max distance (ref. [2]) ------------------------*/
+static double store(srch_t *sh, const double *z, double newdist)
+{
+    double maxdist;
+    int i,n=sh->n,m=sh->m;
+    
+    if (sh->nthread>1) lock(&sh->lock);
+    
+    if (sh->nn<m) {  /* store the first m initial points */
+        if (sh->nn==0||newdist>sh->s[sh->imax]) sh->imax=sh->nn;
+        for (i=0;i<n;i++) sh->zn[i+sh->nn*n]=z[i];
+        sh->s[sh->nn++]=newdist;
+    }
+    else {
+        if (newdist<sh->s[sh->imax]) {
+            for (i=0;i<n;i++) sh->zn[i+sh->imax*n]=z[i];
+            sh->s[sh->imax]=newdist;
+            for (i=sh->imax=0;i<m;i++) if (sh->s[sh->imax]<sh->s[i]) sh->imax=i;
+        }
+        sh->maxdist=sh->s[sh->imax];
+    }
+    maxdist=sh->maxdist;
+    
+    if (sh->nthread>1) unlock(&sh->lock);
+    return maxdist;
+}
+/* update visited nodes and check node limit and deadline --------------------*/
+static int budget(srch_t *sh, int nnode, double *maxdist)
 {
-    int i,j,k,c,nn=0,imax=0;
-    double newdist,maxdist=1E99,y;
-    double *S=zeros(n,n),*dist=mat(n,1),*zb=mat(n,1),*z=mat(n,1),*step=mat(n,1);
+    int stop;
+    
+    if (sh->nthread>1) lock(&sh->lock);
+    
+    sh->nnode+=nnode;
+    if (sh->maxnode>0&&sh->nnode>=sh->maxnode) {
+        if (!sh->stop) sh->stop=1;
+    }
+    if (sh->deadline&&(int)(tickget()-sh->tdead)>=0) {
+        if (!sh->stop) sh->stop=2;
+    }
+    if (maxdist) *maxdist=sh->maxdist;
+    stop=sh->stop;
+    
+    if (sh->nthread>1) unlock(&sh->lock);
+    return !stop;
+}
+/* modified lambda (mlambda) search of top-level branches (ref. [2]) ---------
+* top-level branches are visited in the order of closest integers, and
+* branches t, t+T, t+2T,... are searched by thread t of T threads.
+* lower triangular L and partial sums S are stored by row (row k from
+* k*(k+1)/2) to update S contiguously in move down.                         */
+static void searchbr(srchth_t *th)
+{
+    srch_t *sh=th->sh;
+    const double *L=sh->L,*D=sh->D,*zs=sh->zs,*Sk1,*Lk1;
+    double newdist,maxdist,y,dz,*Sk;
+    double *S=th->work,*dist,*zb,*z,*step;
+    int i,k,c,n=sh->n,nt=sh->nthread>1?sh->nthread:1;
+    
+    dist=S+n*(n+1)/2; zb=dist+n; z=zb+n; step=z+n;
+    for (i=0;i<n;i++) S[(n-1)*n/2+i]=0.0;
+    
+    if (sh->nthread>1) lock(&sh->lock);
+    maxdist=sh->maxdist;
+    if (sh->nthread>1) unlock(&sh->lock);
     
     k=n-1; dist[k]=0.0;
     zb[k]=zs[k];
     z[k]=ROUND(zb[k]);
     y=zb[k]-z[k];
     step[k]=SGN(y);  /* step towards closest integer */
-    for (c=0;c<LOOPMAX;c++) {
+    for (i=0;i<th->t;i++) { /* first top-level branch of thread */
+        z[k]+=step[k];
+        step[k]=-step[k]-SGN(step[k]);
+    }
+    y=zb[k]-z[k];
+    
+    for (c=0;;c++) {
+        if (c>0&&!(c&255)&&!budget(sh,256,&maxdist)) return;
+        if (c>=sh->maxnode) { /* node limit of thread */
+            budget(sh,c&255,NULL);
+            if (sh->nthread>1) lock(&sh->lock);
+            if (!sh->stop) sh->stop=1;
+            if (sh->nthread>1) unlock(&sh->lock);
+            return;
+        }
         newdist=dist[k]+y*y/D[k];  /* newdist=sum(((z(j)-zb(j))^2/d(j))) */
         if (newdist<maxdist) {
             /* Case 1: move down */
             if (k!=0) {
                 dist[--k]=newdist;
-                for (i=0;i<=k;i++)
-                    S[k+i*n]=S[k+1+i*n]+(z[k+1]-zb[k+1])*L[k+1+i*n];
-                zb[k]=zs[k]+S[k+k*n];
+                Sk=S+k*(k+1)/2; Sk1=Sk+k+1; Lk1=L+(k+1)*(k+2)/2;
+                dz=z[k+1]-zb[k+1];
+                for (i=0;i<=k;i++) Sk[i]=Sk1[i]+dz*Lk1[i];
+                zb[k]=zs[k]+Sk[k];
                 z[k]=ROUND(zb[k]); /* next valid integer */
                 y=zb[k]-z[k];
                 step[k]=SGN(y);
             }
             /* Case 2: store the found candidate and try next valid integer */
             else {
-                if (nn<m) {  /* store the first m initial points */
-                    if (nn==0||newdist>s[imax]) imax=nn;
-                    for (i=0;i<n;i++) zn[i+nn*n]=z[i];
-                    s[nn++]=newdist;
-                }
-                else {
-                    if (newdist<s[imax]) {
-                        for (i=0;i<n;i++) zn[i+imax*n]=z[i];
-                        s[imax]=newdist;
-                        for (i=imax=0;i<m;i++) if (s[imax]<s[i]) imax=i;
-                    }
-                    maxdist=s[imax];
-                }
+                maxdist=store(sh,z,newdist);
                 z[0]+=step[0]; /* next valid integer */
                 y=zb[0]-z[0];
                 step[0]=-step[0]-SGN(step[0]);
@@ -144,64 +233,299 @@ static int search(int n, int m, const double *L, const double *D,
             if (k==n-1) break;
             else {
                 k++;  /* move up */
-                z[k]+=step[k];  /* next valid integer */
+                for (i=0;i<(k==n-1?nt:1);i++) { /* next valid integer */
+                    z[k]+=step[k];
+                    step[k]=-step[k]-SGN(step[k]);
+                }
                 y=zb[k]-z[k];
-                step[k]=-step[k]-SGN(step[k]);
             }
         }
     }
-    for (i=0;i<m-1;i++) { /* sort by s */
-        for (j=i+1;j<m;j++) {
+    budget(sh,c&255,NULL);
+}
+/* mlambda search thread -----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI searchthread(void *arg)
+#else
+static void *searchthread(void *arg)
+#endif
+{
+    searchbr((srchth_t *)arg);
+    return 0;
+}
+/* modified lambda (mlambda) search (ref. [2]) -------------------------------
+* args   : n      I  number of float parameters
+*          m      I  number of fixed solution
+           L,D    I  transformed covariance matrix
+           zs     I  transformed double-diff phase biases
+           zn     O  fixed solutions
+           s      O  sum of residuals for fixed solutions
+           work   -  work array (n*(n+1)/2+T*(n*(n+1)/2+4*n) x 1, T: threads)
+           ws     IO search controls and status (NULL: default)
+* return : 0:ok,-2:search not completed within the limits
+*          (with ws, 0 is returned for best-effort solutions and ws->opt=0)  */
+static int search(int n, int m, const double *L, const double *D,
+                  const double *zs, double *zn, double *s, double *work,
+                  lambdaws_t *ws)
+{
+    srch_t sh={0};
+    srchth_t th[MAXSRCHTH];
+    double *Lr=work;
+    int i,j,k,nt;
+    
+    nt=ws&&ws->nthread>1?MIN(ws->nthread,MAXSRCHTH):1;
+    
+    for (i=0;i<n;i++) for (j=0;j<=i;j++) Lr[i*(i+1)/2+j]=L[i+j*n];
+    
+    sh.n=n; sh.m=m; sh.L=Lr; sh.D=D; sh.zs=zs; sh.zn=zn; sh.s=s;
+    sh.maxdist=1E99;
+    sh.nthread=nt;
+    sh.maxnode=ws&&ws->maxnode>0?ws->maxnode:LOOPMAX*nt;
+    sh.deadline=ws?ws->deadline:0;
+    sh.tdead=ws?ws->tdead:0;
+    
+    for (i=0;i<nt;i++) {
+        th[i].sh=&sh; th[i].t=i;
+        th[i].work=work+n*(n+1)/2+i*(n*(n+1)/2+4*n);
+    }
+    if (nt>1) {
+        initlock(&sh.lock);
+        for (i=1;i<nt;i++) {
+#ifdef WIN32
+            if (!(th[i].thread=CreateThread(NULL,0,searchthread,th+i,0,NULL))) {
+#else
+            if (pthread_create(&th[i].thread,NULL,searchthread,th+i)) {
+#endif
+                searchbr(th+i); /* run in caller if thread create error */
+                th[i].work=NULL;
+            }
+        }
+        searchbr(th);
+        for (i=1;i<nt;i++) {
+            if (!th[i].work) continue;
+#ifdef WIN32
+            WaitForSingleObject(th[i].thread,INFINITE);
+            CloseHandle(th[i].thread);
+#else
+            pthread_join(th[i].thread,NULL);
+#endif
+        }
+        freelock(&sh.lock);
+    }
+    else searchbr(th);
+    
+    for (i=0;i<sh.nn-1;i++) { /* sort by s */
+        for (j=i+1;j<sh.nn;j++) {
             if (s[i]<s[j]) continue;
             SWAP(s[i],s[j]);
             for (k=0;k<n;k++) SWAP(zn[k+i*n],zn[k+j*n]);
         }
     }
-    free(S); free(dist); free(zb); free(z); free(step);
-    
-    if (c>=LOOPMAX) {
-        fprintf(stderr,"%s : search loop count overflow\n",__FILE__);
-        return -2;
+    if (ws) {
+        ws->nnode=sh.nnode;
+        ws->opt=!sh.stop;
+    }
+    if (sh.stop) {
+        trace(2,"lambda search %s: nnode=%d nsol=%d\n",
+              sh.stop==1?"node limit":"deadline",sh.nnode,sh.nn);
+        if (!ws||sh.nn<m) return -2;
     }
     return 0;
 }
-/* lambda/mlambda integer least-square estimation ------------------------------
-* integer least-square estimation. reduction is performed by lambda (ref.[1]),
-* and search by mlambda (ref.[2]).
+/* reserve lambda workspace --------------------------------------------------*/
+static double *reservelws(lambdaws_t *ws, int nd)
+{
+    if (nd>ws->nd) {
+        free(ws->d); ws->d=mat(nd,1); ws->nd=nd;
+    }
+    return ws->d;
+}
+/* free lambda workspace -------------------------------------------------------
+* free work arrays and cached Z-transform of lambda workspace
+* args   : lambdaws_t *ws   IO  lambda workspace
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freelambdaws(lambdaws_t *ws)
+{
+    free(ws->d); ws->d=NULL; ws->nd=0;
+    free(ws->zkey); ws->zkey=NULL;
+    free(ws->Zc); ws->Zc=NULL;
+    free(ws->Zic); ws->Zic=NULL;
+    ws->nz=ws->nzmax=0;
+}
+/* initial Z-transform from cache --------------------------------------------
+* set Z and Z^-1 of the cached ambiguities at their positions in key and
+* identity for the added ones. return 0 if any cached ambiguity is dropped */
+static int zcache(lambdaws_t *ws, int n, double *Z, double *Zi)
+{
+    int i,j,*pos=ws->zkey+ws->nzmax,nz=ws->nz;
+    
+    if (nz<=0||nz>n) return 0;
+    
+    for (i=0;i<nz;i++) {
+        for (j=0;j<n;j++) if (ws->key[j]==ws->zkey[i]) break;
+        if (j>=n) return 0;
+        pos[i]=j;
+    }
+    for (i=0;i<nz;i++) for (j=0;j<nz;j++) {
+        Z [pos[i]+pos[j]*n]=ws->Zc [i+j*nz];
+        Zi[pos[i]+pos[j]*n]=ws->Zic[i+j*nz];
+    }
+    return 1;
+}
+/* save Z-transform to cache -------------------------------------------------*/
+static void savezcache(lambdaws_t *ws, int n, const double *Z, const double *Zi)
+{
+    if (n>ws->nzmax) {
+        free(ws->zkey); free(ws->Zc); free(ws->Zic);
+        ws->zkey=imat(2*n,1); ws->Zc=mat(n,n); ws->Zic=mat(n,n);
+        ws->nzmax=n;
+    }
+    memcpy(ws->zkey,ws->key,sizeof(int)*n);
+    matcpy(ws->Zc,Z,n,n);
+    matcpy(ws->Zic,Zi,n,n);
+    ws->nz=n;
+}
+/* Qz=Z'*Q*Z for integer matrix Z skipping zero elements (W: work n x n) -----*/
+static void ztqz(int n, const double *Q, const double *Z, double *Qz,
+                 double *W)
+{
+    double z;
+    int i,j,k;
+    
+    for (i=0;i<n*n;i++) W[i]=Qz[i]=0.0;
+    
+    for (j=0;j<n;j++) for (k=0;k<n;k++) { /* W=Q*Z */
+        if ((z=Z[k+j*n])==0.0) continue;
+        for (i=0;i<n;i++) W[i+j*n]+=Q[i+k*n]*z;
+    }
+    for (j=0;j<n;j++) for (k=0;k<n;k++) { /* Qz=(W'*Z)'=Z'*W */
+        if ((z=Z[k+j*n])==0.0) continue;
+        for (i=j;i<n;i++) Qz[i+j*n]+=W[k+i*n]*z;
+    }
+    for (j=0;j<n;j++) for (i=j+1;i<n;i++) Qz[j+i*n]=Qz[i+j*n];
+}
+/* lambda/mlambda integer least-square estimation with workspace ---------------
+* integer least-square estimation same as lambda() with caller-owned workspace
 * args   : int    n      I  number of float parameters
 *          int    m      I  number of fixed solutions
 *          double *a     I  float parameters (n x 1) (double-diff phase biases)
 *          double *Q     I  covariance matrix of float parameters (n x n)
 *          double *F     O  fixed solutions (n x m)
 *          double *s     O  sum of squared residulas of fixed solutions (1 x m)
+*          lambdaws_t *ws IO lambda workspace (zero-initialized or previously
+*                            used)
+*            ws->maxnode  I  max number of search nodes (0:default)
+*                            (default: 10000 per thread)
+*            ws->nthread  I  number of search threads (0,1:single thread)
+*            ws->deadline I  deadline enable flag (0:off,1:on)
+*            ws->tdead    I  deadline of search (tickget() value)
+*            ws->key      I  ambiguity keys to reuse Z-transform (n x 1)
+*                            (NULL: no reuse)
+*            ws->nnode    O  number of visited search nodes
+*            ws->opt      O  search status (1:optimal,0:best-effort)
+*            ws->nwarm,nfull O number of warm-started and full reductions
 * return : status (0:ok,other:error)
-* notes  : matrix stored by column-major order (fortran convension)
+* notes  : the workspace grows on demand and is reused across calls, so no
+*          memory is allocated once it has reached the size of the largest
+*          problem. free the workspace by freelambdaws().
+*          if the search reaches the node limit or the deadline after m
+*          candidates are found, the best candidates so far are returned with
+*          status 0 and ws->opt=0. they are not guaranteed to be the integer
+*          least-square solutions, so the caller should not validate them as
+*          optimal.
+*          with ws->nthread>1, the top-level branches of the search tree are
+*          explored in parallel sharing the candidates. the results are the
+*          same as single thread except for the order of ties.
+*          with ws->key, the Z-transform is cached in ws. if the next call
+*          has all of the cached keys (same or added ambiguities), the
+*          reduction is warm-started from the cached Z-transform (identity
+*          for added ones), so that it is almost decorrelated already and
+*          only a few gauss transformations and permutations are needed.
+*          if any cached ambiguity is dropped or LD factorization of the
+*          transformed covariance fails, full reduction is performed.
+*          the integer solutions are the same as full reduction.
+*          F=Z'\E is computed by Z^-1 accumulated through the reduction, so
+*          fixed solutions are exact integers.
 *-----------------------------------------------------------------------------*/
-extern int lambda(int n, int m, const double *a, const double *Q, double *F,
-                  double *s)
+extern int lambdaws(int n, int m, const double *a, const double *Q, double *F,
+                    double *s, lambdaws_t *ws)
 {
-    int info;
-    double *L,*D,*Z,*z,*E;
+    double *L,*D,*Z,*Zi,*z,*E,*W,*W1;
+    int i,info,nt,nw,warm;
     
     if (n<=0||m<=0) return -1;
-    L=zeros(n,n); D=mat(n,1); Z=eye(n); z=mat(n,1); E=mat(n,m);
     
+    nt=ws->nthread>1?MIN(ws->nthread,MAXSRCHTH):1;
+    nw=n*(n+1)/2+nt*(n*(n+1)/2+4*n); /* work for search */
+    L=reservelws(ws,3*n*n+2*n+n*m+MAX(2*n*n,nw));
+    ws->nnode=0; ws->opt=0;
+    D=L+n*n; Z=D+n; Zi=Z+n*n; z=Zi+n*n; E=z+n; W=E+n*m; W1=W+n*n;
+    
+    for (i=0;i<n*n;i++) Z[i]=Zi[i]=0.0;
+    for (i=0;i<n;i++) Z[i+i*n]=Zi[i+i*n]=1.0;
+    
+    if ((warm=ws->key&&zcache(ws,n,Z,Zi))) {
+        
+        /* LD factorization of cached transformed covariance (Z0'*Q*Z0) */
+        ztqz(n,Q,Z,W1,W);
+        if (!(info=LD(n,W1,L,D,W))) {
+            
+            /* lambda reduction applied to Z0 and Z0^-1 in place as column
+               and row operations (Z=Z0*Zw, Zi=Zw^-1*Z0^-1) */
+            reduction(n,L,D,Z,Zi);
+            ws->nwarm++;
+        }
+        else { /* fall back to full reduction */
+            for (i=0;i<n*n;i++) Z[i]=Zi[i]=0.0;
+            for (i=0;i<n;i++) Z[i+i*n]=Zi[i+i*n]=1.0;
+            warm=0;
+        }
+    }
     /* LD (lower diaganol) factorization (Q=L'*diag(D)*L) */
-    if (!(info=LD(n,Q,L,D))) {
+    if (!warm&&!(info=LD(n,Q,L,D,W))) {
         
         /* lambda reduction (z=Z'*a, Qz=Z'*Q*Z=L'*diag(D)*L) */
-        reduction(n,L,D,Z);
+        reduction(n,L,D,Z,Zi);
+        ws->nfull++;
+    }
+    if (ws->key) {
+        if (info) ws->nz=0; else savezcache(ws,n,Z,Zi);
+    }
+    if (!info) {
         matmul("TN",n,1,n,1.0,Z,a,0.0,z); /* z=Z'*a */
         
         /* mlambda search 
             z = transformed double-diff phase biases
             L,D = transformed covariance matrix */
-        if (!(info=search(n,m,L,D,z,E,s))) {  /* returns 0 if no error */
+        if (!(info=search(n,m,L,D,z,E,s,W,ws))) {  /* returns 0 if no error */
             
-            info=solve("T",Z,E,n,m,F); /* F=Z'\E */
+            matmul("TN",n,m,n,1.0,Zi,E,0.0,F); /* F=Z'\E=Zi'*E */
         }
     }
-    free(L); free(D); free(Z); free(z); free(E);
+    return info;
+}
+/* lambda/mlambda integer least-square estimation ------------------------------
+* integer least-square estimation. reduction is performed by lambda (ref.[1]),
+* and search by mlambda (ref.[2]).
+* args   : int    n      I  number of float parameters
+*          int    m      I  number of fixed solutions
+*          double *a     I  float parameters (n x 1) (double-diff phase biases)
+*          double *Q     I  covariance matrix of float parameters (n x n)
+*          double *F     O  fixed solutions (n x m)
+*          double *s     O  sum of squared residulas of fixed solutions (1 x m)
+* return : status (0:ok,other:error)
+* notes  : matrix stored by column-major order (fortran convension)
+*-----------------------------------------------------------------------------*/
+extern int lambda(int n, int m, const double *a, const double *Q, double *F,
+                  double *s)
+{
+    lambdaws_t ws={0};
+    int info;
+    
+    info=lambdaws(n,m,a,Q,F,s,&ws);
+    if (!info&&!ws.opt) info=-2;
+    freelambdaws(&ws);
     return info;
 }
 /* lambda reduction ------------------------------------------------------------
@@ -213,25 +537,25 @@ extern int lambda(int n, int m, const double *a, const double *Q, double *F,
 *-----------------------------------------------------------------------------*/
 extern int lambda_reduction(int n, const double *Q, double *Z)
 {
-    double *L,*D;
+    double *L,*D,*W;
     int i,j,info;
     
     if (n<=0) return -1;
     
-    L=zeros(n,n); D=mat(n,1);
+    L=mat(2*n*n+n,1); D=L+n*n; W=D+n;
     
     for (i=0;i<n;i++) for (j=0;j<n;j++) {
         Z[i+j*n]=i==j?1.0:0.0;
     }
     /* LD factorization */
-    if ((info=LD(n,Q,L,D))) {
-        free(L); free(D);
+    if ((info=LD(n,Q,L,D,W))) {
+        free(L);
         return info;
     }
     /* lambda reduction */
-    reduction(n,L,D,Z);
+    reduction(n,L,D,Z,NULL);
      
-    free(L); free(D);
+    free(L);
     return 0;
 }
 /* mlambda search --------------------------------------------------------------
@@ -247,21 +571,19 @@ extern int lambda_reduction(int n, const double *Q, double *Z)
 extern int lambda_search(int n, int m, const double *a, const double *Q,
                          double *F, double *s)
 {
-    double *L,*D;
+    double *L,*D,*W;
     int info;
     
     if (n<=0||m<=0) return -1;
     
-    L=zeros(n,n); D=mat(n,1);
+    L=mat(2*n*n+6*n,1); D=L+n*n; W=D+n;
     
     /* LD factorization */
-    if ((info=LD(n,Q,L,D))) {
-        free(L); free(D);
-        return info;
+    if (!(info=LD(n,Q,L,D,W))) {
+        
+        /* mlambda search */
+        info=search(n,m,L,D,a,F,s,W,NULL);
     }
-    /* mlambda search */
-    info=search(n,m,L,D,a,F,s);
-    
-    free(L); free(D);
+    free(L);
     return info;
 }
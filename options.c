@@ -27,6 +27,11 @@
 *           2020/11/30  1.12 change options pos1-frequency, pos1-ionoopt,
 *                             pos1-tropopt, pos1-sateph, pos1-navsys,
 *                             pos2-gloarmode,
+*           2026/10/17  1.13 add file-pcachedir
+*                            add pos2-nslice,pos2-sliceovl,pos2-slicechk
+*                            add misc-obswindow
+*                            add misc-matbackend,misc-matthres,file-blaslib
+*                            add pos2-nthread
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -63,6 +68,8 @@ static char snrmask_[NFREQ][1024];
 #define POSOPT  "0:llh,1:xyz,2:single,3:posfile,4:rinexhead,5:rtcm,6:raw"
 #define TIDEOPT "0:off,1:on,2:otl"
 #define PHWOPT  "0:off,1:on,2:precise"
+#define KFUOPT  "0:standard,1:symmetric,2:joseph"
+#define MATOPT  "0:default,1:builtin,2:blocked,3:blas"
 
 EXPORT opt_t sysopts[]={
     {"pos1-posmode",    3,  (void *)&prcopt_.mode,       MODOPT },
@@ -119,6 +126,11 @@ EXPORT opt_t sysopts[]={
     {"pos2-niter",      0,  (void *)&prcopt_.niter,      ""     },
     {"pos2-baselen",    1,  (void *)&prcopt_.baseline[0],"m"    },
     {"pos2-basesig",    1,  (void *)&prcopt_.baseline[1],"m"    },
+    {"pos2-kfupdate",   3,  (void *)&prcopt_.kfopt,      KFUOPT },
+    {"pos2-nthread",    0,  (void *)&prcopt_.nthread,    "0:single"},
+    {"pos2-nslice",     0,  (void *)&prcopt_.nslice,     ""     },
+    {"pos2-sliceovl",   1,  (void *)&prcopt_.tslice,     "s"    },
+    {"pos2-slicechk",   3,  (void *)&prcopt_.slicechk,   SWTOPT },
     
     {"out-solformat",   3,  (void *)&solopt_.posf,       SOLOPT },
     {"out-outhead",     3,  (void *)&solopt_.outhead,    SWTOPT },
@@ -183,6 +195,9 @@ EXPORT opt_t sysopts[]={
     {"misc-rnxopt1",    2,  (void *)prcopt_.rnxopt[0],   ""     },
     {"misc-rnxopt2",    2,  (void *)prcopt_.rnxopt[1],   ""     },
     {"misc-pppopt",     2,  (void *)prcopt_.pppopt,      ""     },
+    {"misc-obswindow",  0,  (void *)&prcopt_.obswin,     "0:all"},
+    {"misc-matbackend", 3,  (void *)&prcopt_.matbe,      MATOPT },
+    {"misc-matthres",   0,  (void *)&prcopt_.matnth,     "0:default"},
     
     {"file-satantfile", 2,  (void *)&filopt_.satantp,    ""     },
     {"file-rcvantfile", 2,  (void *)&filopt_.rcvantp,    ""     },
@@ -196,6 +211,8 @@ EXPORT opt_t sysopts[]={
     {"file-geexefile",  2,  (void *)&filopt_.geexe,      ""     },
     {"file-solstatfile",2,  (void *)&filopt_.solstat,    ""     },
     {"file-tracefile",  2,  (void *)&filopt_.trace,      ""     },
+    {"file-pcachedir",  2,  (void *)&filopt_.pcache,     ""     },
+    {"file-blaslib",    2,  (void *)&filopt_.blaslib,    ""     },
     
     {"",0,NULL,""} /* terminator */
 };
@@ -513,6 +530,8 @@ extern void resetsysopts(void)
     filopt_.blq    [0]='\0';
     filopt_.solstat[0]='\0';
     filopt_.trace  [0]='\0';
+    filopt_.pcache [0]='\0';
+    filopt_.blaslib[0]='\0';
     for (i=0;i<2;i++) antpostype_[i]=0;
     elmask_=15.0;
     elmaskar_=0.0;
@@ -43,48 +43,31 @@
 *                            fix bug on select best solution in static mode
 *                            delete function to use L2 instead of L5 PCV
 *                            writing solution file in binary mode
+*           2026/10/17  1.25 read precise products through cache files
+*                            cache earth orientation for processing span
+*                            move session state into postpos_t for reentrancy
+*                            add api postposinit(),postposrun()
+*                            add api postposbatch()
+*                            run combined forward/backward passes concurrently
+*                            add processing by time slices with overlap
+*                            add streamed obs input
+*                            return error status of failed session
+*                            set matrix backend by processing options
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
 #define MIN(x,y)    ((x)<(y)?(x):(y))
+#define MAX(x,y)    ((x)>(y)?(x):(y))
 #define SQRT(x)     ((x)<=0.0||(x)!=(x)?0.0:sqrt(x))
 
 #define MAXPRCDAYS  100          /* max days of continuous processing */
 #define MAXINFILE   1000         /* max number of input files */
-#define MAXINVALIDTM 100         /* max number of invalid time marks */
-
-/* constants/global variables ------------------------------------------------*/
-
-static pcvs_t pcvss={0};        /* receiver antenna parameters */
-static pcvs_t pcvsr={0};        /* satellite antenna parameters */
-static obs_t obss={0};          /* observation data ֻһԪ֮µ*/
-static nav_t navs={0};          /* navigation data ļе*/
-static sbs_t sbss={0};          /* sbas messages */
-static sta_t stas[MAXRCV];      /* station infomation վϢ*/
-static int nepoch=0;            /* number of observation epochs */
-static int nitm  =0;            /* number of invalid time marks */
-static int iobsu =0;            /* current rover observation data index */
-static int iobsr =0;            /* current reference observation data index */
-static int isbs  =0;            /* current sbas message index */
-static int iitm  =0;            /* current invalid time mark index */
-static int revs  =0;            /* analysis direction (0:forward,1:backward) */
-static int aborts=0;            /* abort status */
-static sol_t *solf;             /* forward solutions */
-static sol_t *solb;             /* backward solutions */
-static double *rbf;             /* forward base positions */
-static double *rbb;             /* backward base positions */
-static int isolf=0;             /* current forward solutions index */
-static int isolb=0;             /* current backward solutions index */
-static char proc_rov [64]="";   /* rover for current processing */
-static char proc_base[64]="";   /* base station for current processing */
-static char rtcm_file[1024]=""; /* rtcm data file */
-static char rtcm_path[1024]=""; /* rtcm data path */
-static gtime_t invalidtm[MAXINVALIDTM]={{0}};/* invalid time marks */
-static rtcm_t rtcm;             /* rtcm control struct */
-static FILE *fp_rtcm=NULL;      /* rtcm data file pointer */
+#define MAXBATCHTH  64           /* max number of batch worker threads */
+#define MAXSLICE    64           /* max number of time slices */
+#define SLICETOL    1E-3         /* tolerance of slice difference to single-pass (m) */
 
 /* show message and check break ʾϢûǷֹ----------------------------------------------*/
-static int checkbrk(const char *format, ...)
+static int checkbrk(postpos_t *pp, const char *format, ...)
 {
     va_list arg;
     char buff[1024],*p=buff;
@@ -92,9 +75,9 @@ static int checkbrk(const char *format, ...)
     va_start(arg,format);
     p+=vsprintf(p,format,arg);
     va_end(arg);
-    if (*proc_rov&&*proc_base) sprintf(p," (%s-%s)",proc_rov,proc_base);
-    else if (*proc_rov ) sprintf(p," (%s)",proc_rov );
-    else if (*proc_base) sprintf(p," (%s)",proc_base);
+    if (*pp->proc_rov&&*pp->proc_base) sprintf(p," (%s-%s)",pp->proc_rov,pp->proc_base);
+    else if (*pp->proc_rov ) sprintf(p," (%s)",pp->proc_rov );
+    else if (*pp->proc_base) sprintf(p," (%s)",pp->proc_base);
     return showmsg(buff);
 }
 /* output reference position վϢ-------------------------------------------------------------*/
@@ -124,8 +107,8 @@ static void outrpos(FILE *fp, const double *r, const solopt_t *opt)
     }
 }
 /* output header ͷϢ-------------------------------------------------------------------------*/
-static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
-                      const solopt_t *sopt)
+static void outheader(FILE *fp, char **file, int n, const obs_t *obs,
+                      const prcopt_t *popt, const solopt_t *sopt)
 {
     const char *s1[]={"GPST","UTC","JST"};
     gtime_t ts,te;
@@ -148,11 +131,11 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             fprintf(fp,"%s inp file  : %s\n",COMMENTH,file[i]);
         }
-        for (i=0;i<obss.n;i++)    if (obss.data[i].rcv==1) break;
-        for (j=obss.n-1;j>=0;j--) if (obss.data[j].rcv==1) break;
+        for (i=0;i<obs->n;i++)    if (obs->data[i].rcv==1) break;
+        for (j=obs->n-1;j>=0;j--) if (obs->data[j].rcv==1) break;
         if (j<i) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
-        ts=obss.data[i].time;
-        te=obss.data[j].time;
+        ts=obs->data[i].time;
+        te=obs->data[j].time;
         t1=time2gpst(ts,&w1);
         t2=time2gpst(te,&w2);
         if (sopt->times>=1) ts=gpst2utc(ts);
@@ -201,126 +184,519 @@ static int nextobsb(const obs_t *obs, int *i, int rcv)
     }
     return n;
 }
+/* streamed obs input ----------------------------------------------------------
+* rover and reference obs data are input epoch by epoch from RINEX OBS files
+* and merged into a window of obs data in pp->obss holding prcopt_t.obswin
+* rover epochs ahead of the cursor. the files are indexed by chunks of epochs
+* in advance, so the backward pass inputs the chunks in reverse order by seek.
+* the stream positions of chunks keep the state of delayed event and cycle
+* slips, so the chunks are input as by the forward pass.
+*-----------------------------------------------------------------------------*/
+typedef struct {            /* epoch chunk of streamed obs */
+    int file;               /* file index */
+    rnxpos_t pos;           /* stream position of first epoch */
+    int n;                  /* number of epochs */
+} obschk_t;
+
+typedef struct {            /* streamed obs input of receiver */
+    int rcv;                /* receiver number */
+    rnxobs_t *rnx;          /* RINEX OBS streams of files */
+    int nf,ifile;           /* number of files, current file index (forward) */
+    obschk_t *chk;          /* epoch chunks */
+    int nc,ncmax,ichk;      /* number/allocated/current epoch chunks (backward) */
+    obs_t buf;              /* obs data of current chunk (backward) */
+    int ibuf;               /* number of obs data not input in buf (backward) */
+    obsd_t *data;           /* obs data of next epoch */
+    int n;                  /* number of obs data of next epoch (-1: end) */
+    int nep;                /* number of epochs */
+    gtime_t ts,te;          /* first/last epoch time */
+} rcvstr_t;
+
+typedef struct obsstr_tag { /* streamed obs input */
+    rcvstr_t str[2];        /* rover and reference */
+    int nwin;               /* look-ahead window (epochs) */
+    int revs;               /* direction of window (0:forward,1:backward) */
+    int ifill;              /* cursor index to fill window */
+    gtime_t time0,time1;    /* first/last time of obs data */
+    obs_t buf;              /* obs data prepended to window */
+    obs_t head;             /* first and last rover obs data */
+    obsd_t headd[2];        /* data of head */
+} obsstr_t;
+
+/* add obs data --------------------------------------------------------------*/
+static int addobs(obs_t *obs, const obsd_t *data, int n)
+{
+    obsd_t *obs_data;
+    int nmax;
+    
+    if (obs->n+n>obs->nmax) {
+        for (nmax=obs->nmax<=0?MAXOBS*2:obs->nmax;nmax<obs->n+n;) nmax*=2;
+        if (!(obs_data=(obsd_t *)realloc(obs->data,sizeof(obsd_t)*nmax))) {
+            trace(1,"addobs: malloc error n=%d\n",nmax);
+            return 0;
+        }
+        obs->data=obs_data;
+        obs->nmax=nmax;
+    }
+    memcpy(obs->data+obs->n,data,sizeof(obsd_t)*n);
+    obs->n+=n;
+    return 1;
+}
+/* sort and unique obs data of epoch by satellite ----------------------------*/
+static int cmpsat(const void *p1, const void *p2)
+{
+    return (int)((const obsd_t *)p1)->sat-(int)((const obsd_t *)p2)->sat;
+}
+static int uniqepoch(obsd_t *data, int n)
+{
+    int i,j;
+    
+    if (n<=0) return 0;
+    
+    qsort(data,n,sizeof(obsd_t),cmpsat);
+    
+    for (i=j=0;i<n;i++) {
+        if (data[i].sat!=data[j].sat) data[++j]=data[i];
+    }
+    return j+1;
+}
+/* input next epoch of streamed obs of receiver ------------------------------*/
+static int nextepoch(rcvstr_t *rs, int revs)
+{
+    const obschk_t *chk;
+    rnxpos_t pos;
+    int i,n;
+    
+    if (!revs) {
+        for (;rs->ifile<rs->nf;rs->ifile++) {
+            if ((n=input_rnxobs(rs->rnx+rs->ifile,rs->data,&pos))>=0) {
+                rs->n=uniqepoch(rs->data,n);
+                return 1;
+            }
+        }
+        rs->n=-1;
+        return 0;
+    }
+    /* input chunk by seek */
+    while (rs->ibuf<=0) {
+        if (rs->ichk<0) {
+            rs->n=-1;
+            return 0;
+        }
+        chk=rs->chk+rs->ichk--;
+        rs->buf.n=0;
+        if (!seek_rnxobs(rs->rnx+chk->file,&chk->pos)) continue;
+        
+        for (i=0;i<chk->n;i++) {
+            if ((n=input_rnxobs(rs->rnx+chk->file,rs->data,&pos))<0) break;
+            if (!addobs(&rs->buf,rs->data,uniqepoch(rs->data,n))) {
+                rs->n=-1;
+                return -1;
+            }
+        }
+        rs->ibuf=rs->buf.n;
+    }
+    i=rs->ibuf-1;
+    n=nextobsb(&rs->buf,&i,rs->rcv);
+    memcpy(rs->data,rs->buf.data+i-n+1,sizeof(obsd_t)*n);
+    rs->ibuf=i-n+1;
+    rs->n=n;
+    return 1;
+}
+/* select receiver of next epoch in order of sortobs() -----------------------*/
+static int nextrcv(const obsstr_t *os, int revs)
+{
+    double tt;
+    
+    if (os->str[0].n<0) return os->str[1].n<0?-1:1;
+    if (os->str[1].n<0) return 0;
+    
+    tt=timediff(os->str[0].data[0].time,os->str[1].data[0].time);
+    return revs?(tt>DTTOL?0:1):(tt<=DTTOL?0:1);
+}
+/* fill window of streamed obs -------------------------------------------------
+* consumed obs data are dropped from the window and epochs are input until
+* the window holds obswin rover epochs ahead of the cursor and a reference
+* epoch beyond them. the window is filled again when less than obswin/2 rover
+* epochs remain ahead of the cursor. the window is rewound to the start/end
+* of obs data if the direction is changed.
+*-----------------------------------------------------------------------------*/
+static int fillobs(postpos_t *pp, int revs)
+{
+    obsstr_t *os=pp->ostr;
+    obs_t *obs=&pp->obss;
+    obsd_t data;
+    int i,j,k,n,nu=0,ref=0,nh=MAX(os->nwin/2,1);
+    
+    if (os->revs!=revs) { /* rewind window */
+        for (i=0;i<2;i++) {
+            if (!revs) {
+                for (j=0;j<os->str[i].nf;j++) {
+                    seek_rnxobs(os->str[i].rnx+j,NULL);
+                }
+                os->str[i].ifile=0;
+            }
+            else {
+                os->str[i].ichk=os->str[i].nc-1;
+                os->str[i].ibuf=0;
+            }
+            if (nextepoch(os->str+i,revs)<0) return 0;
+        }
+        os->revs=revs;
+        obs->n=0;
+        pp->iobsu=pp->iobsr=revs?-1:0;
+    }
+    else if (!revs&&pp->iobsu<os->ifill) return 1;
+    else if ( revs&&pp->iobsu>os->ifill) return 1;
+    
+    if (!revs) {
+        /* drop obs data before cursors */
+        if ((k=MIN(pp->iobsu,pp->iobsr))>0) {
+            memmove(obs->data,obs->data+k,sizeof(obsd_t)*(obs->n-k));
+            obs->n-=k; pp->iobsu-=k; pp->iobsr-=k;
+        }
+        while ((i=nextrcv(os,0))>=0) {
+            if ((nu>=os->nwin||os->str[0].n<0)&&(ref||os->str[1].n<0)) break;
+            if (!addobs(obs,os->str[i].data,os->str[i].n)) return 0;
+            if (i==0) {nu++; ref=0;} else ref=1;
+            if (nextepoch(os->str+i,0)<0) return 0;
+        }
+        /* cursor index to fill window */
+        os->ifill=obs->n+1;
+        if (os->str[0].n>=0) {
+            for (i=obs->n-1,k=0;(n=nextobsb(obs,&i,1))>0;i-=n) {
+                if (++k>=nh) break;
+            }
+            os->ifill=n>0?i-n+1:pp->iobsu;
+        }
+        return 1;
+    }
+    /* drop obs data after cursors */
+    if ((k=MAX(pp->iobsu,pp->iobsr))<obs->n-1) obs->n=k+1;
+    
+    for (os->buf.n=0;(i=nextrcv(os,1))>=0;) {
+        if ((nu>=os->nwin||os->str[0].n<0)&&(ref||os->str[1].n<0)) break;
+        
+        /* add epoch in reverse order */
+        if (!addobs(&os->buf,os->str[i].data,os->str[i].n)) return 0;
+        for (j=os->buf.n-os->str[i].n,k=os->buf.n-1;j<k;j++,k--) {
+            data=os->buf.data[j]; os->buf.data[j]=os->buf.data[k]; os->buf.data[k]=data;
+        }
+        if (i==0) {nu++; ref=0;} else ref=1;
+        if (nextepoch(os->str+i,1)<0) return 0;
+    }
+    /* prepend epochs to window */
+    if ((n=os->buf.n)>0) {
+        for (j=0,k=n-1;j<k;j++,k--) {
+            data=os->buf.data[j]; os->buf.data[j]=os->buf.data[k]; os->buf.data[k]=data;
+        }
+        if (!addobs(obs,os->buf.data,n)) return 0;
+        memmove(obs->data+n,obs->data,sizeof(obsd_t)*(obs->n-n));
+        memcpy(obs->data,os->buf.data,sizeof(obsd_t)*n);
+        pp->iobsu+=n; pp->iobsr+=n;
+    }
+    /* cursor index to fill window */
+    os->ifill=-2;
+    if (os->str[0].n>=0) {
+        for (i=0,k=0;(n=nextobsf(obs,&i,1))>0;i+=n) {
+            if (++k>=nh) break;
+        }
+        os->ifill=n>0?i+n-1:pp->iobsu;
+    }
+    return 1;
+}
+/* index epoch chunks of streamed obs ----------------------------------------*/
+static int indexobs(obsstr_t *os)
+{
+    rcvstr_t *rs;
+    obschk_t *chk;
+    gtime_t time0={0};
+    rnxpos_t pos;
+    int i,j,n;
+    
+    for (i=0;i<2;i++) {
+        rs=os->str+i;
+        rs->nep=rs->nc=0;
+        rs->ts=rs->te=time0;
+        
+        for (j=0;j<rs->nf;j++) {
+            
+            /* exclude epochs overlapped with previous files */
+            if (rs->nep>0&&(rs->rnx[j].ts.time==0||
+                timediff(rs->rnx[j].ts,rs->te)<=DTTOL)) {
+                rs->rnx[j].ts=timeadd(rs->te,DTTOL*2.0+1E-3);
+            }
+            while ((n=input_rnxobs(rs->rnx+j,rs->data,&pos))>=0) {
+                if (rs->nc<=0||rs->chk[rs->nc-1].file!=j||
+                    rs->chk[rs->nc-1].n>=os->nwin) {
+                    if (rs->nc>=rs->ncmax) {
+                        rs->ncmax=rs->ncmax<=0?64:rs->ncmax*2;
+                        if (!(chk=(obschk_t *)realloc(rs->chk,sizeof(obschk_t)*rs->ncmax))) {
+                            return 0;
+                        }
+                        rs->chk=chk;
+                    }
+                    rs->chk[rs->nc].file=j;
+                    rs->chk[rs->nc].pos=pos;
+                    rs->chk[rs->nc++].n=0;
+                }
+                rs->chk[rs->nc-1].n++;
+                if (rs->nep++==0) rs->ts=rs->data[0].time;
+                rs->te=rs->data[0].time;
+                
+                if (i==0) {
+                    if (rs->nep==1) os->headd[0]=rs->data[0];
+                    os->headd[1]=rs->data[0];
+                }
+            }
+        }
+        trace(3,"indexobs: rcv=%d nf=%d nep=%d nc=%d\n",rs->rcv,rs->nf,rs->nep,
+              rs->nc);
+    }
+    os->head.data=os->headd;
+    os->head.n=os->str[0].nep>0?2:0;
+    
+    /* first/last time of obs data */
+    if (os->str[1].nep<=0||(os->str[0].nep>0&&
+        timediff(os->str[0].ts,os->str[1].ts)<=DTTOL)) os->time0=os->str[0].ts;
+    else os->time0=os->str[1].ts;
+    if (os->str[1].nep<=0||(os->str[0].nep>0&&
+        timediff(os->str[0].te,os->str[1].te)>=0.0)) os->time1=os->str[0].te;
+    else os->time1=os->str[1].te;
+    
+    return 1;
+}
+/* close streamed obs input --------------------------------------------------*/
+static void closeobsstr(postpos_t *pp)
+{
+    rcvstr_t *rs;
+    int i,j;
+    
+    if (!pp->ostr) return;
+    
+    for (i=0;i<2;i++) {
+        rs=pp->ostr->str+i;
+        for (j=0;j<rs->nf;j++) close_rnxobs(rs->rnx+j);
+        free(rs->rnx);
+        free(rs->chk);
+        free(rs->buf.data);
+        free(rs->data);
+    }
+    free(pp->ostr->buf.data);
+    free(pp->ostr);
+    pp->ostr=NULL;
+}
+/* open streamed obs input -----------------------------------------------------
+* open RINEX OBS files of rover and reference, read other files as readrnxt()
+* and index epochs of the OBS files. the window is filled for forward pass.
+*-----------------------------------------------------------------------------*/
+static int openobsstr(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                      char **infile, const int *index, int n,
+                      const prcopt_t *prcopt, nav_t *nav, sta_t *sta)
+{
+    obsstr_t *os;
+    rcvstr_t *rs;
+    rnxobs_t *rnx,rnx0;
+    char *files[MAXEXFILE]={0};
+    const char *opt;
+    int i,j,k,m,stat=1,ind=0,rcv=1,nobs=0;
+    
+    trace(3,"openobsstr: n=%d nwin=%d\n",n,prcopt->obswin);
+    
+    if (!(os=pp->ostr=(obsstr_t *)calloc(1,sizeof(obsstr_t)))) return 0;
+    os->nwin=prcopt->obswin;
+    os->revs=-1;
+    for (i=0;i<2;i++) {
+        os->str[i].rcv=i+1;
+        if (!(os->str[i].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) return 0;
+    }
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(files[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(files[i]);
+            return 0;
+        }
+    }
+    for (i=0;i<n&&stat;i++) {
+        if (checkbrk(pp,"")) {
+            stat=0;
+            break;
+        }
+        if (index[i]!=ind) {
+            if (nobs>0) rcv++;
+            ind=index[i]; nobs=0;
+        }
+        opt=prcopt->rnxopt[rcv<=1?0:1];
+        rs=rcv<=2?os->str+rcv-1:NULL;
+        
+        for (j=0,k=expath(infile[i],files,MAXEXFILE);j<k;j++) {
+            rnx=&rnx0;
+            if (rs) {
+                if (!(rnx=(rnxobs_t *)realloc(rs->rnx,sizeof(rnxobs_t)*(rs->nf+1)))) {
+                    stat=0;
+                    break;
+                }
+                rs->rnx=rnx;
+                rnx+=rs->nf;
+            }
+            if ((m=open_rnxobs(rnx,files[j],rcv,ts,te,ti,opt,nav,
+                               rs?sta+rcv-1:NULL))>0) {
+                nobs++;
+                if (rs) rs->nf++; else close_rnxobs(rnx);
+                continue;
+            }
+            /* read nav and other files */
+            if (!m&&readrnxt(files[j],rcv,ts,te,ti,opt,NULL,nav,NULL)<0) {
+                stat=0;
+                break;
+            }
+        }
+    }
+    for (i=0;i<MAXEXFILE;i++) free(files[i]);
+    
+    if (!stat) {
+        checkbrk(pp,"error : insufficient memory");
+        trace(1,"insufficient memory\n");
+        return 0;
+    }
+    if (!indexobs(os)) {
+        checkbrk(pp,"error : insufficient memory");
+        trace(1,"insufficient memory\n");
+        return 0;
+    }
+    pp->nepoch=os->str[0].nep;
+    
+    return fillobs(pp,0);
+}
 /* update rtcm ssr correction RTCM SSRУ------------------------------------------------------*/
-static void update_rtcm_ssr(gtime_t time)
+static void update_rtcm_ssr(postpos_t *pp, gtime_t time)
 {
     char path[1024];
     int i;
     
     /* open or swap rtcm file */
-    reppath(rtcm_file,path,time,"","");
+    reppath(pp->rtcm_file,path,time,"","");
     
-    if (strcmp(path,rtcm_path)) {
-        strcpy(rtcm_path,path);
+    if (strcmp(path,pp->rtcm_path)) {
+        strcpy(pp->rtcm_path,path);
         
-        if (fp_rtcm) fclose(fp_rtcm);
-        fp_rtcm=fopen(path,"rb");
-        if (fp_rtcm) {
-            rtcm.time=time;
-            input_rtcm3f(&rtcm,fp_rtcm);
+        if (pp->fp_rtcm) fclose(pp->fp_rtcm);
+        pp->fp_rtcm=fopen(path,"rb");
+        if (pp->fp_rtcm) {
+            pp->rtcm.time=time;
+            input_rtcm3f(&pp->rtcm,pp->fp_rtcm);
             trace(2,"rtcm file open: %s\n",path);
         }
     }
-    if (!fp_rtcm) return;
+    if (!pp->fp_rtcm) return;
     
     /* read rtcm file until current time */
-    while (timediff(rtcm.time,time)<1E-3) {
-        if (input_rtcm3f(&rtcm,fp_rtcm)<-1) break;
+    while (timediff(pp->rtcm.time,time)<1E-3) {
+        if (input_rtcm3f(&pp->rtcm,pp->fp_rtcm)<-1) break;
         
         /* update ssr corrections */
         for (i=0;i<MAXSAT;i++) {
-            if (!rtcm.ssr[i].update||
-                rtcm.ssr[i].iod[0]!=rtcm.ssr[i].iod[1]||
-                timediff(time,rtcm.ssr[i].t0[0])<-1E-3) continue;
-            navs.ssr[i]=rtcm.ssr[i];
-            rtcm.ssr[i].update=0;
+            if (!pp->rtcm.ssr[i].update||
+                pp->rtcm.ssr[i].iod[0]!=pp->rtcm.ssr[i].iod[1]||
+                timediff(time,pp->rtcm.ssr[i].t0[0])<-1E-3) continue;
+            pp->navs.ssr[i]=pp->rtcm.ssr[i];
+            pp->rtcm.ssr[i].update=0;
         }
     }
 }
 /* input obs data, navigation messages and sbas correction ۲ݡϢSBASУ------------*/
-static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
+static int inputobs(postpos_t *pp, obsd_t *obs, int solq,
+                    const prcopt_t *popt)
 {
     gtime_t time={0};
     int i = 0,nu,nr,n=0;
     double dt,dt_next;
+    char tstr[32];
     
-    trace(3,"\ninfunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",revs,iobsu,iobsr,isbs);
+    trace(3,"\ninfunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",pp->revs,pp->iobsu,pp->iobsr,pp->isbs);
     
-    if (0<=iobsu&&iobsu<obss.n) {
-        settime((time=obss.data[iobsu].time));
-        if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
-            aborts=1; showmsg("aborted"); return -1;
+    if (pp->ostr&&!fillobs(pp,pp->revs)) {
+        trace(1,"obs stream input error\n");
+        return -1;
+    }
+    
+    if (0<=pp->iobsu&&pp->iobsu<pp->obss.n) {
+        settime((time=pp->obss.data[pp->iobsu].time));
+        time2str(time,tstr,0);
+        if (checkbrk(pp,"processing : %s Q=%d",tstr,solq)) {
+            pp->aborts=1; showmsg("aborted"); return -1;
         }
     }
-    if (!revs) { /* input forward data */
-        if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
+    if (!pp->revs) { /* input forward data */
+        if ((nu=nextobsf(&pp->obss,&pp->iobsu,1))<=0) return -1;
         if (popt->intpref) {
         	/* interpolate nearest timestamps ֵʱ*/
-            for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr+=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)>-DTTOL) break;
+            for (;(nr=nextobsf(&pp->obss,&pp->iobsr,2))>0;pp->iobsr+=nr)
+                if (timediff(pp->obss.data[pp->iobsr].time,pp->obss.data[pp->iobsu].time)>-DTTOL) break;
         }
         else {
         	/* find closest timestamp */
-        	dt=timediff(obss.data[i].time,obss.data[iobsu].time);
-            for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i+=nr) {
-                dt_next=timediff(obss.data[i].time,obss.data[iobsu].time);
+        	dt=timediff(pp->ostr?pp->ostr->time0:pp->obss.data[i].time,
+        	            pp->obss.data[pp->iobsu].time);
+            for (i=pp->iobsr;(nr=nextobsf(&pp->obss,&i,2))>0;pp->iobsr=i,i+=nr) {
+                dt_next=timediff(pp->obss.data[i].time,pp->obss.data[pp->iobsu].time);
                 if (fabs(dt_next)>fabs(dt)) break;
                 dt=dt_next;
             }
         }
-        nr=nextobsf(&obss,&iobsr,2);
+        nr=nextobsf(&pp->obss,&pp->iobsr,2);
         if (nr<=0) {
-            nr=nextobsf(&obss,&iobsr,2);
+            nr=nextobsf(&pp->obss,&pp->iobsr,2);
         }
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr+i];
-        iobsu+=nu;
+        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=pp->obss.data[pp->iobsu+i];
+        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=pp->obss.data[pp->iobsr+i];
+        pp->iobsu+=nu;
         
         /* update sbas corrections */
-        while (isbs<sbss.n) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        while (pp->isbs<pp->sbss.n) {
+            time=gpst2time(pp->sbss.msgs[pp->isbs].week,pp->sbss.msgs[pp->isbs].tow);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (getbitu(pp->sbss.msgs[pp->isbs].msg,8,6)!=9) { /* except for geo nav */
+                sbsupdatecorr(pp->sbss.msgs+pp->isbs,&pp->navs);
             }
             if (timediff(time,obs[0].time)>-1.0-DTTOL) break;
-            isbs++;
+            pp->isbs++;
         }
         /* update rtcm ssr corrections */
-        if (*rtcm_file) {
-            update_rtcm_ssr(obs[0].time);
+        if (*pp->rtcm_file) {
+            update_rtcm_ssr(pp,obs[0].time);
         }
     }
     else { /* input backward data */
-        if ((nu=nextobsb(&obss,&iobsu,1))<=0) return -1;
+        if ((nu=nextobsb(&pp->obss,&pp->iobsu,1))<=0) return -1;
         if (popt->intpref) {
         	/* interpolate nearest timestamps */
-            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr-=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)<DTTOL) break;
+            for (;(nr=nextobsb(&pp->obss,&pp->iobsr,2))>0;pp->iobsr-=nr)
+                if (timediff(pp->obss.data[pp->iobsr].time,pp->obss.data[pp->iobsu].time)<DTTOL) break;
         }
         else {
         	/* find closest timestamp */
-        	dt=timediff(obss.data[i].time,obss.data[iobsu].time);
-            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i-=nr) {
-                dt_next=timediff(obss.data[i].time,obss.data[iobsu].time);
+        	dt=timediff(pp->ostr?pp->ostr->time0:pp->obss.data[i].time,
+        	            pp->obss.data[pp->iobsu].time);
+            for (i=pp->iobsr;(nr=nextobsb(&pp->obss,&i,2))>0;pp->iobsr=i,i-=nr) {
+                dt_next=timediff(pp->obss.data[i].time,pp->obss.data[pp->iobsu].time);
                 if (fabs(dt_next)>fabs(dt)) break;
                 dt=dt_next;
             }
         }
-        nr=nextobsb(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu-nu+1+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr-nr+1+i];
-        iobsu-=nu;
+        nr=nextobsb(&pp->obss,&pp->iobsr,2);
+        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=pp->obss.data[pp->iobsu-nu+1+i];
+        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=pp->obss.data[pp->iobsr-nr+1+i];
+        pp->iobsu-=nu;
         
         /* update sbas corrections */
-        while (isbs>=0) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        while (pp->isbs>=0) {
+            time=gpst2time(pp->sbss.msgs[pp->isbs].week,pp->sbss.msgs[pp->isbs].tow);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (getbitu(pp->sbss.msgs[pp->isbs].msg,8,6)!=9) { /* except for geo nav */
+                sbsupdatecorr(pp->sbss.msgs+pp->isbs,&pp->navs);
             }
             if (timediff(time,obs[0].time)<1.0+DTTOL) break;
-            isbs--;
+            pp->isbs--;
         }
     }
     return n;
@@ -397,8 +773,8 @@ static void corr_phase_bias_ssr(obsd_t *obs, int n, const nav_t *nav)
     }
 }
 /* process positioning λ---------------------------------------------------------------------*/
-static void procpos(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *sopt,
-                    rtk_t *rtk, int mode)
+static void procpos(postpos_t *pp, FILE *fp, FILE *fptm, const prcopt_t *popt,
+                    const solopt_t *sopt, rtk_t *rtk, int mode)
 {
     gtime_t time={0};
     sol_t sol={{0}},oldsol={{0}},newsol={{0}};
@@ -418,12 +794,14 @@ static void procpos(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
     }
 
     /* initialize unless running backwards on a combined run with phase reset disabled ڽλõУǷУгʼ*/
-    if (mode==0 || !revs || popt->soltype==2)
+    if (mode==0 || !pp->revs || popt->soltype==2) {
+        rtkfree(rtk);
         rtkinit(rtk,popt);/*/rtkṹʼ*/
+    }
     
-    rtcm_path[0]='\0';
+    pp->rtcm_path[0]='\0';
     
-    while ((nobs=inputobs(obs_ptr,rtk->sol.stat,popt))>=0) {/*/oļһԪǵ(ϵͳǶ)*/
+    while ((nobs=inputobs(pp,obs_ptr,rtk->sol.stat,popt))>=0) {/*/oļһԪǵ(ϵͳǶ)*/
         /*/inputobsڽȫֱobssедֲobs*/
         /* exclude satellites ų*/
         for (i=n=0;i<nobs;i++) {/*/õϵͳͷǱ޳*/
@@ -434,15 +812,15 @@ static void procpos(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
         
         /* carrier-phase bias correction زλƫ*/
         if (!strstr(popt->pppopt,"-ENA_FCB")) {
-            corr_phase_bias_ssr(obs_ptr,n,&navs);
+            corr_phase_bias_ssr(obs_ptr,n,&pp->navs);
         }
         /*/벻ͬģʽĶλ*/
-        if (!rtkpos(rtk, obs_ptr,n,&navs)) {
+        if (!rtkpos(rtk, obs_ptr,n,&pp->navs)) {
             if (rtk->sol.eventime.time != 0) {
                 if (mode == 0) {
                     outinvalidtm(fptm, sopt, rtk->sol.eventime);
-                } else if (!revs&&nitm<MAXINVALIDTM) {
-                    invalidtm[nitm++] = rtk->sol.eventime;
+                } else if (!pp->revs&&pp->nitm<MAXINVALIDTM) {
+                    pp->invalidtm[pp->nitm++] = rtk->sol.eventime;
                 }
             }
             continue;
@@ -470,23 +848,23 @@ static void procpos(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
             }
             oldsol = rtk->sol;
         }
-        else if (!revs) { /* combined-forward */
-            if (isolf >= nepoch) {
+        else if (!pp->revs) { /* combined-forward */
+            if (pp->isolf >= pp->nepoch) {
                 free(obs_ptr);
                 return;
             }
-            solf[isolf]=rtk->sol;
-            for (i=0;i<3;i++) rbf[i+isolf*3]=rtk->rb[i];
-            isolf++;
+            pp->solf[pp->isolf]=rtk->sol;
+            for (i=0;i<3;i++) pp->rbf[i+pp->isolf*3]=rtk->rb[i];
+            pp->isolf++;
         }
         else { /* combined-backward */
-            if (isolb>=nepoch) {
+            if (pp->isolb>=pp->nepoch) {
                 free(obs_ptr);
                 return;
             }
-            solb[isolb]=rtk->sol;
-            for (i=0;i<3;i++) rbb[i+isolb*3]=rtk->rb[i];
-            isolb++;
+            pp->solb[pp->isolb]=rtk->sol;
+            for (i=0;i<3;i++) pp->rbb[i+pp->isolb*3]=rtk->rb[i];
+            pp->isolb++;
         }
     }
     if (mode==0&&solstatic&&time.time!=0.0) {
@@ -521,66 +899,67 @@ static int valcomb(const sol_t *solf, const sol_t *solb)
     return 1;
 }
 /* combine forward/backward solutions and save results ǰͺ󷽽-----------------------------*/
-static void combres(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *sopt)
+static void combres(postpos_t *pp, FILE *fp, FILE *fptm, const prcopt_t *popt,
+                    const solopt_t *sopt)
 {
     gtime_t time={0};
     sol_t sols={{0}},sol={{0}},oldsol={{0}},newsol={{0}};
     double tt,Qf[9],Qb[9],Qs[9],rbs[3]={0},rb[3]={0},rr_f[3],rr_b[3],rr_s[3];
     int i,j,k,solstatic,num=0,pri[]={7,1,2,3,4,5,1,6};
     
-    trace(3,"combres : isolf=%d isolb=%d\n",isolf,isolb);
+    trace(3,"combres : isolf=%d isolb=%d\n",pp->isolf,pp->isolb);
     
     solstatic=sopt->solstatic&&
               (popt->mode==PMODE_STATIC||popt->mode==PMODE_STATIC_START||popt->mode==PMODE_PPP_STATIC);
     
-    for (i=0,j=isolb-1;i<isolf&&j>=0;i++,j--) {
-        if ((tt=timediff(solf[i].time,solb[j].time))<-DTTOL) {
-            sols=solf[i];
-            for (k=0;k<3;k++) rbs[k]=rbf[k+i*3];
+    for (i=0,j=pp->isolb-1;i<pp->isolf&&j>=0;i++,j--) {
+        if ((tt=timediff(pp->solf[i].time,pp->solb[j].time))<-DTTOL) {
+            sols=pp->solf[i];
+            for (k=0;k<3;k++) rbs[k]=pp->rbf[k+i*3];
             j++;
         }
         else if (tt>DTTOL) {
-            sols=solb[j];
-            for (k=0;k<3;k++) rbs[k]=rbb[k+j*3];
+            sols=pp->solb[j];
+            for (k=0;k<3;k++) rbs[k]=pp->rbb[k+j*3];
             i--;
         }
-        else if (pri[solf[i].stat]<pri[solb[j].stat]) {
-            sols=solf[i];
-            for (k=0;k<3;k++) rbs[k]=rbf[k+i*3];
+        else if (pri[pp->solf[i].stat]<pri[pp->solb[j].stat]) {
+            sols=pp->solf[i];
+            for (k=0;k<3;k++) rbs[k]=pp->rbf[k+i*3];
         }
-        else if (pri[solf[i].stat]>pri[solb[j].stat]) {
-            sols=solb[j];
-            for (k=0;k<3;k++) rbs[k]=rbb[k+j*3];
+        else if (pri[pp->solf[i].stat]>pri[pp->solb[j].stat]) {
+            sols=pp->solb[j];
+            for (k=0;k<3;k++) rbs[k]=pp->rbb[k+j*3];
         }
         else {
-            sols=solf[i];
+            sols=pp->solf[i];
             sols.time=timeadd(sols.time,-tt/2.0);
             
             if ((popt->mode==PMODE_KINEMA||popt->mode==PMODE_MOVEB)&&
                 sols.stat==SOLQ_FIX) {
                 
                 /* degrade fix to float if validation failed ֤ʧܣfixĽΪfloat*/
-                if (!valcomb(solf+i,solb+j)) sols.stat=SOLQ_FLOAT;
+                if (!valcomb(pp->solf+i,pp->solb+j)) sols.stat=SOLQ_FLOAT;
             }
             for (k=0;k<3;k++) {
-                Qf[k+k*3]=solf[i].qr[k];
-                Qb[k+k*3]=solb[j].qr[k];
+                Qf[k+k*3]=pp->solf[i].qr[k];
+                Qb[k+k*3]=pp->solb[j].qr[k];
             }
-            Qf[1]=Qf[3]=solf[i].qr[3];
-            Qf[5]=Qf[7]=solf[i].qr[4];
-            Qf[2]=Qf[6]=solf[i].qr[5];
-            Qb[1]=Qb[3]=solb[j].qr[3];
-            Qb[5]=Qb[7]=solb[j].qr[4];
-            Qb[2]=Qb[6]=solb[j].qr[5];
+            Qf[1]=Qf[3]=pp->solf[i].qr[3];
+            Qf[5]=Qf[7]=pp->solf[i].qr[4];
+            Qf[2]=Qf[6]=pp->solf[i].qr[5];
+            Qb[1]=Qb[3]=pp->solb[j].qr[3];
+            Qb[5]=Qb[7]=pp->solb[j].qr[4];
+            Qb[2]=Qb[6]=pp->solb[j].qr[5];
             
             if (popt->mode==PMODE_MOVEB) {
-                for (k=0;k<3;k++) rr_f[k]=solf[i].rr[k]-rbf[k+i*3];
-                for (k=0;k<3;k++) rr_b[k]=solb[j].rr[k]-rbb[k+j*3];
+                for (k=0;k<3;k++) rr_f[k]=pp->solf[i].rr[k]-pp->rbf[k+i*3];
+                for (k=0;k<3;k++) rr_b[k]=pp->solb[j].rr[k]-pp->rbb[k+j*3];
                 if (smoother(rr_f,Qf,rr_b,Qb,3,rr_s,Qs)) continue;
                 for (k=0;k<3;k++) sols.rr[k]=rbs[k]+rr_s[k];
             }
             else {
-                if (smoother(solf[i].rr,Qf,solb[j].rr,Qb,3,sols.rr,Qs)) continue;
+                if (smoother(pp->solf[i].rr,Qf,pp->solb[j].rr,Qb,3,sols.rr,Qs)) continue;
             }
             sols.qr[0]=(float)Qs[0];
             sols.qr[1]=(float)Qs[4];
@@ -592,16 +971,16 @@ static void combres(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
             /* smoother for velocity solution */
             if (popt->dynamics) {
                 for (k=0;k<3;k++) {
-                    Qf[k+k*3]=solf[i].qv[k];
-                    Qb[k+k*3]=solb[j].qv[k];
+                    Qf[k+k*3]=pp->solf[i].qv[k];
+                    Qb[k+k*3]=pp->solb[j].qv[k];
                 }
-                Qf[1]=Qf[3]=solf[i].qv[3];
-                Qf[5]=Qf[7]=solf[i].qv[4];
-                Qf[2]=Qf[6]=solf[i].qv[5];
-                Qb[1]=Qb[3]=solb[j].qv[3];
-                Qb[5]=Qb[7]=solb[j].qv[4];
-                Qb[2]=Qb[6]=solb[j].qv[5];
-                if (smoother(solf[i].rr+3,Qf,solb[j].rr+3,Qb,3,sols.rr+3,Qs)) continue;
+                Qf[1]=Qf[3]=pp->solf[i].qv[3];
+                Qf[5]=Qf[7]=pp->solf[i].qv[4];
+                Qf[2]=Qf[6]=pp->solf[i].qv[5];
+                Qb[1]=Qb[3]=pp->solb[j].qv[3];
+                Qb[5]=Qb[7]=pp->solb[j].qv[4];
+                Qb[2]=Qb[6]=pp->solb[j].qv[5];
+                if (smoother(pp->solf[i].rr+3,Qf,pp->solb[j].rr+3,Qb,3,sols.rr+3,Qs)) continue;
                 sols.qv[0]=(float)Qs[0];
                 sols.qv[1]=(float)Qs[4];
                 sols.qv[2]=(float)Qs[8];
@@ -620,10 +999,10 @@ static void combres(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
                 time=sols.time;
             }
         }
-        if (iitm < nitm && timediff(invalidtm[iitm],sols.time)<0.0)
+        if (pp->iitm < pp->nitm && timediff(pp->invalidtm[pp->iitm],sols.time)<0.0)
         {
-            outinvalidtm(fptm,sopt,invalidtm[iitm]);
-            iitm++;
+            outinvalidtm(fptm,sopt,pp->invalidtm[pp->iitm]);
+            pp->iitm++;
         }
         if (sols.eventime.time != 0)
         {
@@ -641,12 +1020,13 @@ static void combres(FILE *fp, FILE *fptm, const prcopt_t *popt, const solopt_t *
     }
 }
 /* read prec ephemeris, sbas data, tec grid and open rtcm SBAS,tec ----------------*/
-static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
+static void readpreceph(postpos_t *pp, char **infile, int n,
+                        const prcopt_t *prcopt, const filopt_t *fopt,
                         nav_t *nav, sbs_t *sbs)
 {
     seph_t seph0={0};
-    int i;
-    char *ext;
+    int i,m=0;
+    char *ext,*files[MAXINFILE];
     
     trace(2,"readpreceph: n=%d\n",n);
     
@@ -654,16 +1034,12 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     nav->nc=nav->ncmax=0;
     sbs->n =sbs->nmax =0;
     
-    /* read precise ephemeris files */
-    for (i=0;i<n;i++) {
-        if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
-        readsp3(infile[i],nav,0);
-    }
-    /* read precise clock filesӲ */
-    for (i=0;i<n;i++) {
+    /* read precise ephemeris and clock files ;Ӳ*/
+    for (i=0;i<n&&m<MAXINFILE;i++) {
         if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
-        readrnxc(infile[i],nav);
+        files[m++]=infile[i];
     }
+    readpephcache(files,m,0,fopt->pcache,nav);
     /* read sbas message files sbas*/
     for (i=0;i<n;i++) {
         if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
@@ -679,19 +1055,19 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     for (i=0;i<nav->ns;i++) nav->seph[i]=seph0;
     
     /* set rtcm file and initialize rtcm struct */
-    rtcm_file[0]=rtcm_path[0]='\0'; fp_rtcm=NULL;
+    pp->rtcm_file[0]=pp->rtcm_path[0]='\0'; pp->fp_rtcm=NULL;
     
     for (i=0;i<n;i++) {
         if ((ext=strrchr(infile[i],'.'))&&
             (!strcmp(ext,".rtcm3")||!strcmp(ext,".RTCM3"))) {
-            strcpy(rtcm_file,infile[i]);
-            init_rtcm(&rtcm);
+            strcpy(pp->rtcm_file,infile[i]);
+            init_rtcm(&pp->rtcm);
             break;
         }
     }
 }
 /* free prec ephemeris and sbas data ͷŸռռ-----------------------------------------------*/
-static void freepreceph(nav_t *nav, sbs_t *sbs)
+static void freepreceph(postpos_t *pp, nav_t *nav, sbs_t *sbs)
 {
     int i;
     
@@ -707,15 +1083,19 @@ static void freepreceph(nav_t *nav, sbs_t *sbs)
     }
     free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
     
-    if (fp_rtcm) fclose(fp_rtcm);
-    free_rtcm(&rtcm);
+    if (pp->fp_rtcm) fclose(pp->fp_rtcm);
+    free_rtcm(&pp->rtcm);
 }
 /* read obs and nav data obsnav-------------------------------------------------------------*/
-static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
-                      const int *index, int n, const prcopt_t *prcopt,
-                      obs_t *obs, nav_t *nav, sta_t *sta)
+static int readobsnav(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                      char **infile, const int *index, int n,
+                      const prcopt_t *prcopt, obs_t *obs, nav_t *nav,
+                      sta_t *sta)
  {
-    int i,j,ind=0,nobs=0,rcv=1;
+    const nav_t *navc=pp->shared?&pp->shared->navs:NULL;
+    const obs_t *hobs=obs;
+    gtime_t t0,t1;
+    int i,j,ind=0,nobs=0,rcv=1,share=0,stream;
     
     trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
     
@@ -724,10 +1104,23 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     nav->geph=NULL; nav->ng=nav->ngmax=0;
     /* free(nav->seph); */ /* is this needed to avoid memory leak??? */
     nav->seph=NULL; nav->ns=nav->nsmax=0;
-    nepoch=0;
-    
-    for (i=0;i<n;i++) {
-        if (checkbrk("")) return 0;
+    if (navc) memset(nav->eidx,0,sizeof(nav->eidx));
+    pp->nepoch=0;
+    
+    /* stream obs data unless average of single position uses all data */
+    stream=prcopt->obswin>0&&
+           !(prcopt->mode==PMODE_FIXED&&prcopt->rovpos==POSOPT_SINGLE)&&
+           !(PMODE_DGPS<=prcopt->mode&&prcopt->mode<=PMODE_FIXED&&
+             prcopt->refpos==POSOPT_SINGLE);
+    for (i=0;i<n&&stream;i++) {
+        if (!*infile[i]) stream=0;
+    }
+    if (stream) {
+        if (!openobsstr(pp,ts,te,ti,infile,index,n,prcopt,nav,sta)) return 0;
+        hobs=&pp->ostr->head;
+    }
+    for (i=0;i<n&&!stream;i++) {
+        if (checkbrk(pp,"")) return 0;
         
         if (index[i]!=ind) {
             if (obs->n>nobs) rcv++;
@@ -736,48 +1129,78 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
         /* read rinex obs and nav file ļָ봦ļ?*/
         if (readrnxt(infile[i],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],obs,nav,
                      rcv<=2?sta+rcv-1:NULL)<0) {
-            checkbrk("error : insufficient memory");
+            checkbrk(pp,"error : insufficient memory");
             trace(1,"insufficient memory\n");
             return 0;
         }
     }
     if (obs->n<=0) {
-        checkbrk("error : no obs data");
+        checkbrk(pp,"error : no obs data");
         trace(1,"\n");
         return 0;
     }
+    /* use shared ephemerides if no ephemeris in the session files */
+    if (navc&&nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
+        nav->eph =navc->eph ; nav->n =nav->nmax =navc->n ;
+        nav->geph=navc->geph; nav->ng=nav->ngmax=navc->ng;
+        nav->seph=navc->seph; nav->ns=nav->nsmax=navc->ns;
+        memcpy(nav->eidx,navc->eidx,sizeof(nav->eidx));
+        share=1;
+    }
     if (nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
-        checkbrk("error : no nav data");
+        checkbrk(pp,"error : no nav data");
         trace(1,"\n");
         return 0;
     }
     /* sort observation data ۲*/
-    nepoch=sortobs(obs);
+    if (!stream) pp->nepoch=sortobs(obs);
     
     /* delete duplicated ephemeris ɾظ */
-    uniqnav(nav);
+    if (!share) uniqnav(nav);
+    
+    /* satellite state cache shared by rover, base and single point */
+    satcacheinit(nav,DTTOLSC);
 
     /* set time span for progress display ýʾʱ */
     if (ts.time==0||te.time==0) {
-        for (i=0;   i<obs->n;i++) if (obs->data[i].rcv==1) break;
-        for (j=obs->n-1;j>=0;j--) if (obs->data[j].rcv==1) break;
+        for (i=0;   i<hobs->n;i++) if (hobs->data[i].rcv==1) break;
+        for (j=hobs->n-1;j>=0;j--) if (hobs->data[j].rcv==1) break;
         if (i<j) {
-            if (ts.time==0) ts=obs->data[i].time;
-            if (te.time==0) te=obs->data[j].time;
+            if (ts.time==0) ts=hobs->data[i].time;
+            if (te.time==0) te=hobs->data[j].time;
             settspan(ts,te);
         }
     }
+    /* earth orientation cache with precession-nutation table */
+    t0=stream?pp->ostr->time0:obs->data[0].time;
+    t1=stream?pp->ostr->time1:obs->data[obs->n-1].time;
+    eocinit(nav,DTTOLEOC);
+    eoctable(nav,timeadd(gpst2utc(t0),-TINTEOC),timeadd(gpst2utc(t1),TINTEOC),
+             TINTEOC);
     return 1;
 }
 /* free obs and nav data ͷݴ洢---------------------------------------------------------------*/
-static void freeobsnav(obs_t *obs, nav_t *nav)
+static void freeobsnav(postpos_t *pp, const nav_t *navc)
 {
+    obs_t *obs=&pp->obss;
+    nav_t *nav=&pp->navs;
+    
     trace(3,"freeobsnav:\n");
     
     free(obs->data); obs->data=NULL; obs->n =obs->nmax =0;
-    free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;
-    free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
-    free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
+    closeobsstr(pp);
+    
+    /* detach ephemerides shared with other sessions */
+    if (navc&&nav->eph==navc->eph&&nav->geph==navc->geph&&
+        nav->seph==navc->seph) {
+        nav->eph =NULL; nav->n =nav->nmax =0;
+        nav->geph=NULL; nav->ng=nav->ngmax=0;
+        nav->seph=NULL; nav->ns=nav->nsmax=0;
+        memset(nav->eidx,0,sizeof(nav->eidx));
+    }
+    freenav(nav,0x01|0x02|0x04);
+    satcachefree(nav);
+    eocfree(nav);
 }
 /* average of single position 㶨λƽֵ------------------------------------------------------*/
 static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
@@ -815,16 +1238,17 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
     return 1;
 }
 /* station position from file ļȡվλ----------------------------------------------------*/
-static int getstapos(const char *file, char *name, double *r)
+static int getstapos(const char *file, const char *name, double *r)
 {
     FILE *fp;
-    char buff[256],sname[256],*p,*q,aim[20];
+    char buff[256],sname[256],*p,aim[20];
+    const char *q;
     double pos[3];
 
     trace(3,"getstapos: file=%s name=%s\n",file,name);
     
     size_t len = strlen(file);
-    const char* lastThree = file + len - 3;
+    const char* lastThree = len >= 3 ? file + len - 3 : file;
     /*printf("ַĩβַΪ: %s\n", lastThree);*/
     if (strstr(lastThree, "snx"))
     {
@@ -912,7 +1336,7 @@ static int antpos(prcopt_t *opt, int rcvno, const obs_t *obs, const nav_t *nav,
 {
     double *rr=rcvno==1?opt->ru:opt->rb,del[3],pos[3],dr[3]={0};
     int i,postype=rcvno==1?opt->rovpos:opt->refpos;
-    char *name;
+    const char *name;
     
     trace(3,"antpos  : rcvno=%d\n",rcvno);
     
@@ -923,53 +1347,59 @@ static int antpos(prcopt_t *opt, int rcvno, const obs_t *obs, const nav_t *nav,
         }
     }
     else if (postype==POSOPT_FILE) { /* read from position file */
-        name=stas[rcvno==1?0:1].name;
+        name=sta[rcvno==1?0:1].name;
         if (!getstapos(posfile,name,rr)) {
             showmsg("error : no position of %s in %s",name,posfile);
             return 0;
         }
     }
     else if (postype==POSOPT_RINEX) { /* get from rinex header */
-        if (norm(stas[rcvno==1?0:1].pos,3)<=0.0) {
+        if (norm(sta[rcvno==1?0:1].pos,3)<=0.0) {
             showmsg("error : no position in rinex header");
             trace(1,"no position in rinex header\n");
             return 0;
         }
         /* add antenna delta unless already done in antpcv() */
         if (!strcmp(opt->anttype[rcvno],"*")) {
-            if (stas[rcvno==1?0:1].deltype==0) { /* enu */
-                for (i=0;i<3;i++) del[i]=stas[rcvno==1?0:1].del[i];
-                del[2]+=stas[rcvno==1?0:1].hgt;
-                ecef2pos(stas[rcvno==1?0:1].pos,pos);
+            if (sta[rcvno==1?0:1].deltype==0) { /* enu */
+                for (i=0;i<3;i++) del[i]=sta[rcvno==1?0:1].del[i];
+                del[2]+=sta[rcvno==1?0:1].hgt;
+                ecef2pos(sta[rcvno==1?0:1].pos,pos);
                 enu2ecef(pos,del,dr);
             }  else { /* xyz */
-                for (i=0;i<3;i++) dr[i]=stas[rcvno==1?0:1].del[i];
+                for (i=0;i<3;i++) dr[i]=sta[rcvno==1?0:1].del[i];
             }
         }
-        for (i=0;i<3;i++) rr[i]=stas[rcvno==1?0:1].pos[i]+dr[i];
+        for (i=0;i<3;i++) rr[i]=sta[rcvno==1?0:1].pos[i]+dr[i];
     }
     return 1;
 }
 /* open procssing session 򿪴Ự--------------------------------------------------------------*/
 static int openses(const prcopt_t *popt, const solopt_t *sopt,
-                   const filopt_t *fopt, nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
+                   const filopt_t *fopt, nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr,
+                   int global)
 {
     trace(3,"openses :\n");
     
     /* read satellite antenna parameters ȡ߲*/
-    if (*fopt->satantp&&!(readpcv(fopt->satantp,pcvs))) {
+    if (*fopt->satantp&&!(readpcvcache(fopt->satantp,fopt->pcache,pcvs))) {
         showmsg("error : no sat ant pcv in %s",fopt->satantp);
         trace(1,"sat antenna pcv read error: %s\n",fopt->satantp);
         return 0;
     }
     /* read receiver antenna parameters */
-    if (*fopt->rcvantp&&!(readpcv(fopt->rcvantp,pcvr))) {
+    if (*fopt->rcvantp&&!(readpcvcache(fopt->rcvantp,fopt->pcache,pcvr))) {
         showmsg("error : no rec ant pcv in %s",fopt->rcvantp);
         trace(1,"rec antenna pcv read error: %s\n",fopt->rcvantp);
         return 0;
     }
+    /* set matrix backend */
+    if (global&&!setmatbackend(popt->matbe,popt->matnth,fopt->blaslib)) {
+        showmsg("error : matrix backend %d %s",popt->matbe,fopt->blaslib);
+        trace(2,"matrix backend error: %d %s\n",popt->matbe,fopt->blaslib);
+    }
     /* open geoid data ȡˮ׼λ*/
-    if (sopt->geoid>0&&*fopt->geoid) {
+    if (global&&sopt->geoid>0&&*fopt->geoid) {
         if (!opengeoid(sopt->geoid,fopt->geoid)) {
             showmsg("error : no geoid data %s",fopt->geoid);
             trace(2,"no geoid data %s\n",fopt->geoid);
@@ -978,20 +1408,22 @@ static int openses(const prcopt_t *popt, const solopt_t *sopt,
     return 1;
 }
 /* close procssing session رմỰ-----------------------------------------------------------*/
-static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
+static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr, int global)
 {
     trace(3,"closeses:\n");
     
     /* free antenna parameters */
-    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
-    free(pcvr->pcv); pcvr->pcv=NULL; pcvr->n=pcvr->nmax=0;
-    
-    /* close geoid data */
-    closegeoid();
+    freepcv(pcvs);
+    freepcv(pcvr);
     
     /* free erp data */
     free(nav->erp.data); nav->erp.data=NULL; nav->erp.n=nav->erp.nmax=0;
     
+    if (!global) return;
+    
+    /* close geoid data */
+    closegeoid();
+    
     /* close solution statistics and debug trace */
     rtkclosestat();
     traceclose();
@@ -1028,7 +1460,7 @@ static void setpcv(gtime_t time, prcopt_t *popt, nav_t *nav, const pcvs_t *pcvs,
                 }
             }
             else { /* enu */
-                for (j=0;j<3;j++) popt->antdel[i][j]=stas[i].del[j];
+                for (j=0;j<3;j++) popt->antdel[i][j]=sta[i].del[j];
             }
         }
         if (!(pcv=searchpcv(0,popt->anttype[i],time,pcvr))) {
@@ -1051,7 +1483,7 @@ static void readotl(prcopt_t *popt, const char *file, const sta_t *sta)
 }
 /* write header to output file ļдͷϢ---------------------------------------------*/
 static int outhead(const char *outfile, char **infile, int n,
-                   const prcopt_t *popt, const solopt_t *sopt)
+                   const obs_t *obs, const prcopt_t *popt, const solopt_t *sopt)
 {
     FILE *fp=stdout;
     
@@ -1066,7 +1498,7 @@ static int outhead(const char *outfile, char **infile, int n,
         }
     }
     /* output header */
-    outheader(fp,infile,n,popt,sopt);
+    outheader(fp,infile,n,obs,popt,sopt);
     
     if (*outfile) fclose(fp);
     
@@ -1096,24 +1528,447 @@ static void namefiletm(char *outfiletm, const char *outfile)
     strncpy(outfiletm, outfile, i);
     strcat(outfiletm, "_events.pos");
 }
+/* processing pass on a copy of context --------------------------------------*/
+typedef struct {
+    postpos_t *pp;          /* post-processing context of pass */
+    const prcopt_t *popt;   /* processing options */
+    const solopt_t *sopt;   /* solution options */
+    rtk_t *rtk;             /* rtk control of pass */
+    thread_t thread;        /* thread handle */
+} pass_t;
+
+#ifdef WIN32
+static DWORD WINAPI passthread(void *arg)
+#else
+static void *passthread(void *arg)
+#endif
+{
+    pass_t *ps=(pass_t *)arg;
+    
+    procpos(ps->pp,NULL,NULL,ps->popt,ps->sopt,ps->rtk,1);
+    return 0;
+}
+/* test if passes can share obs and nav data ---------------------------------
+* nav data is updated along the pass by sbas or ssr messages, streamed obs
+* data are input by the pass, and process-wide solution status is not
+* reentrant
+*-----------------------------------------------------------------------------*/
+static int sharepass(const postpos_t *pp, const solopt_t *sopt)
+{
+    return pp->sbss.n<=0&&!pp->ostr&&!*pp->rtcm_file&&
+           !(pp->global&&sopt->sstat>0);
+}
+/* new pass sharing obs and nav data with own cursors, rtk control and
+* satellite state cache (glonass orbit states shared) -----------------------*/
+static int newpass(pass_t *ps, const postpos_t *pp, const prcopt_t *popt,
+                   const solopt_t *sopt)
+{
+    if (!(ps->pp=(postpos_t *)malloc(sizeof(postpos_t)))) return 0;
+    if (!(ps->rtk=(rtk_t *)malloc(sizeof(rtk_t)))) {
+        free(ps->pp);
+        return 0;
+    }
+    *ps->pp=*pp;
+    memset(ps->rtk,0,sizeof(rtk_t));
+    ps->pp->navs.sc=NULL;
+    satcacheshare(&ps->pp->navs,&pp->navs);
+    ps->popt=popt;
+    ps->sopt=sopt;
+    return 1;
+}
+static void freepass(pass_t *ps)
+{
+    rtkfree(ps->rtk);
+    satcachefree(&ps->pp->navs);
+    free(ps->rtk);
+    free(ps->pp);
+}
+/* start/join pass thread ----------------------------------------------------*/
+static int startpass(pass_t *ps)
+{
+#ifdef WIN32
+    return (ps->thread=CreateThread(NULL,0,passthread,ps,0,NULL))!=NULL;
+#else
+    return !pthread_create(&ps->thread,NULL,passthread,ps);
+#endif
+}
+static void joinpass(pass_t *ps)
+{
+#ifdef WIN32
+    WaitForSingleObject(ps->thread,INFINITE);
+    CloseHandle(ps->thread);
+#else
+    pthread_join(ps->thread,NULL);
+#endif
+}
+/* process combined forward/backward passes concurrently ---------------------
+* the backward pass runs in a thread with a copy of the context sharing obs and
+* nav data, with own cursors, rtk control and satellite state cache. results
+* are same as the sequential passes as both passes initialize rtk control.
+* return 0 without processing if nav data is updated along the passes by sbas
+* or ssr messages, or process-wide solution status is output.
+*-----------------------------------------------------------------------------*/
+static int proccomb(postpos_t *pp, const prcopt_t *popt, const solopt_t *sopt,
+                    rtk_t *rtk)
+{
+    pass_t pb;
+    int th;
+    
+    trace(3,"proccomb:\n");
+    
+    if (!sharepass(pp,sopt)||!newpass(&pb,pp,popt,sopt)) return 0;
+    
+    pb.pp->revs=1;
+    pb.pp->iobsu=pb.pp->iobsr=pp->obss.n-1;
+    pb.pp->isbs=pp->sbss.n-1;
+    
+    th=startpass(&pb);
+    
+    procpos(pp,NULL,NULL,popt,sopt,rtk,1); /* forward */
+    
+    if (th) joinpass(&pb);
+    else procpos(pb.pp,NULL,NULL,popt,sopt,pb.rtk,1); /* backward */
+    
+    pp->isolb=pb.pp->isolb;
+    if (pb.pp->aborts) pp->aborts=1;
+    
+    freepass(&pb);
+    return 1;
+}
+/* time slice ----------------------------------------------------------------*/
+typedef struct {
+    pass_t ps;              /* forward pass of slice */
+    gtime_t ts,te;          /* retained span of slice [ts,te) */
+    int th;                 /* pass thread started (0:no,1:yes) */
+    int join;               /* fix at join (0:ok,1:disagreed,2:unfixed) */
+} slice_t;
+
+/* set up forward pass of time slice on obs data [ts-tslice,te) --------------*/
+static int newslice(slice_t *sl, const postpos_t *pp, const prcopt_t *popt,
+                    const solopt_t *sopt, gtime_t ts,
+                    gtime_t te, int last)
+{
+    postpos_t *ps;
+    gtime_t t0=timeadd(ts,-popt->tslice);
+    int i,j,k,n,i0,i1;
+    
+    sl->ts=ts; sl->te=te; sl->th=sl->join=0;
+    
+    if (!newpass(&sl->ps,pp,popt,sopt)) return 0;
+    ps=sl->ps.pp;
+    
+    for (i0=0;i0<pp->obss.n;i0++) {
+        if (timediff(pp->obss.data[i0].time,t0)>-DTTOL) break;
+    }
+    for (i1=i0;i1<pp->obss.n&&!last;i1++) {
+        if (timediff(pp->obss.data[i1].time,te)>-DTTOL) break;
+    }
+    if (last) i1=pp->obss.n;
+    
+    /* extend to reference epochs enclosing the span */
+    j=i0-1;
+    if ((n=nextobsb(&pp->obss,&j,2))>0) i0=j-n+1;
+    j=i1;
+    if ((n=nextobsf(&pp->obss,&j,2))>0) i1=j+n;
+    
+    ps->obss.data=pp->obss.data+i0;
+    ps->obss.n=ps->obss.nmax=i1-i0;
+    for (i=k=0;(n=nextobsf(&ps->obss,&i,1))>0;i+=n) k++;
+    
+    ps->nepoch=k;
+    ps->iobsu=ps->iobsr=ps->isbs=ps->revs=ps->aborts=0;
+    ps->isolf=ps->nitm=0;
+    ps->solb=NULL; ps->rbb=NULL;
+    ps->solf=(sol_t *)malloc(sizeof(sol_t)*(k>0?k:1));
+    ps->rbf=(double *)malloc(sizeof(double)*(k>0?k:1)*3);
+    if (!ps->solf||!ps->rbf) {
+        free(ps->solf); free(ps->rbf);
+        freepass(&sl->ps);
+        return 0;
+    }
+    return 1;
+}
+static void freeslice(slice_t *sl)
+{
+    free(sl->ps.pp->solf);
+    free(sl->ps.pp->rbf);
+    freepass(&sl->ps);
+}
+/* stitch slice solutions to forward solutions -------------------------------
+* solutions in the warm-up overlap are discarded. if the fixed solution of the
+* slice at the join disagrees with the fixed solution of the previous slice,
+* the join is marked as disagreed and traced. the solution status is not
+* changed, as only the fixed coordinates are kept in the slice solutions.
+*-----------------------------------------------------------------------------*/
+static void stitchslice(postpos_t *pp, slice_t *sl, int k, int nsl)
+{
+    const postpos_t *ps=sl->ps.pp;
+    const sol_t *solp=pp->isolf>0?pp->solf+pp->isolf-1:NULL;
+    int i,j;
+    
+    for (i=0;i<ps->isolf;i++) {
+        if (k>0&&timediff(ps->solf[i].time,sl->ts)<-DTTOL) {
+            
+            /* check fix status at join */
+            if (!solp||fabs(timediff(ps->solf[i].time,solp->time))>DTTOL||
+                solp->stat!=SOLQ_FIX) continue;
+            if (ps->solf[i].stat!=SOLQ_FIX) {
+                sl->join=2;
+            }
+            else if (!valcomb(solp,ps->solf+i)) {
+                sl->join=1;
+            }
+            else sl->join=0;
+            continue;
+        }
+        if (k<nsl-1&&timediff(ps->solf[i].time,sl->te)>-DTTOL) break;
+        if (pp->isolf>=pp->nepoch) break;
+        
+        pp->solf[pp->isolf]=ps->solf[i];
+        for (j=0;j<3;j++) pp->rbf[j+pp->isolf*3]=ps->rbf[j+i*3];
+        pp->isolf++;
+    }
+    for (i=0;i<ps->nitm&&pp->nitm<MAXINVALIDTM;i++) {
+        if ((k>0&&timediff(ps->invalidtm[i],sl->ts)<-DTTOL)||
+            (k<nsl-1&&timediff(ps->invalidtm[i],sl->te)>-DTTOL)) continue;
+        pp->invalidtm[pp->nitm++]=ps->invalidtm[i];
+    }
+    if (ps->aborts) pp->aborts=1;
+    
+    if (sl->join) {
+        trace(2,"slice %d: %s at join\n",k,sl->join==1?"fix disagreed":"unfixed");
+    }
+}
+/* output stitched solutions -------------------------------------------------
+* solutions are output relative to the base position rbs as procpos() does for
+* a forward pass
+*-----------------------------------------------------------------------------*/
+static void outslice(postpos_t *pp, FILE *fp, FILE *fptm, const prcopt_t *popt,
+                     const solopt_t *sopt, const double *rbs)
+{
+    gtime_t time={0};
+    sol_t sol,oldsol,newsol;
+    double rb[3]={0};
+    int i,k,solstatic,pri[]={6,1,2,3,4,5,1,6};
+    
+    memset(&sol,0,sizeof(sol_t));
+    memset(&oldsol,0,sizeof(sol_t));
+    memset(&newsol,0,sizeof(sol_t));
+    
+    solstatic=sopt->solstatic&&
+              (popt->mode==PMODE_STATIC||popt->mode==PMODE_STATIC_START||popt->mode==PMODE_PPP_STATIC);
+    
+    for (i=0;i<pp->isolf;i++) {
+        while (pp->iitm<pp->nitm&&
+               timediff(pp->invalidtm[pp->iitm],pp->solf[i].time)<0.0) {
+            outinvalidtm(fptm,sopt,pp->invalidtm[pp->iitm++]);
+        }
+        if (!solstatic) {
+            outsol(fp,pp->solf+i,rbs,sopt);
+        }
+        else if (time.time==0||pri[pp->solf[i].stat]<=pri[sol.stat]) {
+            sol=pp->solf[i];
+            for (k=0;k<3;k++) rb[k]=pp->rbf[k+i*3];
+            if (time.time==0||timediff(pp->solf[i].time,time)<0.0) {
+                time=pp->solf[i].time;
+            }
+        }
+        if (pp->solf[i].eventime.time!=0) {
+            newsol=fillsoltm(oldsol,pp->solf[i],pp->solf[i].eventime);
+            if (!solstatic) outsol(fptm,&newsol,rb,sopt);
+        }
+        oldsol=pp->solf[i];
+    }
+    for (;pp->iitm<pp->nitm;pp->iitm++) {
+        outinvalidtm(fptm,sopt,pp->invalidtm[pp->iitm]);
+    }
+    if (solstatic&&time.time!=0.0) {
+        sol.time=time;
+        outsol(fp,&sol,rb,sopt);
+    }
+}
+/* report differences of stitched solutions to single-pass solutions --------*/
+static void chkslice(const postpos_t *pp, const postpos_t *pr,
+                     const slice_t *sl, int nsl, const prcopt_t *popt,
+                     const char *outfile)
+{
+    FILE *fp=NULL;
+    gtime_t tmax;
+    double dr[3],d,dmax,sum,tset,tt;
+    int i,j,k,n,nstat;
+    char file[1024],ts[32],te[32],tm[32];
+    
+    if (*outfile) {
+        sprintf(file,"%.1017s.slice",outfile);
+        if (!(fp=fopen(file,"w"))) {
+            trace(1,"slice report open error: %s\n",file);
+        }
+    }
+    if (fp) {
+        fprintf(fp,"%% time slices: n=%d overlap=%.1fs tol=%.4fm\n",nsl,
+                popt->tslice,SLICETOL);
+        fprintf(fp,"%% %3s %-19s %-19s %6s %6s %9s %9s %-19s %9s %s\n","no",
+                "start","end","nepoch","nstat","maxdr(m)","rmsdr(m)",
+                "time of maxdr","tsettle(s)","join");
+    }
+    for (k=i=j=0;k<nsl;k++) {
+        tmax=sl[k].ts;
+        dmax=sum=tset=0.0;
+        n=nstat=0;
+        
+        for (;i<pp->isolf;i++) {
+            if (k<nsl-1&&timediff(pp->solf[i].time,sl[k].te)>-DTTOL) break;
+            
+            for (;j<pr->isolf;j++) {
+                if (timediff(pr->solf[j].time,pp->solf[i].time)>-DTTOL) break;
+            }
+            if (j>=pr->isolf||
+                fabs(timediff(pr->solf[j].time,pp->solf[i].time))>DTTOL) continue;
+            
+            dr[0]=pp->solf[i].rr[0]-pr->solf[j].rr[0];
+            dr[1]=pp->solf[i].rr[1]-pr->solf[j].rr[1];
+            dr[2]=pp->solf[i].rr[2]-pr->solf[j].rr[2];
+            d=norm(dr,3);
+            if (pp->solf[i].stat!=pr->solf[j].stat) nstat++;
+            if (d>dmax) {
+                dmax=d;
+                tmax=pp->solf[i].time;
+            }
+            if (d>SLICETOL&&(tt=timediff(pp->solf[i].time,sl[k].ts))>tset) {
+                tset=tt;
+            }
+            sum+=d*d;
+            n++;
+        }
+        time2str(sl[k].ts,ts,0);
+        time2str(sl[k].te,te,0);
+        time2str(tmax,tm,0);
+        trace(2,"slice %d: %s-%s n=%d nstat=%d maxdr=%.4f rmsdr=%.4f tset=%.1f join=%d\n",
+              k,ts,te,n,nstat,dmax,n>0?sqrt(sum/n):0.0,tset,sl[k].join);
+        
+        if (!fp) continue;
+        fprintf(fp,"  %3d %s %s %6d %6d %9.4f %9.4f %s %9.1f %d\n",k,ts,te,n,
+                nstat,dmax,n>0?sqrt(sum/n):0.0,tm,tset,sl[k].join);
+    }
+    if (fp) fclose(fp);
+}
+/* process forward solutions by time slices ----------------------------------
+* the processing span is split into popt->nslice slices processed concurrently
+* by forward passes, each started popt->tslice seconds ahead of the slice for
+* convergence of the filter. the stitched solutions are written to output. if
+* popt->slicechk is set, a single forward pass is processed concurrently and
+* the differences are reported to outfile.slice. return 0 without processing
+* if slices are off, the solutions of single or dgps mode have no filter state
+* to converge, or passes cannot share nav data (see sharepass()).
+*-----------------------------------------------------------------------------*/
+static int procslice(postpos_t *pp, FILE *fp, FILE *fptm, const prcopt_t *popt,
+                     const solopt_t *sopt, rtk_t *rtk, const char *outfile)
+{
+    slice_t *sl;
+    pass_t pr;
+    gtime_t ts,te;
+    double tspan,rbs[3];
+    int i,k,n,nsl=MIN(popt->nslice,MAXSLICE),chk=0,th=0;
+    
+    trace(3,"procslice: nslice=%d tslice=%.1f\n",popt->nslice,popt->tslice);
+    
+    if (nsl<=1||pp->nepoch<=0||popt->mode==PMODE_SINGLE||
+        popt->mode==PMODE_DGPS||!sharepass(pp,sopt)) return 0;
+    
+    /* span of rover epochs */
+    for (i=0;i<pp->obss.n;i++) if (pp->obss.data[i].rcv==1) break;
+    if (i>=pp->obss.n) return 0;
+    ts=pp->obss.data[i].time;
+    for (i=pp->obss.n-1;i>=0;i--) if (pp->obss.data[i].rcv==1) break;
+    te=pp->obss.data[i].time;
+    if ((tspan=timediff(te,ts))<=0.0) return 0;
+    
+    if (!(sl=(slice_t *)malloc(sizeof(slice_t)*nsl))) return 0;
+    pp->solf=(sol_t *)malloc(sizeof(sol_t)*pp->nepoch);
+    pp->rbf=(double *)malloc(sizeof(double)*pp->nepoch*3);
+    if (!pp->solf||!pp->rbf) {
+        free(pp->solf); free(pp->rbf); free(sl);
+        return 0;
+    }
+    for (n=0;n<nsl;n++) {
+        if (!newslice(sl+n,pp,popt,sopt,timeadd(ts,tspan*n/nsl),
+                      timeadd(ts,tspan*(n+1)/nsl),n==nsl-1)) break;
+    }
+    if (n<nsl) {
+        for (k=0;k<n;k++) freeslice(sl+k);
+        free(pp->solf); free(pp->rbf); free(sl);
+        return 0;
+    }
+    for (i=0;i<3;i++) rbs[i]=rtk->rb[i];
+    rtkfree(rtk);
+    rtkinit(rtk,popt); /* rtk control of session not used by slices */
+    
+    /* single forward pass for check */
+    if (popt->slicechk&&newpass(&pr,pp,popt,sopt)) {
+        pr.pp->solf=pr.pp->solb=NULL;
+        pr.pp->rbf=pr.pp->rbb=NULL;
+        pr.pp->solf=(sol_t *)malloc(sizeof(sol_t)*pp->nepoch);
+        pr.pp->rbf=(double *)malloc(sizeof(double)*pp->nepoch*3);
+        pr.pp->iobsu=pr.pp->iobsr=pr.pp->isbs=pr.pp->revs=pr.pp->aborts=0;
+        pr.pp->isolf=pr.pp->nitm=0;
+        if (pr.pp->solf&&pr.pp->rbf) {
+            chk=1;
+            th=startpass(&pr);
+        }
+        else {
+            free(pr.pp->solf); free(pr.pp->rbf);
+            freepass(&pr);
+        }
+    }
+    for (k=0;k<nsl;k++) sl[k].th=startpass(&sl[k].ps);
+    
+    for (k=0;k<nsl;k++) {
+        if (sl[k].th) joinpass(&sl[k].ps);
+        else procpos(sl[k].ps.pp,NULL,NULL,popt,sopt,sl[k].ps.rtk,1);
+    }
+    pp->isolf=pp->nitm=pp->iitm=0;
+    for (k=0;k<nsl;k++) stitchslice(pp,sl+k,k,nsl);
+    
+    if (!pp->aborts) outslice(pp,fp,fptm,popt,sopt,rbs);
+    
+    if (chk) {
+        if (th) joinpass(&pr);
+        else procpos(pr.pp,NULL,NULL,popt,sopt,pr.rtk,1);
+        if (!pp->aborts&&!pr.pp->aborts) chkslice(pp,pr.pp,sl,nsl,popt,outfile);
+        free(pr.pp->solf); free(pr.pp->rbf);
+        freepass(&pr);
+    }
+    for (k=0;k<nsl;k++) freeslice(sl+k);
+    free(pp->solf); free(pp->rbf); free(sl);
+    pp->solf=NULL; pp->rbf=NULL;
+    return 1;
+}
 /* execute processing session ִдỰ      ------------------------------------------------*/
-static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                   const solopt_t *sopt, const filopt_t *fopt, int flag,
-                   char **infile, const int *index, int n, char *outfile)
+static int execses(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                   const prcopt_t *popt, const solopt_t *sopt,
+                   const filopt_t *fopt, int flag, char **infile,
+                   const int *index, int n, char *outfile)
 {
     FILE *fp,*fptm;
     rtk_t *rtk_ptr = (rtk_t *)malloc(sizeof(rtk_t)); /* moved from stack to heap to avoid stack overflow warning */
+    const nav_t *navc=pp->shared?&pp->shared->navs:NULL;
+    const pcvs_t *pcvs=pp->shared?&pp->shared->pcvss:&pp->pcvss;
+    const pcvs_t *pcvr=pp->shared?&pp->shared->pcvsr:&pp->pcvsr;
     prcopt_t popt_=*popt;
     solopt_t tmsopt = *sopt;
     char tracefile[1024],statfile[1024],path[1024],*ext,outfiletm[1024]={0};
+    char stapos[1024];
     int i,j,k;
     /*filopt_t fopt = *fopt;*/
 
     
     trace(3,"execses : n=%d outfile=%s\n",n,outfile);
     
+    if (!rtk_ptr) return -1;
+    memset(rtk_ptr,0,sizeof(rtk_t));
+    
     /* open debug trace 򿪵׷ٹ*/
-    if (flag&&sopt->trace>0) {
+    if (flag&&pp->global&&sopt->trace>0) {
         if (*outfile) {
             strcpy(tracefile,outfile);
             strcat(tracefile,".trace");
@@ -1126,67 +1981,68 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         tracelevel(sopt->trace);
     }
     /* read ionosphere data file ȡļ*/
-    if (*fopt->iono&&(ext=strrchr(fopt->iono,'.'))) {
+    if (!navc&&*fopt->iono&&(ext=strrchr(fopt->iono,'.'))) {
         if (strlen(ext)==4&&(ext[3]=='i'||ext[3]=='I')) {
             reppath(fopt->iono,path,ts,"","");
-            readtec(path,&navs,1);
+            readtec(path,&pp->navs,1);
         }
     }
     /* read erp data ȡתEarth Rotation Parametersļ*/
-    if (*fopt->eop) {
-        free(navs.erp.data); navs.erp.data=NULL; navs.erp.n=navs.erp.nmax=0;
+    if (!navc&&*fopt->eop) {
+        free(pp->navs.erp.data); pp->navs.erp.data=NULL; pp->navs.erp.n=pp->navs.erp.nmax=0;
         reppath(fopt->eop,path,ts,"","");
-        if (!readerp(path,&navs.erp)) {
+        if (!readerp(path,&pp->navs.erp)) {
             showmsg("error : no erp data %s",path);
             trace(2,"no erp data %s\n",path);
         }
     }
     /* read obs and nav data ȡobsnav oļobss,nļnavs*/
-    if (!readobsnav(ts,te,ti,infile,index,n,&popt_,&obss,&navs,stas)) {
+    if (!readobsnav(pp,ts,te,ti,infile,index,n,&popt_,&pp->obss,&pp->navs,
+                    pp->stas)) {
         /* free obs and nav data */
-        freeobsnav(&obss, &navs);
+        freeobsnav(pp,navc);
         free(rtk_ptr);
-        return 0;
+        return -1;
     }
     
     /* read dcb parameters ȡƫDifferential Code Bias*/
     if (*fopt->dcb) {
         reppath(fopt->dcb,path,ts,"","");
-        readdcb(path,&navs,stas);
+        readdcbcache(path,fopt->pcache,&pp->navs,pp->stas);
     } else {
         for (i=0;i<3;i++) {
-            for (j=0;j<MAXSAT;j++) navs.cbias[j][i]=0;
-            for (j=0;j<MAXRCV;j++) for (k=0;k<2;k++) navs.rbias[j][k][i]=0;
+            for (j=0;j<MAXSAT;j++) pp->navs.cbias[j][i]=0;
+            for (j=0;j<MAXRCV;j++) for (k=0;k<2;k++) pp->navs.rbias[j][k][i]=0;
         }
     }
     /* set antenna parameters ߲*/
     if (popt_.mode!=PMODE_SINGLE) {
-        setpcv(obss.n>0?obss.data[0].time:timeget(),&popt_,&navs,&pcvss,&pcvsr,
-               stas);
+        setpcv(pp->obss.n>0?pp->obss.data[0].time:timeget(),&popt_,&pp->navs,pcvs,pcvr,
+               pp->stas);
     }
     /* read ocean tide loading parameters ȡϫز*/
     if (popt_.mode>PMODE_SINGLE&&*fopt->blq) {
-        readotl(&popt_,fopt->blq,stas);
+        readotl(&popt_,fopt->blq,pp->stas);
     }
     /* rover/reference fixed position վ/οվĹ̶λ*/
     /*/ fopt->stapos վλļ· */
     if (popt_.mode==PMODE_FIXED) {
-        if (!antpos(&popt_,1,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+        if (!antpos(&popt_,1,&pp->obss,&pp->navs,pp->stas,fopt->stapos)) {
+            freeobsnav(pp,navc);
             free(rtk_ptr);
-            return 0;
+            return -1;
         }
-        if (!antpos(&popt_,2,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+        if (!antpos(&popt_,2,&pp->obss,&pp->navs,pp->stas,fopt->stapos)) {
+            freeobsnav(pp,navc);
             free(rtk_ptr);
-            return 0;
+            return -1;
         }
     }
     else if (PMODE_DGPS<=popt_.mode&&popt_.mode<=PMODE_STATIC_START) {
-        if (!antpos(&popt_,2,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+        if (!antpos(&popt_,2,&pp->obss,&pp->navs,pp->stas,fopt->stapos)) {
+            freeobsnav(pp,navc);
             free(rtk_ptr);
-            return 0;
+            return -1;
         }
     }
 
@@ -1195,14 +2051,15 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         char name[5]="\0";
         int i;
         for (i = 0; i < 4; i++) {
-            name[i] = toupper(stas[0].name[i]);
+            name[i] = toupper(pp->stas[0].name[i]);
         }
         name[i] = '\0';
         if (!getstapos(fopt->stapos, name, rtk_ptr->rb))
         {
             int startPos = strlen(fopt->stapos) - 11;
-            strncpy(&fopt->stapos[startPos], "true_crd.true_crd", 17);
-            if (!getstapos(fopt->stapos, name, rtk_ptr->rb)) {
+            strcpy(stapos, fopt->stapos);
+            if (startPos>=0) strcpy(&stapos[startPos], "true_crd.true_crd");
+            if (!getstapos(stapos, name, rtk_ptr->rb)) {
                 trace(1, "all no station position: %s\n", name);
             }
 
@@ -1210,77 +2067,82 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     }
 
     /* open solution statistics 򿪴ͳ*/
-    if (flag&&sopt->sstat>0) {
+    if (flag&&pp->global&&sopt->sstat>0) {
         strcpy(statfile,outfile);
         strcat(statfile,".stat");
         rtkclosestat();
         rtkopenstat(statfile,sopt->sstat);
     }
     /* write header to output file ļдͷϢ*/
-    if (flag&&!outhead(outfile,infile,n,&popt_,sopt)) {
-        freeobsnav(&obss,&navs);
+    if (flag&&!outhead(outfile,infile,n,pp->ostr?&pp->ostr->head:&pp->obss,
+                       &popt_,sopt)) {
+        freeobsnav(pp,navc);
         free(rtk_ptr);
-        return 0;
+        return -1;
     }
     /* name time events file ʱ¼ļ*/
     /*namefiletm(outfiletm, outfile);*/
     /* write header to file with time marks ڴʱǵļд*/
     /*outhead(outfiletm, infile, n, &popt_, &tmsopt);*/
 
-    iobsu=iobsr=isbs=revs=aborts=0;
+    pp->iobsu=pp->iobsr=pp->isbs=pp->revs=pp->aborts=0;
     /*/ѭе㶨λ*/
     if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
         if ((fp=openfile(outfile)) && (fptm=openfile(outfiletm))) {
-            procpos(fp,fptm,&popt_,sopt,rtk_ptr,0); /* forward ǰ*/
+            if (!procslice(pp,fp,fptm,&popt_,sopt,rtk_ptr,outfile)) {
+                procpos(pp,fp,fptm,&popt_,sopt,rtk_ptr,0); /* forward ǰ*/
+            }
             fclose(fp);
             fclose(fptm);
         }
     }
     else if (popt_.soltype==1) {
         if ((fp=openfile(outfile)) && (fptm=openfile(outfiletm))) {
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1;
-            procpos(fp,fptm,&popt_,sopt,rtk_ptr,0); /* backward */
+            pp->revs=1; pp->iobsu=pp->iobsr=pp->obss.n-1; pp->isbs=pp->sbss.n-1;
+            procpos(pp,fp,fptm,&popt_,sopt,rtk_ptr,0); /* backward */
             fclose(fp);
             fclose(fptm);
         }
     }
     else { /* combined */
-        solf=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        solb=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        rbf=(double *)malloc(sizeof(double)*nepoch*3);
-        rbb=(double *)malloc(sizeof(double)*nepoch*3);
+        pp->solf=(sol_t *)malloc(sizeof(sol_t)*pp->nepoch);
+        pp->solb=(sol_t *)malloc(sizeof(sol_t)*pp->nepoch);
+        pp->rbf=(double *)malloc(sizeof(double)*pp->nepoch*3);
+        pp->rbb=(double *)malloc(sizeof(double)*pp->nepoch*3);
         
-        if (solf&&solb) {
-            isolf=isolb=0;
-            procpos(NULL,NULL,&popt_,sopt,rtk_ptr,1); /* forwardǰ */
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1;
-            procpos(NULL,NULL,&popt_,sopt,rtk_ptr,1); /* backward */
+        if (pp->solf&&pp->solb) {
+            pp->isolf=pp->isolb=0;
+            if (!proccomb(pp,&popt_,sopt,rtk_ptr)) {
+                procpos(pp,NULL,NULL,&popt_,sopt,rtk_ptr,1); /* forwardǰ */
+                pp->revs=1; pp->iobsu=pp->iobsr=pp->obss.n-1; pp->isbs=pp->sbss.n-1;
+                procpos(pp,NULL,NULL,&popt_,sopt,rtk_ptr,1); /* backward */
+            }
             
             /* combine forward/backward solutions ϲ/*/
-            if (!aborts&&(fp=openfile(outfile))  && (fptm=openfile(outfiletm))) {
-                combres(fp,fptm,&popt_,sopt);
+            if (!pp->aborts&&(fp=openfile(outfile))  && (fptm=openfile(outfiletm))) {
+                combres(pp,fp,fptm,&popt_,sopt);
                 fclose(fp);
                 fclose(fptm);
             }
         }
         else showmsg("error : memory allocation");
-        free(solf);
-        free(solb);
-        free(rbf);
-        free(rbb);
+        free(pp->solf);
+        free(pp->solb);
+        free(pp->rbf);
+        free(pp->rbb);
     }
     /* free rtk, obs and nav data ͷ*/
     rtkfree(rtk_ptr);
     free(rtk_ptr);
-    freeobsnav(&obss,&navs);
+    freeobsnav(pp,navc);
     
-    return aborts?1:0;
+    return pp->aborts?1:0;
 }
 /* execute processing session for each rover ΪÿվִдỰ---------------------------------*/
-static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
-                     const char *rov)
+static int execses_r(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                     const prcopt_t *popt, const solopt_t *sopt,
+                     const filopt_t *fopt, int flag, char **infile,
+                     const int *index, int n, char *outfile, const char *rov)
 {
     gtime_t t0={0};
     int i,stat=0;
@@ -1304,9 +2166,9 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
             if ((q=strchr(p,' '))) *q='\0';
             
             if (*p) {
-                strcpy(proc_rov,p);
+                strcpy(pp->proc_rov,p);
                 if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
+                if (checkbrk(pp,"reading    : %s",s)) {
                     stat=1;
                     break;
                 }
@@ -1314,7 +2176,7 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
                 reppath(outfile,ofile,t0,p,"");
                 
                 /* execute processing session */
-                stat=execses(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile);
+                stat=execses(pp,ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile);
             }
             if (stat==1||!q) break;
         }
@@ -1322,15 +2184,16 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     }
     else {
         /* execute processing session վ*/
-        stat=execses(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile);
+        stat=execses(pp,ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile);
     }
     return stat;
 }
 /* execute processing session for each base station ѭÿ׼վִлỰ--------------------------*/
-static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
-                     const char *rov, const char *base)
+static int execses_b(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                     const prcopt_t *popt, const solopt_t *sopt,
+                     const filopt_t *fopt, int flag, char **infile,
+                     const int *index, int n, char *outfile, const char *rov,
+                     const char *base)
 {
     gtime_t t0={0};
     int i,stat=0;
@@ -1339,13 +2202,13 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     trace(3,"execses_b: n=%d outfile=%s\n",n,outfile);
     
     /* read prec ephemeris and sbas data ȡSBAS  ȡSP3pclknavs*/
-    readpreceph(infile,n,popt,&navs,&sbss);
+    readpreceph(pp,infile,n,popt,fopt,&pp->navs,&pp->sbss);
     
     for (i=0;i<n;i++) if (strstr(infile[i],"%b")) break;
     
     if (i<n) { /* include base station keywords   ׼վ */
         if (!(base_=(char *)malloc(strlen(base)+1))) {
-            freepreceph(&navs,&sbss);
+            freepreceph(pp,&pp->navs,&pp->sbss);
             return 0;
         }
         strcpy(base_,base);
@@ -1353,7 +2216,7 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             if (!(ifile[i]=(char *)malloc(1024))) {
                 free(base_); for (;i>=0;i--) free(ifile[i]);
-                freepreceph(&navs,&sbss);
+                freepreceph(pp,&pp->navs,&pp->sbss);
                 return 0;
             }
         }
@@ -1361,16 +2224,17 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
             if ((q=strchr(p,' '))) *q='\0';
             
             if (*p) {
-                strcpy(proc_base,p);
+                strcpy(pp->proc_base,p);
                 if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
+                if (checkbrk(pp,"reading    : %s",s)) {
                     stat=1;
                     break;
                 }
                 for (i=0;i<n;i++) reppath(infile[i],ifile[i],t0,"",p);
                 reppath(outfile,ofile,t0,"",p);
                 
-                stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile,rov);
+                stat=execses_r(pp,ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile,
+                               rov);
             }
             if (stat==1||!q) break;
         }
@@ -1378,93 +2242,62 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     }
     else {
         /*/վ*/
-        stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,rov);
+        stat=execses_r(pp,ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,
+                         rov);
     }
     /* free prec ephemeris and sbas data */
-    freepreceph(&navs,&sbss);
+    freepreceph(pp,&pp->navs,&pp->sbss);
     
     return stat;
 }
-/* post-processing positioning λ -------------------------------------------------
-* post-processing positioning
-* args   : gtime_t ts       I   processing start time (ts.time==0: no limit)  : gtime_t ts I ʼʱ (ts.time==0: ) 
-*        : gtime_t te       I   processing end time   (te.time==0: no limit)      gtime_t te I ʱ (te.time==0: ) *
-*          double ti        I   processing interval  (s) (0:all) (s) (0:ȫ) 
-*          double tu        I   processing unit time (s) (0:all)Ԫʱ (s) (0:ȫ) 
-*          prcopt_t *popt   I   processing options  ѡ
-*          solopt_t *sopt   I   solution options    ѡ
-*          filopt_t *fopt   I   file options        ļѡ
-*          char   **infile  I   input files (see below) ļ(·˵)
-*          int    n         I   number of input files   ļ
-*          char   *outfile  I   output file ("":stdout, see below)  ļ
-*          char   *rov      I   rover id list        (separated by " ") վ
-*          char   *base     I   base station id list (separated by " ") ׼վ
-* return : status (0:ok,0>:error,1:aborted)  ֵ:״̬ (0:ɹ,0>:,1:ֹ)
-* notes  : input files should contain observation data, navigation data, precise 
-*          ephemeris/clock (optional), sbas log file (optional), ssr message
-*          log file (optional) and tec grid file (optional). only the first 
-*          observation data file in the input files is recognized as the rover
-*          data.
-* ע : ļӦ۲, , /Ӳ (ѡ), sbas־ļ (ѡ), 
-         ssr־ļ (ѡ) tecļ (ѡ). ļбеĵһ۲ļ 
-*        ʶΪվݡ 
-*
-*          the type of an input file is recognized by the file extension as ]
-*          follows:
-*              .sp3,.SP3,.eph*,.EPH*: precise ephemeris (sp3c)
-*              .sbs,.SBS,.ems,.EMS  : sbas message log files (rtklib or ems)
-*              .rtcm3,.RTCM3        : ssr message log files (rtcm3)
-*              .*i,.*I              : tec grid files (ionex)
-*              others               : rinex obs, nav, gnav, hnav, qnav or clock
-*         ļչʶļ: * .sp3,.SP3,.eph,.EPH:  (sp3c) 
-*           .sbs,.SBS,.ems,.EMS : sbasϢ־ļ (rtklibems) 
-*           .rtcm3,.RTCM3 : ssr־ļ (rtcm3) 
-*           .i,.I : tecļ (ionex) 
-              : rinex۲, ļ, gnavļ, hnavļ, qnavļӲļ 
-*
-*          inputs files can include wild-cards (*). if an file includes
-*          wild-cards, the wild-card expanded multiple files are used.
-*           ļ԰ͨ (). ļͨ, ʹͨչɶļ
-*
-*          inputs files can include keywords. if an file includes keywords,
-*          the keywords are replaced by date, time, rover id and base station
-*          id and multiple session analyses run. refer reppath() for the
-*          keywords.
-*           ļ԰ؼ. ļؼ, ؼֻ, ʱ, վźͻ׼վŽ滻, жỰ.
-*           ؼֵ滻οreppath()
-*          the output file can also include keywords. if the output file does
-*          not include keywords. the results of all multiple session analyses
-*          are output to a single output file.
-*          ļҲ԰ؼ. ļؼ, ỰĽһһļС
-*          ssr corrections are valid only for forward estimation.
-*          ssrֻǰЧ
+/* initialize post-processing context ------------------------------------------
+* initialize post-processing context
+* args   : postpos_t *pp    O   post-processing context
+*          int    global    I   use process-wide resources (0:no,1:yes)
+* return : none
+* notes  : process-wide resources are debug trace, solution status file and
+*          geoid data. a context with global=0 does not touch them, so that
+*          several contexts can run postposrun() concurrently in one process.
+*          the context is not freed by postposrun() and can be reused.
 *-----------------------------------------------------------------------------*/
-/*/ºλ*/
-extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
-                   const prcopt_t *popt, const solopt_t *sopt,
-                   const filopt_t *fopt, char **infile, int n, char *outfile,
-                   const char *rov, const char *base)
+extern void postposinit(postpos_t *pp, int global)
+{
+    memset(pp,0,sizeof(postpos_t));
+    pp->global=global;
+}
+/* post-processing positioning with context ------------------------------------
+* post-processing positioning with post-processing context
+* args   : postpos_t *pp    IO  post-processing context (see postposinit())
+*          others               same as postpos()
+* return : status (0:ok,0>:error,1:aborted)
+*-----------------------------------------------------------------------------*/
+extern int postposrun(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                      double tu, const prcopt_t *popt, const solopt_t *sopt,
+                      const filopt_t *fopt, char **infile, int n,
+                      char *outfile, const char *rov, const char *base)
 {
     gtime_t tts,tte,ttte;
     double tunit,tss;
     int i,j,k,nf,stat=0,week,flag=1,index[MAXINFILE]={0};
-    char *ifile[MAXINFILE],ofile[1024],*ext;
+    char *ifile[MAXINFILE],ofile[1024],*ext,tstr[32];
     
-    trace(3,"postpos : ti=%.0f tu=%.0f n=%d outfile=%s\n",ti,tu,n,outfile);
+    trace(3,"postposrun: ti=%.0f tu=%.0f n=%d outfile=%s\n",ti,tu,n,outfile);
     
     /* open processing session */
-    if (!openses(popt,sopt,fopt,&navs,&pcvss,&pcvsr)) return -1;
+    if (!openses(popt,sopt,fopt,&pp->navs,&pp->pcvss,&pp->pcvsr,pp->global)) {
+        return -1;
+    }
     
     if (ts.time!=0&&te.time!=0&&tu>=0.0) {
         if (timediff(te,ts)<0.0) {
             showmsg("error : no period");
-            closeses(&navs,&pcvss,&pcvsr);
+            closeses(&pp->navs,&pp->pcvss,&pp->pcvsr,pp->global);
             return 0;
         }
         for (i=0;i<MAXINFILE;i++) {
             if (!(ifile[i]=(char *)malloc(1024))) {
                 for (;i>=0;i--) free(ifile[i]);
-                closeses(&navs,&pcvss,&pcvsr);
+                closeses(&pp->navs,&pp->pcvss,&pp->pcvsr,pp->global);
                 return -1;
             }
         }
@@ -1480,9 +2313,10 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
             if (timediff(tts,ts)<0.0) tts=ts;
             if (timediff(tte,te)>0.0) tte=te;
             
-            strcpy(proc_rov ,"");
-            strcpy(proc_base,"");
-            if (checkbrk("reading    : %s",time_str(tts,0))) {
+            strcpy(pp->proc_rov ,"");
+            strcpy(pp->proc_base,"");
+            time2str(tts,tstr,0);
+            if (checkbrk(pp,"reading    : %s",tstr)) {
                 stat=1;
                 break;
             }
@@ -1515,8 +2349,8 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
             if (!reppath(outfile,ofile,tts,"","")&&i>0) flag=0;
             
             /* execute processing session */
-            stat=execses_b(tts,tte,ti,popt,sopt,fopt,flag,ifile,index,nf,ofile,
-                           rov,base);
+            stat=execses_b(pp,tts,tte,ti,popt,sopt,fopt,flag,ifile,index,nf,
+                           ofile,rov,base);
             
             if (stat==1) break;
         }
@@ -1534,7 +2368,7 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         reppath(outfile,ofile,ts,"","");
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
+        stat=execses_b(pp,ts,te,ti,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
                        base);
         
         for (i=0;i<n&&i<MAXINFILE;i++) free(ifile[i]);
@@ -1543,11 +2377,387 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         for (i=0;i<n;i++) index[i]=i;
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,infile,index,n,outfile,rov,
-                       base);
+        stat=execses_b(pp,ts,te,ti,popt,sopt,fopt,1,infile,index,n,outfile,
+                       rov,base);
     }
     /* close processing session */
-    closeses(&navs,&pcvss,&pcvsr);
+    closeses(&pp->navs,&pp->pcvss,&pp->pcvsr,pp->global);
+    
+    return stat;
+}
+/* post-processing positioning λ -------------------------------------------------
+* post-processing positioning
+* args   : gtime_t ts       I   processing start time (ts.time==0: no limit)  : gtime_t ts I ʼʱ (ts.time==0: ) 
+*        : gtime_t te       I   processing end time   (te.time==0: no limit)      gtime_t te I ʱ (te.time==0: ) *
+*          double ti        I   processing interval  (s) (0:all) (s) (0:ȫ) 
+*          double tu        I   processing unit time (s) (0:all)Ԫʱ (s) (0:ȫ) 
+*          prcopt_t *popt   I   processing options  ѡ
+*          solopt_t *sopt   I   solution options    ѡ
+*          filopt_t *fopt   I   file options        ļѡ
+*          char   **infile  I   input files (see below) ļ(·˵)
+*          int    n         I   number of input files   ļ
+*          char   *outfile  I   output file ("":stdout, see below)  ļ
+*          char   *rov      I   rover id list        (separated by " ") վ
+*          char   *base     I   base station id list (separated by " ") ׼վ
+* return : status (0:ok,0>:error,1:aborted)  ֵ:״̬ (0:ɹ,0>:,1:ֹ)
+* notes  : input files should contain observation data, navigation data, precise 
+*          ephemeris/clock (optional), sbas log file (optional), ssr message
+*          log file (optional) and tec grid file (optional). only the first 
+*          observation data file in the input files is recognized as the rover
+*          data.
+* ע : ļӦ۲, , /Ӳ (ѡ), sbas־ļ (ѡ), 
+         ssr־ļ (ѡ) tecļ (ѡ). ļбеĵһ۲ļ 
+*        ʶΪվݡ 
+*
+*          the type of an input file is recognized by the file extension as ]
+*          follows:
+*              .sp3,.SP3,.eph*,.EPH*: precise ephemeris (sp3c)
+*              .sbs,.SBS,.ems,.EMS  : sbas message log files (rtklib or ems)
+*              .rtcm3,.RTCM3        : ssr message log files (rtcm3)
+*              .*i,.*I              : tec grid files (ionex)
+*              others               : rinex obs, nav, gnav, hnav, qnav or clock
+*         ļչʶļ: * .sp3,.SP3,.eph,.EPH:  (sp3c) 
+*           .sbs,.SBS,.ems,.EMS : sbasϢ־ļ (rtklibems) 
+*           .rtcm3,.RTCM3 : ssr־ļ (rtcm3) 
+*           .i,.I : tecļ (ionex) 
+              : rinex۲, ļ, gnavļ, hnavļ, qnavļӲļ 
+*
+*          inputs files can include wild-cards (*). if an file includes
+*          wild-cards, the wild-card expanded multiple files are used.
+*           ļ԰ͨ (). ļͨ, ʹͨչɶļ
+*
+*          inputs files can include keywords. if an file includes keywords,
+*          the keywords are replaced by date, time, rover id and base station
+*          id and multiple session analyses run. refer reppath() for the
+*          keywords.
+*           ļ԰ؼ. ļؼ, ؼֻ, ʱ, վźͻ׼վŽ滻, жỰ.
+*           ؼֵ滻οreppath()
+*          the output file can also include keywords. if the output file does
+*          not include keywords. the results of all multiple session analyses
+*          are output to a single output file.
+*          ļҲ԰ؼ. ļؼ, ỰĽһһļС
+*          ssr corrections are valid only for forward estimation.
+*          ssrֻǰЧ
+*-----------------------------------------------------------------------------*/
+extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
+                   const prcopt_t *popt, const solopt_t *sopt,
+                   const filopt_t *fopt, char **infile, int n, char *outfile,
+                   const char *rov, const char *base)
+{
+    postpos_t *pp;
+    int stat;
+    
+    trace(3,"postpos : ti=%.0f tu=%.0f n=%d outfile=%s\n",ti,tu,n,outfile);
+    
+    if (!(pp=(postpos_t *)malloc(sizeof(postpos_t)))) {
+        showmsg("error : memory allocation");
+        return -1;
+    }
+    postposinit(pp,1);
+    
+    stat=postposrun(pp,ts,te,ti,tu,popt,sopt,fopt,infile,n,outfile,rov,base);
+    
+    free(pp);
+    return stat;
+}
+/* read products shared by batch jobs ----------------------------------------*/
+static int readshared(postpos_t *pp, gtime_t ts, gtime_t te,
+                      const prcopt_t *popt, const filopt_t *fopt,
+                      char **infile, int n)
+{
+    gtime_t tte;
+    char *ifile[MAXINFILE],path[1024],*ext;
+    int i,nf=0,stat=1;
+    
+    trace(3,"readshared: n=%d\n",n);
+    
+    for (i=0;i<MAXINFILE;i++) {
+        if (!(ifile[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(ifile[i]);
+            return 0;
+        }
+    }
+    /* expand input files without rover/base keywords */
+    for (i=0;i<n&&nf<MAXINFILE;i++) {
+        if (strstr(infile[i],"%r")||strstr(infile[i],"%b")) continue;
+        
+        ext=strrchr(infile[i],'.');
+        
+        if (ts.time==0||(ext&&(!strcmp(ext,".rtcm3")||!strcmp(ext,".RTCM3")))) {
+            strcpy(ifile[nf++],infile[i]);
+        }
+        else if (te.time==0) {
+            reppath(infile[i],ifile[nf++],ts,"","");
+        }
+        else {
+            /* include next day precise ephemeris or rinex brdc nav */
+            tte=te;
+            if (ext&&(!strcmp(ext,".sp3")||!strcmp(ext,".SP3")||
+                      !strcmp(ext,".eph")||!strcmp(ext,".EPH"))) {
+                tte=timeadd(tte,3600.0);
+            }
+            else if (strstr(infile[i],"brdc")) {
+                tte=timeadd(tte,7200.0);
+            }
+            nf+=reppaths(infile[i],ifile+nf,MAXINFILE-nf,ts,tte,"","");
+        }
+    }
+    /* read ionosphere data file */
+    if (*fopt->iono&&(ext=strrchr(fopt->iono,'.'))) {
+        if (strlen(ext)==4&&(ext[3]=='i'||ext[3]=='I')) {
+            reppath(fopt->iono,path,ts,"","");
+            readtec(path,&pp->navs,1);
+        }
+    }
+    /* read erp data */
+    if (*fopt->eop) {
+        reppath(fopt->eop,path,ts,"","");
+        if (!readerp(path,&pp->navs.erp)) {
+            showmsg("error : no erp data %s",path);
+            trace(2,"no erp data %s\n",path);
+        }
+    }
+    /* read prec ephemeris, sbas data and set rtcm file */
+    readpreceph(pp,ifile,nf,popt,fopt,&pp->navs,&pp->sbss);
     
+    /* read rinex nav data (sbas ephemeris replaced as readobsnav()) */
+    free(pp->navs.seph); pp->navs.seph=NULL; pp->navs.ns=pp->navs.nsmax=0;
+    
+    for (i=0;i<nf;i++) {
+        if (checkbrk(pp,"")) {
+            stat=0;
+            break;
+        }
+        if (readrnxt(ifile[i],1,ts,te,0.0,popt->rnxopt[0],NULL,&pp->navs,
+                     NULL)<0) {
+            checkbrk(pp,"error : insufficient memory");
+            trace(1,"insufficient memory\n");
+            stat=0;
+            break;
+        }
+    }
+    if (stat&&pp->navs.n<=0&&pp->navs.ng<=0&&pp->navs.ns<=0) {
+        checkbrk(pp,"error : no nav data");
+        trace(1,"no nav data\n");
+        stat=0;
+    }
+    /* delete duplicated ephemeris */
+    if (stat) uniqnav(&pp->navs);
+    
+    for (i=0;i<MAXINFILE;i++) free(ifile[i]);
     return stat;
 }
+/* execute batch job ---------------------------------------------------------*/
+static int execjob(postpos_t *pp, const postpos_t *ppc, const ppjob_t *job,
+                   const solopt_t *sopt, const filopt_t *fopt, char **infile,
+                   int n)
+{
+    char *ifile[MAXINFILE],ofile[1024];
+    int i,nf=0,stat,index[MAXINFILE]={0};
+    
+    trace(3,"execjob : rov=%s base=%s\n",job->rov,job->base);
+    
+    postposinit(pp,0);
+    pp->shared=ppc;
+    
+    /* shallow copy of shared products (caches are set by session) */
+    pp->navs=ppc->navs;
+    pp->navs.sc=NULL;
+    pp->navs.eoc=NULL;
+    pp->sbss=ppc->sbss;
+    
+    strcpy(pp->proc_rov ,job->rov );
+    strcpy(pp->proc_base,job->base);
+    
+    if (*ppc->rtcm_file) {
+        strcpy(pp->rtcm_file,ppc->rtcm_file);
+        init_rtcm(&pp->rtcm);
+    }
+    /* input files with rover/base keywords */
+    for (i=0;i<n&&nf<MAXINFILE;i++) {
+        if (!strstr(infile[i],"%r")&&!strstr(infile[i],"%b")) continue;
+        if (!(ifile[nf]=(char *)malloc(1024))) break;
+        reppath(infile[i],ifile[nf],job->ts,job->rov,job->base);
+        index[nf++]=i;
+    }
+    reppath(job->outfile,ofile,job->ts,job->rov,job->base);
+    
+    /* execute processing session */
+    stat=nf>0&&i>=n?execses(pp,job->ts,job->te,job->ti,&job->popt,sopt,fopt,
+                           1,ifile,index,nf,ofile):-1;
+    
+    if (pp->fp_rtcm) fclose(pp->fp_rtcm);
+    free_rtcm(&pp->rtcm);
+    for (i=0;i<nf;i++) free(ifile[i]);
+    
+    return stat;
+}
+/* batch processing state shared by worker threads ---------------------------*/
+typedef struct {
+    ppjob_t *job;           /* jobs */
+    int njob;               /* number of jobs */
+    int ijob;               /* index of next job */
+    int ndone;              /* number of finished jobs */
+    int stop;               /* stop flag (1:aborted) */
+    const postpos_t *ppc;   /* context holding shared products */
+    const solopt_t *sopt;   /* solution options */
+    const filopt_t *fopt;   /* file options */
+    char **infile;          /* input files */
+    int n;                  /* number of input files */
+    int nthread;            /* number of worker threads */
+    lock_t lock;            /* lock flag (nthread>1) */
+} batch_t;
+
+typedef struct {            /* batch worker thread */
+    batch_t *bt;            /* shared batch state */
+    postpos_t *pp;          /* post-processing context of worker */
+    thread_t thread;        /* thread handle */
+} batchth_t;
+
+/* run batch jobs until no job left ------------------------------------------*/
+static void batchjobs(batchth_t *th)
+{
+    batch_t *bt=th->bt;
+    ppjob_t *job;
+    
+    for (;;) {
+        if (bt->nthread>1) lock(&bt->lock);
+        job=!bt->stop&&bt->ijob<bt->njob?bt->job+bt->ijob++:NULL;
+        if (bt->nthread>1) unlock(&bt->lock);
+        if (!job) break;
+        
+        job->stat=execjob(th->pp,bt->ppc,job,bt->sopt,bt->fopt,bt->infile,
+                          bt->n);
+        
+        if (bt->nthread>1) lock(&bt->lock);
+        if (job->stat==1) bt->stop=1;
+        bt->ndone++;
+        showmsg("batch : %d/%d done (%s-%s stat=%d)",bt->ndone,bt->njob,
+                job->rov,job->base,job->stat);
+        trace(2,"batch : %d/%d done rov=%s base=%s stat=%d\n",bt->ndone,
+              bt->njob,job->rov,job->base,job->stat);
+        if (bt->nthread>1) unlock(&bt->lock);
+    }
+}
+/* batch worker thread -------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI batchthread(void *arg)
+#else
+static void *batchthread(void *arg)
+#endif
+{
+    batchjobs((batchth_t *)arg);
+    return 0;
+}
+/* post-processing positioning of batch jobs -----------------------------------
+* post-processing positioning of multiple rover/base jobs by worker threads
+* args   : ppjob_t *job     IO  batch jobs (job->stat: output)
+*          int    njob      I   number of jobs
+*          int    nthread   I   number of worker threads (<=1: no thread)
+*          prcopt_t *popt   I   processing options to read shared products
+*          solopt_t *sopt   I   solution options
+*          filopt_t *fopt   I   file options
+*          char   **infile  I   input files (see below)
+*          int    n         I   number of input files
+* return : number of failed or not processed jobs (-1: error)
+* notes  : input files including keywords %r or %b are rover/base files of
+*          each job. the keywords are replaced by job->rov, job->base and time
+*          keywords by job->ts. other input files (nav, precise ephemeris/clock,
+*          sbas and ssr) are shared products expanded over the span of all jobs
+*          and read once with antenna parameters, tec grid and erp data.
+*          debug trace is output to fopt->trace for all jobs and solution
+*          statistics are not output, as they are process-wide.
+*          aborting one job stops scheduling the rest (job->stat=2).
+*          sbas corrections are updated in the copy of nav data of each job.
+*-----------------------------------------------------------------------------*/
+extern int postposbatch(ppjob_t *job, int njob, int nthread,
+                        const prcopt_t *popt, const solopt_t *sopt,
+                        const filopt_t *fopt, char **infile, int n)
+{
+    batch_t bt={0};
+    batchth_t th[MAXBATCHTH];
+    postpos_t *ppc;
+    gtime_t ts={0},te={0};
+    int i,nt,nerr=0;
+    
+    trace(3,"postposbatch: njob=%d nthread=%d n=%d\n",njob,nthread,n);
+    
+    if (njob<=0) return 0;
+    
+    nt=nthread>1?MIN(MIN(nthread,MAXBATCHTH),njob):1;
+    
+    /* span of all jobs to expand shared products (0:no limit) */
+    for (i=0;i<njob;i++) {
+        job[i].stat=2;
+        if (i==0||(ts.time&&(job[i].ts.time==0||timediff(job[i].ts,ts)<0.0))) {
+            ts=job[i].ts;
+        }
+        if (i==0||(te.time&&(job[i].te.time==0||timediff(job[i].te,te)>0.0))) {
+            te=job[i].te;
+        }
+    }
+    if (!(ppc=(postpos_t *)malloc(sizeof(postpos_t)*(nt+1)))) {
+        showmsg("error : memory allocation");
+        return -1;
+    }
+    postposinit(ppc,1);
+    
+    /* open debug trace for all jobs */
+    if (sopt->trace>0&&*fopt->trace) {
+        traceclose();
+        traceopen(fopt->trace);
+        tracelevel(sopt->trace);
+    }
+    /* open processing session and read shared products */
+    if (!openses(popt,sopt,fopt,&ppc->navs,&ppc->pcvss,&ppc->pcvsr,1)) {
+        free(ppc);
+        return -1;
+    }
+    if (!readshared(ppc,ts,te,popt,fopt,infile,n)) {
+        freeobsnav(ppc,NULL);
+        freepreceph(ppc,&ppc->navs,&ppc->sbss);
+        closeses(&ppc->navs,&ppc->pcvss,&ppc->pcvsr,1);
+        free(ppc);
+        return -1;
+    }
+    bt.job=job; bt.njob=njob; bt.ppc=ppc; bt.sopt=sopt; bt.fopt=fopt;
+    bt.infile=infile; bt.n=n; bt.nthread=nt;
+    
+    for (i=0;i<nt;i++) {
+        th[i].bt=&bt; th[i].pp=ppc+i+1;
+    }
+    if (nt>1) {
+        initlock(&bt.lock);
+        for (i=1;i<nt;i++) {
+#ifdef WIN32
+            if (!(th[i].thread=CreateThread(NULL,0,batchthread,th+i,0,NULL))) {
+#else
+            if (pthread_create(&th[i].thread,NULL,batchthread,th+i)) {
+#endif
+                th[i].pp=NULL; /* jobs are run by other threads */
+            }
+        }
+        batchjobs(th);
+        for (i=1;i<nt;i++) {
+            if (!th[i].pp) continue;
+#ifdef WIN32
+            WaitForSingleObject(th[i].thread,INFINITE);
+            CloseHandle(th[i].thread);
+#else
+            pthread_join(th[i].thread,NULL);
+#endif
+        }
+        freelock(&bt.lock);
+    }
+    else batchjobs(th);
+    
+    for (i=0;i<njob;i++) if (job[i].stat) nerr++;
+    
+    /* free shared products and close processing session */
+    freeobsnav(ppc,NULL);
+    freepreceph(ppc,&ppc->navs,&ppc->sbss);
+    closeses(&ppc->navs,&ppc->pcvss,&ppc->pcvsr,1);
+    free(ppc);
+    
+    return nerr;
+}
@@ -59,6 +59,11 @@
 *           2018/10/10 1.13 support api change of satexclude()
 *           2020/11/30 1.14 use sat2freq() to get carrier frequency
 *                           use E1-E5b for Galileo iono-free LC
+*           2026/10/17 1.15 use receiver antenna model table in ppp_res()
+*                           evaluate receiver antenna model for all
+*                           satellites at once in ppp_res()
+*           2026/10/17 1.16 use tidal displacement cache in pppos()
+*                           use earth orientation cache for sun position
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -206,7 +211,7 @@ static void testeclipse(const obsd_t *obs, int n, const nav_t *nav, double *rs)
     trace(3,"testeclipse:\n");
     
     /* unit vector of sun direction (ecef) */
-    sunmoonpos(gpst2utc(obs[0].time),erpv,rsun,NULL,NULL);
+    sunmoonposc(nav->eoc,gpst2utc(obs[0].time),erpv,rsun,NULL,NULL);
     normv3(rsun,esun);
     
     for (i=0;i<n;i++) {
@@ -245,14 +250,14 @@ extern int yaw_angle(int sat, const char *type, int opt, double beta, double mu,
     return 1;
 }
 /* satellite attitude model --------------------------------------------------*/
-static int sat_yaw(gtime_t time, int sat, const char *type, int opt,
-                   const double *rs, double *exs, double *eys)
+static int sat_yaw(eoc_t *eoc, gtime_t time, int sat, const char *type,
+                   int opt, const double *rs, double *exs, double *eys)
 {
     double rsun[3],ri[6],es[3],esun[3],n[3],p[3],en[3],ep[3],ex[3],E,beta,mu;
     double yaw,cosy,siny,erpv[5]={0};
     int i;
     
-    sunmoonpos(gpst2utc(time),erpv,rsun,NULL,NULL);
+    sunmoonposc(eoc,gpst2utc(time),erpv,rsun,NULL,NULL);
     
     /* beta and orbit angle */
     matcpy(ri,rs,6,1);
@@ -282,8 +287,8 @@ static int sat_yaw(gtime_t time, int sat, const char *type, int opt,
     return 1;
 }
 /* phase windup model --------------------------------------------------------*/
-static int model_phw(gtime_t time, int sat, const char *type, int opt,
-                     const double *rs, const double *rr, double *phw)
+static int model_phw(eoc_t *eoc, gtime_t time, int sat, const char *type,
+                     int opt, const double *rs, const double *rr, double *phw)
 {
     double exs[3],eys[3],ek[3],exr[3],eyr[3],eks[3],ekr[3],E[9];
     double dr[3],ds[3],drs[3],r[3],pos[3],cosp,ph;
@@ -292,7 +297,7 @@ static int model_phw(gtime_t time, int sat, const char *type, int opt,
     if (opt<=0) return 1; /* no phase windup */
     
     /* satellite yaw attitude model */
-    if (!sat_yaw(time,sat,type,opt,rs,exs,eys)) return 0;
+    if (!sat_yaw(eoc,time,sat,type,opt,rs,exs,eys)) return 0;
     
     /* unit vector satellite to receiver */
     for (i=0;i<3;i++) r[i]=rr[i]-rs[i];
@@ -929,13 +934,15 @@ static int ppp_res(int post, const obsd_t *obs, int n, const double *rs,
                    double *azel)
 {
     prcopt_t *opt=&rtk->opt;
-    double y,r,cdtr,bias,C=0.0,rr[3],pos[3],e[3],dtdx[3],L[NFREQ],P[NFREQ],Lc,Pc;
+    pcvtbl_t pcvt;
+    double y,r,cdtr,bias,C=0.0,rr[3],pos[3],*e,dtdx[3],L[NFREQ],P[NFREQ],Lc,Pc;
+    double E[9],rg[MAXOBS],es[MAXOBS*3],enu[MAXOBS*3];
     double var[MAXOBS*2],dtrp=0.0,dion=0.0,vart=0.0,vari=0.0,dcb,freq;
-    double dantr[NFREQ]={0},dants[NFREQ]={0};
+    double dantr[MAXOBS*NFREQ],dants[NFREQ]={0};
     double ve[MAXOBS*2*NFREQ]={0},vmax=0;
     char str[32];
     int ne=0,obsi[MAXOBS*2*NFREQ]={0},frqi[MAXOBS*2*NFREQ],maxobs,maxfrq,rej;
-    int i,j,k,sat,sys,nv=0,nx=rtk->nx,stat=1,frq,code;
+    int i,j,k,m,sat,sys,nv=0,nx=rtk->nx,stat=1,frq,code;
     
     time2str(obs[0].time,str,2);
     
@@ -943,11 +950,24 @@ static int ppp_res(int post, const obsd_t *obs, int n, const double *rs,
     
     for (i=0;i<3;i++) rr[i]=x[i]+dr[i];
     ecef2pos(rr,pos);
+    xyz2enu(pos,E);
     
-    for (i=0;i<n&&i<MAXOBS;i++) {
+    /* geometric ranges and line-of-sight vectors to satellites */
+    for (m=0;m<n&&m<MAXOBS;m++) {
+        if ((rg[m]=geodist(rs+m*6,rr,es+m*3))<=0.0) {
+            es[m*3]=es[1+m*3]=es[2+m*3]=0.0;
+        }
+    }
+    /* receiver antenna phase center corrections of satellites */
+    initpcvtbl(opt->pcvr,opt->antdel[0],opt->posopt[1],&pcvt);
+    if (m>0) matmul("NN",3,m,3,1.0,E,es,0.0,enu);
+    antmodeln(&pcvt,enu,m,dantr);
+    
+    for (i=0;i<m;i++) {
         sat=obs[i].sat;
+        e=es+i*3;
         
-        if ((r=geodist(rs+i*6,rr,e))<=0.0||
+        if ((r=rg[i])<=0.0||
             satazel(pos,e,azel+i*2)<opt->elmin) {
             exc[i]=1;
             continue;
@@ -964,15 +984,14 @@ static int ppp_res(int post, const obsd_t *obs, int n, const double *rs,
         }
         /* satellite and receiver antenna model */
         if (opt->posopt[0]) satantpcv(rs+i*6,rr,nav->pcvs+sat-1,dants);
-        antmodel(opt->pcvr,opt->antdel[0],azel+i*2,opt->posopt[1],dantr);
         
         /* phase windup model */
-        if (!model_phw(rtk->sol.time,sat,nav->pcvs[sat-1].type,
+        if (!model_phw(nav->eoc,rtk->sol.time,sat,nav->pcvs[sat-1].type,
                        opt->posopt[2]?2:0,rs+i*6,rr,&rtk->ssat[sat-1].phw)) {
             continue;
         }
         /* corrected phase and code measurements */
-        corr_meas(obs+i,nav,azel+i*2,&rtk->opt,dantr,dants,
+        corr_meas(obs+i,nav,azel+i*2,&rtk->opt,dantr+i*NFREQ,dants,
                   rtk->ssat[sat-1].phw,L,P,&Lc,&Pc);
         
         /* stack phase and code residuals {L1,P1,L2,P2,...} */
@@ -1190,8 +1209,8 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     }
     /* earth tides correction */
     if (opt->tidecorr) {
-        tidedisp(gpst2utc(obs[0].time),rtk->x,opt->tidecorr==1?1:7,&nav->erp,
-                 opt->odisp[0],dr);
+        tidedispc(rtk->tidec,nav->eoc,gpst2utc(obs[0].time),rtk->x,
+                  opt->tidecorr==1?1:7,&nav->erp,opt->odisp[0],dr);
     }
     nv=n*rtk->opt.nf*2+MAXSAT+3;
     xp=mat(rtk->nx,1); Pp=zeros(rtk->nx,rtk->nx);
@@ -1208,7 +1227,7 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
             break;
         }
         /* measurement update of ekf states */
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if ((info=filterws(xp,Pp,H,v,R,rtk->nx,nv,&rtk->fws))) {
             trace(2,"%s ppp (%d) filter error info=%d\n",str,i+1,info);
             break;
         }
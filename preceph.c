@@ -48,16 +48,38 @@
 *                           LC defined GPS/QZS L1-L2, GLO G1-G2, GAL E1-E5b,
 *                            BDS B1I-B2I and IRN L5-S for API satantoff()
 *                           fix bug on reading SP3 file extension
+*           2026/10/17 1.18 interpolate precise ephemeris by barycentric
+*                           weights shared among satellites
+*                           search precise ephemeris and clock with cursors
+*                           add API peph2poss()
+*                           change API peph2poss() to accept time of each
+*                           satellite
+*                           add API readpephcache(),readpcvcache(),
+*                           readdcbcache()
+*                           use earth orientation cache in satantoff()
+*                           access interpolation window cache without lock
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
+#ifndef WIN32
+#include <sys/stat.h>
+#endif
 
 #define SQR(x)      ((x)*(x))
 
-#define NMAX        10              /* order of polynomial interpolation */
+#define NMAX        NMAXPEPH        /* order of polynomial interpolation */
 #define MAXDTE      900.0           /* max time difference to ephem time (s) */
 #define EXTERR_CLK  1E-3            /* extrapolation error for clock (m/s) */
 #define EXTERR_EPH  5E-7            /* extrapolation error for ephem (m/s^2) */
 
+#define PCMAGIC     "RTKPCCH"       /* magic number of cache file */
+#define PCVER       1               /* format version of cache file */
+#define PCORDER     0x01020304      /* byte order mark of cache file */
+#define PCHASH0     (((uint64_t)0xCBF29CE4<<32)|0x84222325) /* fnv-1a basis */
+#define PCHASHP     (((uint64_t)0x00000100<<32)|0x000001B3) /* fnv-1a prime */
+#define PC_PEPH     1               /* cache type: precise ephemeris/clock */
+#define PC_PCV      2               /* cache type: antenna parameters */
+#define PC_DCB      3               /* cache type: DCB parameters */
+
 /* satellite code to satellite system ----------------------------------------*/
 static int code2sys(char code)
 {
@@ -328,7 +350,7 @@ extern int readsap(const char *file, gtime_t time, nav_t *nav)
         pcv=searchpcv(i+1,"",time,&pcvs);
         nav->pcvs[i]=pcv?*pcv:pcv0;
     }
-    free(pcvs.pcv);
+    freepcv(&pcvs);
     return 1;
 }
 /* read DCB parameters file --------------------------------------------------*/
@@ -406,72 +428,638 @@ extern int readdcb(const char *file, nav_t *nav, const sta_t *sta)
     
     return 1;
 }
-/* polynomial interpolation by Neville's algorithm ---------------------------*/
-static double interppol(const double *x, double *y, int n)
+typedef struct {        /* cache file header type */
+    char magic[8];      /* magic number (PCMAGIC) */
+    uint64_t key;       /* key of cache (see pckey()) */
+    uint32_t ver;       /* format version (PCVER) */
+    uint32_t order;     /* byte order mark (PCORDER) */
+    uint32_t type;      /* cache type (PC_???) */
+    uint32_t size[3];   /* sizes of peph_t, pclk_t and pcv_t (bytes) */
+    uint32_t nsrc;      /* number of source files */
+    uint32_t n[2];      /* number of records in sections */
+} pchead_t;
+
+typedef struct {        /* cache source file type */
+    char path[1024];    /* file path */
+    int64_t size;       /* file size (bytes) */
+    int64_t mtime;      /* modification time (s since 1970/1/1) */
+    uint64_t hash;      /* hash of file contents (0: not computed) */
+} pcsrc_t;
+
+/* fnv-1a hash ---------------------------------------------------------------*/
+static uint64_t pchash(uint64_t h, const void *data, size_t n)
+{
+    const uint8_t *p=(const uint8_t *)data;
+    size_t i;
+    
+    for (i=0;i<n;i++) {
+        h^=p[i];
+        h*=PCHASHP;
+    }
+    return h;
+}
+/* hash of file contents -----------------------------------------------------*/
+static uint64_t pcfilehash(const char *file)
+{
+    FILE *fp;
+    uint8_t buff[16384];
+    uint64_t h=PCHASH0;
+    size_t n;
+    
+    if (!(fp=fopen(file,"rb"))) return 0;
+    
+    while ((n=fread(buff,1,sizeof(buff),fp))>0) h=pchash(h,buff,n);
+    fclose(fp);
+    return h;
+}
+/* size and modification time of file ----------------------------------------*/
+static int pcstat(const char *file, pcsrc_t *src)
+{
+#ifdef WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    uint64_t t;
+    
+    if (!GetFileAttributesEx((LPCTSTR)file,GetFileExInfoStandard,&data)) {
+        return 0;
+    }
+    src->size=(int64_t)(((uint64_t)data.nFileSizeHigh<<32)+data.nFileSizeLow);
+    t=((uint64_t)data.ftLastWriteTime.dwHighDateTime<<32)+
+      data.ftLastWriteTime.dwLowDateTime;
+    src->mtime=(int64_t)(t/10000000)-11644473600; /* 1601/1/1 -> 1970/1/1 */
+#else
+    struct stat st;
+    
+    if (stat(file,&st)||!S_ISREG(st.st_mode)) return 0;
+    src->size=(int64_t)st.st_size;
+    src->mtime=(int64_t)st.st_mtime;
+#endif
+    return 1;
+}
+/* record sizes of cache sections --------------------------------------------*/
+static void pcrecsize(int type, size_t *size)
+{
+    switch (type) {
+        case PC_PEPH: size[0]=sizeof(peph_t); size[1]=sizeof(pclk_t); break;
+        case PC_PCV : size[0]=sizeof(pcv_t ); size[1]=0;              break;
+        default     : size[0]=size[1]=sizeof(double);                 break;
+    }
+}
+/* add source file of cache --------------------------------------------------*/
+static int addpcsrc(const char *file, pcsrc_t **src, int *nsrc, int *nmax)
 {
-    int i,j;
+    pcsrc_t *p;
+    
+    if (strlen(file)>=sizeof((*src)->path)) return 0;
     
-    for (j=1;j<n;j++) {
-        for (i=0;i<n-j;i++) {
-            y[i]=(x[i+j]*y[i]-x[i]*y[i+1])/(x[i+j]-x[i]);
+    if (*nsrc>=*nmax) {
+        *nmax=*nmax<=0?16:*nmax*2;
+        if (!(p=(pcsrc_t *)realloc(*src,sizeof(pcsrc_t)*(*nmax)))) {
+            trace(1,"addpcsrc: memory allocation error\n");
+            free(*src); *src=NULL; *nsrc=*nmax=0;
+            return -1;
         }
+        *src=p;
+    }
+    p=*src+*nsrc;
+    memset(p,0,sizeof(pcsrc_t));
+    strcpy(p->path,file);
+    if (!pcstat(file,p)) return 0;
+    (*nsrc)++;
+    return 1;
+}
+/* key of cache --------------------------------------------------------------*/
+static uint64_t pckey(int type, const void *opt, size_t size,
+                      const pcsrc_t *src, int nsrc)
+{
+    uint64_t key=PCHASH0;
+    int i;
+    
+    key=pchash(key,&type,sizeof(type));
+    key=pchash(key,opt,size);
+    for (i=0;i<nsrc;i++) {
+        key=pchash(key,src[i].path,strlen(src[i].path)+1);
     }
-    return y[0];
+    return key;
 }
-/* satellite position by precise ephemeris -----------------------------------*/
-static int pephpos(gtime_t time, int sat, const nav_t *nav, double *rs,
-                   double *dts, double *vare, double *varc)
+/* path of cache file --------------------------------------------------------*/
+static void pcpath(const char *dir, int type, uint64_t key, char *path)
 {
-    double t[NMAX+1],p[3][NMAX+1],c[2],*pos,std=0.0,s[3],sinl,cosl;
-    int i,j,k,index;
+    sprintf(path,"%.900s%cpcache%d_%08X%08X.bin",dir,FILEPATHSEP,type,
+            (unsigned int)(key>>32),(unsigned int)(key&0xFFFFFFFF));
+}
+/* read cache file -------------------------------------------------------------
+* read sections of cache file valid for source files. the sections are copied
+* to memory allocated by malloc(). return 2 if modification times of source
+* files are outdated but contents are the same.
+*-----------------------------------------------------------------------------*/
+static int readpc(const char *file, int type, uint64_t key, pcsrc_t *src,
+                  int nsrc, void **data, int *n)
+{
+    const pchead_t *h;
+    const pcsrc_t *s;
+    const uint8_t *p;
+    size_t size,off,rsz[2];
+    int i,stat=1;
     
-    trace(4,"pephpos : time=%s sat=%2d\n",time_str(time,3),sat);
+    trace(3,"readpc  : file=%s type=%d nsrc=%d\n",file,type,nsrc);
     
-    rs[0]=rs[1]=rs[2]=dts[0]=0.0;
+    data[0]=data[1]=NULL;
+    n[0]=n[1]=0;
     
-    if (nav->ne<NMAX+1||
-        timediff(time,nav->peph[0].time)<-MAXDTE||
-        timediff(time,nav->peph[nav->ne-1].time)>MAXDTE) {
-        trace(3,"no prec ephem %s sat=%2d\n",time_str(time,0),sat);
+    if (!(p=mapfile(file,&size))) return 0;
+    
+    h=(const pchead_t *)p;
+    s=(const pcsrc_t *)(p+sizeof(pchead_t));
+    off=sizeof(pchead_t)+sizeof(pcsrc_t)*nsrc;
+    pcrecsize(type,rsz);
+    
+    if (size<off||memcmp(h->magic,PCMAGIC,sizeof(h->magic))||
+        h->ver!=PCVER||h->order!=PCORDER||h->type!=(uint32_t)type||
+        h->key!=key||h->size[0]!=sizeof(peph_t)||h->size[1]!=sizeof(pclk_t)||
+        h->size[2]!=sizeof(pcv_t)||h->nsrc!=(uint32_t)nsrc||
+        size!=off+rsz[0]*h->n[0]+rsz[1]*h->n[1]) {
+        trace(2,"cache file format error: %s\n",file);
+        unmapfile(p,size);
+        return 0;
+    }
+    /* validate source files by size, modification time and hash */
+    for (i=0;i<nsrc;i++) {
+        if (strcmp(s[i].path,src[i].path)||s[i].size!=src[i].size) break;
+        if (s[i].mtime==src[i].mtime) continue;
+        if (!src[i].hash) src[i].hash=pcfilehash(src[i].path);
+        if (s[i].hash!=src[i].hash) break;
+        stat=2;
+    }
+    if (i<nsrc) {
+        trace(2,"cache file outdated: %s src=%s\n",file,src[i].path);
+        unmapfile(p,size);
+        return 0;
+    }
+    for (i=0;i<2;i++) {
+        if (h->n[i]==0) continue;
+        if (!(data[i]=malloc(rsz[i]*h->n[i]))) {
+            trace(1,"readpc: memory allocation error\n");
+            free(data[0]); data[0]=NULL;
+            unmapfile(p,size);
+            return 0;
+        }
+        memcpy(data[i],p+off,rsz[i]*h->n[i]);
+        n[i]=(int)h->n[i];
+        off+=rsz[i]*h->n[i];
+    }
+    unmapfile(p,size);
+    return stat;
+}
+/* write cache file ------------------------------------------------------------
+* write cache file through temporary file renamed at last not to expose
+* incomplete file to other processes
+*-----------------------------------------------------------------------------*/
+static int writepc(const char *file, int type, uint64_t key, pcsrc_t *src,
+                   int nsrc, void * const *data, const int *n)
+{
+    FILE *fp;
+    pchead_t h;
+    size_t rsz[2];
+    char tmp[1024];
+    int i,stat;
+    
+    trace(3,"writepc : file=%s type=%d nsrc=%d\n",file,type,nsrc);
+    
+    for (i=0;i<nsrc;i++) {
+        if (!src[i].hash&&!(src[i].hash=pcfilehash(src[i].path))) return 0;
+    }
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,PCMAGIC,sizeof(h.magic));
+    h.key=key;
+    h.ver=PCVER;
+    h.order=PCORDER;
+    h.type=(uint32_t)type;
+    h.size[0]=sizeof(peph_t);
+    h.size[1]=sizeof(pclk_t);
+    h.size[2]=sizeof(pcv_t);
+    h.nsrc=(uint32_t)nsrc;
+    h.n[0]=(uint32_t)n[0];
+    h.n[1]=(uint32_t)n[1];
+    pcrecsize(type,rsz);
+    
+    sprintf(tmp,"%s.%08X",file,tickget()^(unsigned int)rand());
+    
+    if (!(fp=fopen(tmp,"wb"))) {
+        trace(2,"cache file open error: %s\n",tmp);
         return 0;
     }
+    stat=fwrite(&h,sizeof(h),1,fp)==1&&
+         fwrite(src,sizeof(pcsrc_t),nsrc,fp)==(size_t)nsrc;
+    
+    for (i=0;i<2&&stat;i++) {
+        if (n[i]<=0) continue;
+        stat=fwrite(data[i],rsz[i],n[i],fp)==(size_t)n[i];
+    }
+    if (fclose(fp)) stat=0;
+    
+    if (stat&&rename(tmp,file)) { /* windows does not replace existing file */
+        remove(file);
+        stat=!rename(tmp,file);
+    }
+    if (!stat) {
+        trace(2,"cache file write error: %s\n",file);
+        remove(tmp);
+    }
+    return stat;
+}
+/* test source file of precise ephemeris or clock ----------------------------*/
+static int pephsrc(const char *file)
+{
+    FILE *fp;
+    char buff[256],*ext,*p;
+    int stat;
+    
+    if (!(ext=strrchr(file,'.'))) return 0;
+    
+    /* sp3 file by extension as readsp3() */
+    if (strstr(ext,".sp3")||strstr(ext,".SP3")||
+        strstr(ext,".eph")||strstr(ext,".EPH")) return 1;
+    
+    /* compressed rinex clock file by file name */
+    if (!strcmp(ext,".z"  )||!strcmp(ext,".Z"  )||
+        !strcmp(ext,".gz" )||!strcmp(ext,".GZ" )||
+        !strcmp(ext,".zip")||!strcmp(ext,".ZIP")) {
+        if (!(p=strrchr(file,FILEPATHSEP))) p=(char *)file;
+        return strstr(p,"clk")||strstr(p,"CLK");
+    }
+    /* rinex clock file by header */
+    if (!(fp=fopen(file,"r"))) return 0;
+    stat=fgets(buff,sizeof(buff),fp)&&strlen(buff)>20&&
+         strstr(buff,"RINEX VERSION / TYPE")&&buff[20]=='C';
+    fclose(fp);
+    return stat;
+}
+/* expand source files of cache ----------------------------------------------*/
+static int pcsrcs(char **files, int n, int (*test)(const char *),
+                  pcsrc_t **src, int *nsrc)
+{
+    char *efiles[MAXEXFILE];
+    int i,j,m,nmax=0;
+    
+    *src=NULL; *nsrc=0;
+    
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(efiles[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(efiles[i]);
+            return 0;
+        }
+    }
+    for (i=0;i<n;i++) {
+        m=expath(files[i],efiles,MAXEXFILE);
+        
+        for (j=0;j<m;j++) {
+            if (test&&!test(efiles[j])) continue;
+            if (addpcsrc(efiles[j],src,nsrc,&nmax)<0) break;
+        }
+        if (j<m) break;
+    }
+    for (i=0;i<MAXEXFILE;i++) free(efiles[i]);
+    
+    if (*nsrc<=0) {
+        free(*src); *src=NULL; *nsrc=0;
+    }
+    return *nsrc;
+}
+/* read precise ephemeris and clock files with cache ---------------------------
+* read precise ephemeris and precise clock files through binary cache file
+* args   : char   **files     I   precise ephemeris and clock files
+*                                 (wild-card * expanded)
+*          int    n           I   number of files
+*          int    opt         I   options for readsp3()
+*          char   *dir        I   cache directory ("": no cache)
+*          nav_t  *nav        IO  navigation data
+* return : status (1:read from cache,0:read from files)
+* notes  : same as readsp3() and readrnxc() for all files
+*          the cache file in dir is keyed by options and paths of source files
+*          and invalidated if any source file is changed in size, or in
+*          modification time and hash of contents
+*          source files are sp3 files by extension, rinex clock files by header
+*          and compressed files with "clk" or "CLK" in the file name
+*          no cache used if nav->peph or nav->pclk is not empty
+*-----------------------------------------------------------------------------*/
+extern int readpephcache(char **files, int n, int opt, const char *dir,
+                         nav_t *nav)
+{
+    pcsrc_t *src=NULL;
+    uint64_t key=0;
+    void *data[2];
+    char path[1024];
+    int i,nsrc=0,nd[2],stat;
+    
+    trace(3,"readpephcache: n=%d opt=%d dir=%s\n",n,opt,dir);
+    
+    if (*dir&&nav->ne<=0&&nav->nc<=0&&pcsrcs(files,n,pephsrc,&src,&nsrc)) {
+        key=pckey(PC_PEPH,&opt,sizeof(opt),src,nsrc);
+        pcpath(dir,PC_PEPH,key,path);
+        
+        if ((stat=readpc(path,PC_PEPH,key,src,nsrc,data,nd))) {
+            free(nav->peph); free(nav->pclk);
+            nav->peph=(peph_t *)data[0]; nav->ne=nav->nemax=nd[0];
+            nav->pclk=(pclk_t *)data[1]; nav->nc=nav->ncmax=nd[1];
+            if (stat==2) writepc(path,PC_PEPH,key,src,nsrc,data,nd);
+            free(src);
+            return 1;
+        }
+    }
+    for (i=0;i<n;i++) readsp3(files[i],nav,opt);
+    for (i=0;i<n;i++) readrnxc(files[i],nav);
+    
+    if (src) {
+        data[0]=nav->peph; nd[0]=nav->ne;
+        data[1]=nav->pclk; nd[1]=nav->nc;
+        writepc(path,PC_PEPH,key,src,nsrc,data,nd);
+        free(src);
+    }
+    return 0;
+}
+/* read antenna parameters with cache ------------------------------------------
+* read antenna parameters file through binary cache file
+* args   : char   *file       I   antenna parameter file (antex or ngs)
+*          char   *dir        I   cache directory ("": no cache)
+*          pcvs_t *pcvs       IO  antenna parameters
+* return : status (1:ok,0:file open error)
+* notes  : same as readpcv() except for the cache
+*          no cache used if pcvs is not empty
+*-----------------------------------------------------------------------------*/
+extern int readpcvcache(const char *file, const char *dir, pcvs_t *pcvs)
+{
+    pcsrc_t *src=NULL;
+    uint64_t key=0;
+    void *data[2];
+    char path[1024];
+    int nsrc=0,nmax=0,nd[2],stat;
+    
+    trace(3,"readpcvcache: file=%s dir=%s\n",file,dir);
+    
+    if (*dir&&pcvs->n<=0&&addpcsrc(file,&src,&nsrc,&nmax)>0) {
+        key=pckey(PC_PCV,NULL,0,src,nsrc);
+        pcpath(dir,PC_PCV,key,path);
+        
+        if ((stat=readpc(path,PC_PCV,key,src,nsrc,data,nd))) {
+            freepcv(pcvs);
+            pcvs->pcv=(pcv_t *)data[0]; pcvs->n=pcvs->nmax=nd[0];
+            pcvindex(pcvs);
+            if (stat==2) writepc(path,PC_PCV,key,src,nsrc,data,nd);
+            free(src);
+            return 1;
+        }
+    }
+    if ((stat=readpcv(file,pcvs))&&nsrc>0) {
+        data[0]=pcvs->pcv; nd[0]=pcvs->n;
+        data[1]=NULL;      nd[1]=0;
+        writepc(path,PC_PCV,key,src,nsrc,data,nd);
+    }
+    free(src);
+    return stat;
+}
+/* set DCB parameters --------------------------------------------------------*/
+static void setdcb(nav_t *nav, const double *cbias, const double *rbias)
+{
+    double *p=nav->rbias[0][0];
+    int i;
+    
+    memcpy(nav->cbias,cbias,sizeof(nav->cbias));
+    
+    /* receiver DCB only in the files (see readdcbf()) */
+    for (i=0;i<MAXRCV*2*3;i++) {
+        if (rbias[i]!=0.0) p[i]=rbias[i];
+    }
+}
+/* read DCB parameters with cache ----------------------------------------------
+* read differential code bias (DCB) parameters through binary cache file
+* args   : char   *file       I   DCB parameters file (wild-card * expanded)
+*          char   *dir        I   cache directory ("": no cache)
+*          nav_t  *nav        IO  navigation data
+*          sta_t  *sta        I   station info data to inport receiver DCB
+*                                 (NULL: no use)
+* return : status (1:ok,0:error)
+* notes  : same as readdcb() except for the cache
+*          the cache is keyed by station names in addition to the source files
+*-----------------------------------------------------------------------------*/
+extern int readdcbcache(const char *file, const char *dir, nav_t *nav,
+                        const sta_t *sta)
+{
+    pcsrc_t *src=NULL;
+    nav_t *tmp;
+    uint64_t key=0,opt=PCHASH0;
+    void *data[2];
+    char path[1024];
+    int i,nsrc=0,nd[2],stat;
+    
+    trace(3,"readdcbcache: file=%s dir=%s\n",file,dir);
+    
+    if (!*dir||!pcsrcs((char **)&file,1,NULL,&src,&nsrc)) {
+        return readdcb(file,nav,sta);
+    }
+    for (i=0;sta&&i<MAXRCV;i++) {
+        opt=pchash(opt,sta[i].name,strlen(sta[i].name)+1);
+    }
+    key=pckey(PC_DCB,&opt,sizeof(opt),src,nsrc);
+    pcpath(dir,PC_DCB,key,path);
+    
+    if ((stat=readpc(path,PC_DCB,key,src,nsrc,data,nd))) {
+        if (nd[0]==MAXSAT*3&&nd[1]==MAXRCV*2*3) {
+            setdcb(nav,(double *)data[0],(double *)data[1]);
+            if (stat==2) writepc(path,PC_DCB,key,src,nsrc,data,nd);
+            free(data[0]); free(data[1]); free(src);
+            return 1;
+        }
+        free(data[0]); free(data[1]);
+    }
+    /* read DCB parameters into zero-cleared buffer to extract updates */
+    if (!(tmp=(nav_t *)calloc(1,sizeof(nav_t)))) {
+        free(src);
+        return readdcb(file,nav,sta);
+    }
+    if ((stat=readdcb(file,tmp,sta))) {
+        data[0]=tmp->cbias[0];       nd[0]=MAXSAT*3;
+        data[1]=tmp->rbias[0][0];    nd[1]=MAXRCV*2*3;
+        writepc(path,PC_DCB,key,src,nsrc,data,nd);
+        setdcb(nav,tmp->cbias[0],tmp->rbias[0][0]);
+    }
+    free(tmp);
+    free(src);
+    return stat;
+}
+/* interpolation of precise ephemeris and clock at a time --------------------*/
+typedef struct {
+    int stat;           /* ephemeris status (1:ok,0:no ephemeris) */
+    int index;          /* index of ephemeris before time */
+    int i0;             /* start index of interpolation nodes */
+    double t[NMAX+1];   /* node times relative to time (s) */
+    double L[NMAX+1];   /* lagrange coefficients of nodes */
+    double cosl[NMAX+1],sinl[NMAX+1]; /* earth rotation of nodes */
+    int cindex;         /* index of clock before time (-1: no clock) */
+} pephint_t;
+
+/* search precise ephemeris index before time with cursor --------------------*/
+static int pephindex(gtime_t time, const peph_t *peph, int ne, int cur)
+{
+    int i,j,k;
+    
+    /* cursor or next one for monotonic time */
+    for (k=0;k<2&&0<=cur&&cur<=ne-2;k++,cur++) {
+        if ((cur==0||timediff(peph[cur].time,time)<0.0)&&
+            (cur==ne-2||timediff(peph[cur+1].time,time)>=0.0)) return cur;
+    }
     /* binary search */
-    for (i=0,j=nav->ne-1;i<j;) {
+    for (i=0,j=ne-1;i<j;) {
         k=(i+j)/2;
-        if (timediff(nav->peph[k].time,time)<0.0) i=k+1; else j=k;
+        if (timediff(peph[k].time,time)<0.0) i=k+1; else j=k;
     }
-    index=i<=0?0:i-1;
+    return i<=0?0:i-1;
+}
+/* search precise clock index before time with cursor ------------------------*/
+static int pclkindex(gtime_t time, const pclk_t *pclk, int nc, int cur)
+{
+    int i,j,k;
     
-    /* polynomial interpolation for orbit */
-    i=index-(NMAX+1)/2;
-    if (i<0) i=0; else if (i+NMAX>=nav->ne) i=nav->ne-NMAX-1;
+    for (k=0;k<2&&0<=cur&&cur<=nc-2;k++,cur++) {
+        if ((cur==0||timediff(pclk[cur].time,time)<0.0)&&
+            (cur==nc-2||timediff(pclk[cur+1].time,time)>=0.0)) return cur;
+    }
+    for (i=0,j=nc-1;i<j;) {
+        k=(i+j)/2;
+        if (timediff(pclk[k].time,time)<0.0) i=k+1; else j=k;
+    }
+    return i<=0?0:i-1;
+}
+/* barycentric weights of interpolation window -------------------------------*/
+static void pephwin(const nav_t *nav, int i0, pephwin_t *win)
+{
+    double x[NMAX+1],w;
+    int j,k;
     
     for (j=0;j<=NMAX;j++) {
-        t[j]=timediff(nav->peph[i+j].time,time);
-        if (norm(nav->peph[i+j].pos[sat-1],3)<=0.0) {
+        x[j]=timediff(nav->peph[i0+j].time,nav->peph[i0].time);
+    }
+    for (j=0;j<=NMAX;j++) {
+        for (k=0,w=1.0;k<=NMAX;k++) if (k!=j) w*=x[j]-x[k];
+        win->w[j]=1.0/w;
+        win->cosa[j]=cos(OMGE*x[j]);
+        win->sina[j]=sin(OMGE*x[j]);
+    }
+    win->peph=nav->peph;
+    win->ne=nav->ne;
+    win->i0=i0;
+}
+/* test interpolation window ------------------------------------------------*/
+static int pephwinok(const pephwin_t *win, const nav_t *nav, int i0)
+{
+    return win->peph==nav->peph&&win->ne==nav->ne&&win->i0==i0;
+}
+/* set interpolation of precise ephemeris and clock at time --------------------
+* the index before time is searched from the cursors and the barycentric
+* weights of the node window are reused if they are in the window of the
+* caller (win) or in the satellite state cache of navigation data
+*-----------------------------------------------------------------------------*/
+static void pephint(gtime_t time, const nav_t *nav, pephwin_t *win,
+                    pephint_t *pi)
+{
+    satcache_t *sc=nav->sc;
+    double b,cosb,sinb,s;
+    int i,j,pidx=0,cidx=0,stat=0;
+    
+    pi->stat=0;
+    pi->cindex=-1;
+    
+    if (sc) {
+        pidx=sc->pidx; cidx=sc->cidx;
+    }
+    /* precise clock */
+    if (nav->nc>=2&&
+        timediff(time,nav->pclk[0].time)>=-MAXDTE&&
+        timediff(time,nav->pclk[nav->nc-1].time)<=MAXDTE) {
+        pi->cindex=cidx=pclkindex(time,nav->pclk,nav->nc,cidx);
+    }
+    /* precise ephemeris */
+    if (nav->ne>=NMAX+1&&
+        timediff(time,nav->peph[0].time)>=-MAXDTE&&
+        timediff(time,nav->peph[nav->ne-1].time)<=MAXDTE) {
+        pi->index=pidx=pephindex(time,nav->peph,nav->ne,pidx);
+        
+        i=pi->index-(NMAX+1)/2;
+        if (i<0) i=0; else if (i+NMAX>=nav->ne) i=nav->ne-NMAX-1;
+        pi->i0=i;
+        stat=1;
+    }
+    if (stat&&pephwinok(win,nav,pi->i0)) stat=2;
+    
+    if (sc) {
+        sc->pidx=pidx; sc->cidx=cidx;
+        if (stat==1&&pephwinok(&sc->pwin,nav,pi->i0)) {
+            *win=sc->pwin;
+            stat=2;
+        }
+    }
+    if (!stat) return;
+    
+    if (stat==1) {
+        pephwin(nav,pi->i0,win);
+        if (sc) sc->pwin=*win;
+    }
+    for (j=0;j<=NMAX;j++) {
+        pi->t[j]=timediff(nav->peph[pi->i0+j].time,time);
+    }
+    /* earth rotation of nodes (rotation of node 0 + rotation from node 0) */
+    b=OMGE*pi->t[0];
+    cosb=cos(b); sinb=sin(b);
+    for (j=0;j<=NMAX;j++) {
+        pi->cosl[j]=win->cosa[j]*cosb-win->sina[j]*sinb;
+        pi->sinl[j]=win->sina[j]*cosb+win->cosa[j]*sinb;
+    }
+    /* lagrange coefficients by barycentric formula */
+    for (j=0;j<=NMAX;j++) if (pi->t[j]==0.0) break;
+    if (j<=NMAX) {
+        for (i=0;i<=NMAX;i++) pi->L[i]=i==j?1.0:0.0;
+    }
+    else {
+        for (j=0,s=0.0;j<=NMAX;j++) s+=(pi->L[j]=win->w[j]/pi->t[j]);
+        for (j=0;j<=NMAX;j++) pi->L[j]/=s;
+    }
+    pi->stat=1;
+}
+/* satellite position by precise ephemeris -----------------------------------*/
+static int pephpos(gtime_t time, int sat, const nav_t *nav, const pephint_t *pi,
+                   double *rs, double *dts, double *vare, double *varc)
+{
+    double t[2],c[2],*pos,std=0.0,s[3],p[3];
+    int i,j,index=pi->index;
+    
+    trace(4,"pephpos : time=%s sat=%2d\n",time_str(time,3),sat);
+    
+    rs[0]=rs[1]=rs[2]=dts[0]=0.0;
+    
+    if (!pi->stat) {
+        trace(3,"no prec ephem %s sat=%2d\n",time_str(time,0),sat);
+        return 0;
+    }
+    for (j=0;j<=NMAX;j++) {
+        if (norm(nav->peph[pi->i0+j].pos[sat-1],3)<=0.0) {
             trace(3,"prec ephem outage %s sat=%2d\n",time_str(time,0),sat);
             return 0;
         }
     }
+    /* polynomial interpolation for orbit with correction for earth rotation */
     for (j=0;j<=NMAX;j++) {
-        pos=nav->peph[i+j].pos[sat-1];
-        /* correciton for earh rotation ver.2.4.0 */
-        sinl=sin(OMGE*t[j]);
-        cosl=cos(OMGE*t[j]);
-        p[0][j]=cosl*pos[0]-sinl*pos[1];
-        p[1][j]=sinl*pos[0]+cosl*pos[1];
-        p[2][j]=pos[2];
-    }
-    for (i=0;i<3;i++) {
-        rs[i]=interppol(t,p[i],NMAX+1);
+        pos=nav->peph[pi->i0+j].pos[sat-1];
+        p[0]=pi->cosl[j]*pos[0]-pi->sinl[j]*pos[1];
+        p[1]=pi->sinl[j]*pos[0]+pi->cosl[j]*pos[1];
+        p[2]=pos[2];
+        for (i=0;i<3;i++) rs[i]+=pi->L[j]*p[i];
     }
     if (vare) {
         for (i=0;i<3;i++) s[i]=nav->peph[index].std[sat-1][i];
         std=norm(s,3);
         
         /* extrapolation error for orbit */
-        if      (t[0   ]>0.0) std+=EXTERR_EPH*SQR(t[0   ])/2.0;
-        else if (t[NMAX]<0.0) std+=EXTERR_EPH*SQR(t[NMAX])/2.0;
+        if      (pi->t[0   ]>0.0) std+=EXTERR_EPH*SQR(pi->t[0   ])/2.0;
+        else if (pi->t[NMAX]<0.0) std+=EXTERR_EPH*SQR(pi->t[NMAX])/2.0;
         *vare=SQR(std);
     }
     /* linear interpolation for clock */
@@ -502,26 +1090,18 @@ static int pephpos(gtime_t time, int sat, const nav_t *nav, double *rs,
     return 1;
 }
 /* satellite clock by precise clock ------------------------------------------*/
-static int pephclk(gtime_t time, int sat, const nav_t *nav, double *dts,
-                   double *varc)
+static int pephclk(gtime_t time, int sat, const nav_t *nav, const pephint_t *pi,
+                   double *dts, double *varc)
 {
     double t[2],c[2],std;
-    int i,j,k,index;
+    int i,index=pi->cindex;
     
     trace(4,"pephclk : time=%s sat=%2d\n",time_str(time,3),sat);
     
-    if (nav->nc<2||
-        timediff(time,nav->pclk[0].time)<-MAXDTE||
-        timediff(time,nav->pclk[nav->nc-1].time)>MAXDTE) {
+    if (index<0) {
         trace(3,"no prec clock %s sat=%2d\n",time_str(time,0),sat);
         return 1;
     }
-    /* binary search */
-    for (i=0,j=nav->nc-1;i<j;) {
-        k=(i+j)/2;
-        if (timediff(nav->pclk[k].time,time)<0.0) i=k+1; else j=k;
-    }
-    index=i<=0?0:i-1;
     
     /* linear interpolation for clock */
     t[0]=timediff(time,nav->pclk[index  ].time);
@@ -579,7 +1159,7 @@ extern void satantoff(gtime_t time, const double *rs, int sat, const nav_t *nav,
     dant[0]=dant[1]=dant[2]=0.0;
     
     /* sun position in ecef */
-    sunmoonpos(gpst2utc(time),erpv,rsun,NULL,&gmst);
+    sunmoonposc(nav->eoc,gpst2utc(time),erpv,rsun,NULL,&gmst);
     
     /* unit vectors of satellite fixed coordinates */
     for (i=0;i<3;i++) r[i]=-rs[i];
@@ -642,8 +1222,8 @@ extern void satantoff(gtime_t time, const double *rs, int sat, const nav_t *nav,
 *          nav->nc must be set by calling readsp3(), readrnx() or readrnxt()
 *          if precise clocks are not set, clocks in sp3 are used instead
 *-----------------------------------------------------------------------------*/
-extern int peph2pos(gtime_t time, int sat, const nav_t *nav, int opt,
-                    double *rs, double *dts, double *var)
+static int peph2pos_(gtime_t time, int sat, const nav_t *nav, int opt,
+                     const pephint_t *pi, double *rs, double *dts, double *var)
 {
     gtime_t time_tt;
     double rss[3],rst[3],dtss[1],dtst[1],dant[3]={0},vare=0.0,varc=0.0,tt=1E-3;
@@ -654,12 +1234,12 @@ extern int peph2pos(gtime_t time, int sat, const nav_t *nav, int opt,
     if (sat<=0||MAXSAT<sat) return 0;
     
     /* satellite position and clock bias */
-    if (!pephpos(time,sat,nav,rss,dtss,&vare,&varc)||
-        !pephclk(time,sat,nav,dtss,&varc)) return 0;
+    if (!pephpos(time,sat,nav,pi,rss,dtss,&vare,&varc)||
+        !pephclk(time,sat,nav,pi,dtss,&varc)) return 0;
     
     time_tt=timeadd(time,tt);
-    if (!pephpos(time_tt,sat,nav,rst,dtst,NULL,NULL)||
-        !pephclk(time_tt,sat,nav,dtst,NULL)) return 0;
+    if (!pephpos(time_tt,sat,nav,pi+1,rst,dtst,NULL,NULL)||
+        !pephclk(time_tt,sat,nav,pi+1,dtst,NULL)) return 0;
     
     /* satellite antenna offset correction */
     if (opt) {
@@ -681,3 +1261,65 @@ extern int peph2pos(gtime_t time, int sat, const nav_t *nav, int opt,
     
     return 1;
 }
+extern int peph2pos(gtime_t time, int sat, const nav_t *nav, int opt,
+                    double *rs, double *dts, double *var)
+{
+    pephint_t pi[2];
+    pephwin_t win;
+    
+    win.peph=NULL;
+    pephint(time,nav,&win,pi);
+    pephint(timeadd(time,1E-3),nav,&win,pi+1);
+    
+    return peph2pos_(time,sat,nav,opt,pi,rs,dts,var);
+}
+/* satellite positions/clocks by precise ephemeris/clock -----------------------
+* compute satellite positions/clocks of satellites with precise ephemeris/clock
+* args   : gtime_t *time      I   times of satellites (gpst)
+*                                 (time[i]={0}: not computed)
+*          int    *sat        I   satellite numbers
+*          int    n           I   number of satellites
+*          nav_t  *nav        I   navigation data
+*          int    opt         I   sat postion option
+*                                 (0: center of mass, 1: antenna phase center)
+*          double *rs         O   sat positions and velocities (ecef)
+*                                 rs [(0:5)+i*6]= sat[i] {x,y,z,vx,vy,vz} (m|m/s)
+*          double *dts        O   sat clocks
+*                                 dts[(0:1)+i*2]= sat[i] {bias,drift} (s|s/s)
+*          double *var        IO  sat position and clock error variances (m)
+*                                 (NULL: no output)
+*          int    *stat       O   status of satellites (1:ok,0:error or outage)
+* return : number of satellites computed
+* notes  : same as peph2pos() except the barycentric weights of the node
+*          window are computed once and shared among satellites and the
+*          interpolation coefficients are shared among satellites at the
+*          same time
+*-----------------------------------------------------------------------------*/
+extern int peph2poss(const gtime_t *time, const int *sat, int n,
+                     const nav_t *nav, int opt, double *rs, double *dts,
+                     double *var, int *stat)
+{
+    gtime_t t0={0};
+    pephint_t pi[2];
+    pephwin_t win;
+    int i,m=0;
+    
+    trace(3,"peph2poss: n=%d opt=%d\n",n,opt);
+    
+    win.peph=NULL;
+    
+    for (i=0;i<n;i++) {
+        stat[i]=0;
+        if (time[i].time==0) continue;
+        
+        if (time[i].time!=t0.time||time[i].sec!=t0.sec) {
+            pephint(time[i],nav,&win,pi);
+            pephint(timeadd(time[i],1E-3),nav,&win,pi+1);
+            t0=time[i];
+        }
+        stat[i]=peph2pos_(time[i],sat[i],nav,opt,pi,rs+i*6,dts+i*2,
+                          var?var+i:NULL);
+        m+=stat[i];
+    }
+    return m;
+}
@@ -116,6 +116,8 @@
 *                           use API code2idx() to get frequency index
 *                           use intger types in stdint.h
 *                           suppress warnings
+*           2026/10/17 1.31 add api open_rnxobs(),close_rnxobs(),seek_rnxobs(),
+*                           input_rnxobs()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -1947,6 +1949,231 @@ extern int input_rnxctr(rnxctr_t *rnx, FILE *fp)
     }
     return 2;
 }
+/* open RINEX OBS stream -------------------------------------------------------
+* open RINEX OBS file to input observation data epoch by epoch
+* args   : rnxobs_t *rnx IO  RINEX OBS stream
+*          char   *file  I   RINEX OBS file (compressed file uncompressed)
+*          int    rcv    I   receiver number for obs data
+*          gtime_t ts    I   observation time start (ts.time==0: no limit)
+*          gtime_t te    I   observation time end   (te.time==0: no limit)
+*          double tint   I   observation time interval (s) (0:all)
+*          char   *opt   I   RINEX options (see readrnxt())
+*          nav_t  *nav   IO  navigation data    (NULL: no input)
+*          sta_t  *sta   IO  station parameters (NULL: no input)
+* return : status (1:ok,0:not RINEX OBS file,-1:error)
+* notes  : the file is kept open until close_rnxobs(). sta is updated by the
+*          header and by header records in the body while input.
+*-----------------------------------------------------------------------------*/
+extern int open_rnxobs(rnxobs_t *rnx, const char *file, int rcv, gtime_t ts,
+                       gtime_t te, double tint, const char *opt, nav_t *nav,
+                       sta_t *sta)
+{
+    const char *p;
+    char type=' ';
+    int i,j,sys,cstat;
+    
+    trace(3,"open_rnxobs: file=%s rcv=%d\n",file,rcv);
+    
+    rnx->fp=NULL;
+    rnx->data=NULL;
+    rnx->tmpfile[0]='\0';
+    for (i=0;i<8;i++) for (j=0;j<MAXOBSTYPE;j++) rnx->tobs[i][j][0]='\0';
+    
+    if ((cstat=rtk_uncompress(file,rnx->tmpfile))<0) {
+        trace(2,"rinex file uncompact error: %s\n",file);
+        return -1;
+    }
+    if (!cstat) rnx->tmpfile[0]='\0';
+    
+    if (!(rnx->fp=fopen(cstat?rnx->tmpfile:file,"r"))) {
+        trace(2,"rinex file open error: %s\n",cstat?rnx->tmpfile:file);
+        close_rnxobs(rnx);
+        return -1;
+    }
+    if (sta) init_sta(sta);
+    rnx->tsys=TSYS_GPS;
+    
+    if (!readrnxh(rnx->fp,&rnx->ver,&type,&sys,&rnx->tsys,rnx->tobs,nav,sta)||
+        type!='O') {
+        close_rnxobs(rnx);
+        return 0;
+    }
+    if (!(rnx->data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS*2))) {
+        close_rnxobs(rnx);
+        return -1;
+    }
+    /* if station name empty, set 4-char name from file head */
+    if (sta&&!*sta->name) {
+        if (!(p=strrchr(file,FILEPATHSEP))) p=file-1;
+        setstr(sta->name,p+1,4);
+    }
+    rnx->rcv=rcv;
+    rnx->ts=ts;
+    rnx->te=te;
+    rnx->tint=tint;
+    rnx->sta=sta;
+    strcpy(rnx->opt,opt);
+    rnx->body=ftell(rnx->fp);
+    
+    return seek_rnxobs(rnx,NULL);
+}
+/* close RINEX OBS stream ------------------------------------------------------
+* close RINEX OBS file and delete uncompressed temporary file
+* args   : rnxobs_t *rnx IO  RINEX OBS stream
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void close_rnxobs(rnxobs_t *rnx)
+{
+    trace(3,"close_rnxobs:\n");
+    
+    if (rnx->fp) fclose(rnx->fp);
+    if (*rnx->tmpfile) remove(rnx->tmpfile);
+    free(rnx->data);
+    rnx->fp=NULL;
+    rnx->data=NULL;
+    rnx->tmpfile[0]='\0';
+}
+/* seek RINEX OBS stream -------------------------------------------------------
+* move RINEX OBS stream to position of an epoch
+* args   : rnxobs_t *rnx IO  RINEX OBS stream
+*          rnxpos_t *pos I   stream position returned by input_rnxobs()
+*                            (NULL: start of observation data body)
+* return : status (1:ok,0:error)
+* notes  : cycle slips of screened epochs and time of last epoch before the
+*          position are restored, so the epochs are input after seek as
+*          without seek including delayed event.
+*-----------------------------------------------------------------------------*/
+extern int seek_rnxobs(rnxobs_t *rnx, const rnxpos_t *pos)
+{
+    gtime_t time0={0};
+    
+    trace(4,"seek_rnxobs: off=%ld\n",pos?pos->off:rnx->body);
+    
+    rnx->n=-1;
+    
+    if (!pos) {
+        memset(rnx->slips,0,sizeof(rnx->slips));
+        rnx->nep=rnx->n1=0;
+        rnx->time1=rnx->data[MAXOBS].time=time0;
+        rnx->dtime1=0.0;
+        return fseek(rnx->fp,rnx->body,SEEK_SET)==0;
+    }
+    memcpy(rnx->slips,pos->slips,sizeof(rnx->slips));
+    rnx->nep=pos->nep;
+    rnx->n1=pos->n1;
+    rnx->time1=rnx->data[MAXOBS].time=pos->time1; /* last read record */
+    rnx->dtime1=pos->dtime1;
+    return fseek(rnx->fp,pos->off,SEEK_SET)==0;
+}
+/* get RINEX OBS stream position ---------------------------------------------*/
+static void getrnxpos(const rnxobs_t *rnx, rnxpos_t *pos)
+{
+    pos->off=ftell(rnx->fp);
+    pos->nep=rnx->nep;
+    pos->n1=rnx->n1;
+    pos->time1=rnx->time1;
+    pos->dtime1=rnx->dtime1;
+    memcpy(pos->slips,rnx->slips,sizeof(pos->slips));
+}
+/* input RINEX OBS stream ------------------------------------------------------
+* input observation data of next epoch from RINEX OBS stream
+* args   : rnxobs_t *rnx IO  RINEX OBS stream
+*          obsd_t *data  O   observation data of epoch (MAXOBS)
+*          rnxpos_t *pos O   stream position to input the epoch by seek_rnxobs()
+* return : number of observation data (-1: end of file)
+* notes  : observation data are screened, converted to GPST and set cycle slips
+*          and event time as readrnxt(). an epoch is output after the next
+*          epoch is read to attach a delayed event.
+*-----------------------------------------------------------------------------*/
+extern int input_rnxobs(rnxobs_t *rnx, obsd_t *data, rnxpos_t *pos)
+{
+    gtime_t eventime={0},time0={0};
+    obsd_t *buff=rnx->data+MAXOBS;
+    rnxpos_t pos0;
+    int i,n,nout,flag=0;
+    
+    trace(4,"input_rnxobs: rcv=%d\n",rnx->rcv);
+    
+    pos0.off=-1;
+    
+    for (;;) {
+        if (pos0.off<0) getrnxpos(rnx,&pos0);
+        
+        if ((n=readrnxobsb(rnx->fp,rnx->opt,rnx->ver,&rnx->tsys,rnx->tobs,
+                           &flag,buff,rnx->sta))<0) break;
+        
+        if (flag==5) {
+            eventime=buff[0].eventime;
+            n=readrnxobsb(rnx->fp,rnx->opt,rnx->ver,&rnx->tsys,rnx->tobs,&flag,
+                          buff,rnx->sta);
+            if (n>=0&&fabs(timediff(buff[0].time,rnx->time1)-rnx->dtime1)>=DTTOL)
+                n=readrnxobsb(rnx->fp,rnx->opt,rnx->ver,&rnx->tsys,rnx->tobs,
+                              &flag,buff,rnx->sta);
+            if (n<0) break;
+        }
+        if (eventime.time==0||rnx->nep<=(rnx->n1>0?1:0)||
+            timediff(eventime,rnx->time1)>=0) {
+            for (i=0;i<n;i++) buff[i].eventime=eventime;
+        }
+        else {
+            /* add event to previous epoch if delayed */
+            if (rnx->n1>0) {
+                for (i=0;i<rnx->n;i++) rnx->data[i].eventime=eventime;
+            }
+            for (i=0;i<n;i++) buff[i].eventime=time0;
+        }
+        eventime=time0;
+        
+        for (i=0;i<n;i++) {
+            
+            /* UTC -> GPST */
+            if (rnx->tsys==TSYS_UTC) buff[i].time=utc2gpst(buff[i].time);
+            
+            /* save cycle slip */
+            saveslips(rnx->slips,buff+i);
+        }
+        /* screen data by time */
+        if (n>0&&!screent(buff[0].time,rnx->ts,rnx->te,rnx->tint)) continue;
+        
+        for (i=0;i<n;i++) {
+            
+            /* restore cycle slip */
+            restslips(rnx->slips,buff+i);
+            
+            buff[i].rcv=(uint8_t)rnx->rcv;
+        }
+        /* time of empty record is of last read record as readrnxobs() */
+        rnx->n1=n;
+        rnx->dtime1=timediff(buff[0].time,rnx->time1);
+        rnx->time1=buff[0].time;
+        if (n<=0) continue;
+        rnx->nep++;
+        
+        if (rnx->n<0) { /* first epoch */
+            memcpy(rnx->data,buff,sizeof(obsd_t)*n);
+            rnx->n=n;
+            rnx->pos=pos0;
+            pos0.off=-1;
+            continue;
+        }
+        /* output previous epoch and keep read epoch */
+        memcpy(data,rnx->data,sizeof(obsd_t)*rnx->n);
+        memcpy(rnx->data,buff,sizeof(obsd_t)*n);
+        nout=rnx->n;
+        *pos=rnx->pos;
+        rnx->n=n;
+        rnx->pos=pos0;
+        return nout;
+    }
+    if (rnx->n<0) return -1;
+    
+    /* output last epoch */
+    memcpy(data,rnx->data,sizeof(obsd_t)*rnx->n);
+    nout=rnx->n;
+    *pos=rnx->pos;
+    rnx->n=-1;
+    return nout;
+}
 /*------------------------------------------------------------------------------
 * output RINEX functions
 *-----------------------------------------------------------------------------*/
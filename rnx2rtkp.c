@@ -16,12 +16,14 @@
 *           2015/05/15  1.8 -r or -l options for fixed or ppp-fixed mode
 *           2015/06/12  1.9 output patch level in header
 *           2016/09/07  1.10 add option -sys
+*           2026/10/17  1.11 add option -j, -jn for batch jobs
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
 #include "rtklib.h"
 
 #define PROGNAME    "rnx2rtkp"          /* program name */
 #define MAXFILE     16                  /* max number of input files */
+#define MAXJOB      1024                /* max number of batch jobs */
 
 /* help text -----------------------------------------------------------------*/
 static const char *help[]={
@@ -71,7 +73,12 @@ static const char *help[]={
 " -l lat lon hgt reference (base) receiver latitude/longitude/height (deg/m)",
 "           rover latitude/longitude/height for fixed or ppp-fixed mode",
 " -y level  output soltion status (0:off,1:states,2:residuals) [0]",
-" -x level  debug trace level (0:off) [0]"
+" -x level  debug trace level (0:off) [0]",
+" -j file   batch jobs from job file [off]. each line of the file is",
+"           \"rover base outfile\" (base \"-\": none) ('#': comment). the keywords",
+"           %r and %b in input files and outfile are replaced by rover and",
+"           base. -o is ignored",
+" -jn n     number of threads for batch jobs [1]"
 };
 /* show message --------------------------------------------------------------*/
 /*extern int showmsg(const char* format, ...)
@@ -91,6 +98,33 @@ static void printhelp(void)
     for (i=0;i<(int)(sizeof(help)/sizeof(*help));i++) fprintf(stderr,"%s\n",help[i]);
     exit(0);
 }
+/* read batch jobs ----------------------------------------------------------*/
+static int readjobs(const char *file, ppjob_t *job, int nmax, gtime_t ts,
+                    gtime_t te, double ti, const prcopt_t *popt)
+{
+    FILE *fp;
+    char buff[2048],rov[64],base[64],out[1024];
+    int n=0;
+    
+    if (!(fp=fopen(file,"r"))) {
+        fprintf(stderr,"job file open error: %s\n",file);
+        return -1;
+    }
+    while (fgets(buff,sizeof(buff),fp)&&n<nmax) {
+        if (buff[0]=='#') continue;
+        if (sscanf(buff,"%63s %63s %1023s",rov,base,out)<3) continue;
+        job[n].ts=ts;
+        job[n].te=te;
+        job[n].ti=ti;
+        job[n].popt=*popt;
+        strcpy(job[n].rov,rov);
+        strcpy(job[n].base,strcmp(base,"-")?base:"");
+        strcpy(job[n].outfile,out);
+        job[n++].stat=0;
+    }
+    fclose(fp);
+    return n;
+}
 /* rnx2rtkp main -------------------------------------------------------------*/
 int main(int argc, char **argv)
 {
@@ -99,8 +133,9 @@ int main(int argc, char **argv)
     filopt_t filopt={""};
     gtime_t ts={0},te={0};
     double tint=0.0,es[]={2000,1,1,0,0,0},ee[]={2000,12,31,23,59,59},pos[3];
-    int i,j,n,ret;
-    char* infile[MAXFILE], * outfile = "";
+    int i,j,n,ret,njob,nthread=1;
+    char* infile[MAXFILE], * outfile = "", *jobfile = "";
+    ppjob_t *job;
     char *p;
     
     n = 2;
@@ -183,6 +218,8 @@ int main(int argc, char **argv)
         }
         else if (!strcmp(argv[i],"-y")&&i+1<argc) solopt.sstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-x")&&i+1<argc) solopt.trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-j")&&i+1<argc) jobfile=argv[++i];
+        else if (!strcmp(argv[i],"-jn")&&i+1<argc) nthread=atoi(argv[++i]);
         else if (*argv[i]=='-') printhelp();
         else if (n<MAXFILE) infile[n++]=argv[i];
     }
@@ -194,7 +231,21 @@ int main(int argc, char **argv)
         return -2;
     }
 	
-
+    if (*jobfile) {
+        if (!(job=(ppjob_t *)malloc(sizeof(ppjob_t)*MAXJOB))) return -1;
+        if ((njob=readjobs(jobfile,job,MAXJOB,ts,te,tint,&prcopt))<0) {
+            free(job);
+            return -1;
+        }
+        ret=postposbatch(job,njob,nthread,&prcopt,&solopt,&filopt,infile,n);
+        
+        for (i=0;i<njob;i++) {
+            fprintf(stderr,"%s %s %s stat=%d\n",job[i].rov,job[i].base,
+                    job[i].outfile,job[i].stat);
+        }
+        free(job);
+        return ret;
+    }
     ret=postpos(ts,te,tint,0.0,&prcopt,&solopt,&filopt,infile,n,outfile,"","");
     
     if (!ret) fprintf(stderr,"%40s\r","");
@@ -142,6 +142,16 @@
 *                           update obs code strings and priority table
 *                           use integer types in stdint.h
 *                           surppress warnings
+*           2026/10/17 1.46 add API pcvindex(),freepcv()
+*                           search antenna parameters by index in searchpcv()
+*                           split antenna type without strtok() in searchpcv()
+*                           add API initpcvtbl(),antmodeln()
+*           2026/10/17 1.47 delete static cache in eci2ecef() for thread-safety
+*                           add API eci2ecefc(),sunmoonposc(),eocinit(),
+*                           eoctable(),eocfree()
+*                           use thread-local buffer in time_str()
+*                           add API setmatbackend()
+*                           add API mapfile(),unmapfile()
 *-----------------------------------------------------------------------------*/
 #define _POSIX_C_SOURCE 199506
 #include <stdarg.h>
@@ -154,11 +164,21 @@
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
 #endif
 
 
 /* constants -----------------------------------------------------------------*/
 
+#ifdef WIN32
+#define THREADLOCAL __declspec(thread) /* thread-local storage */
+#else
+#define THREADLOCAL __thread
+#endif
+
 #define POLYCRC32   0xEDB88320u /* CRC32 polynomial */
 #define POLYCRC24Q  0x1864CFBu  /* CRC24Q polynomial */
 
@@ -1091,74 +1111,171 @@ extern void matcpy(double *A, const double *B, int n, int m)
 }
 /* matrix routines -----------------------------------------------------------*/
 
+#define MATBLK      64          /* block size of cache-blocked matmul */
+#define MAXSMALL    16          /* max size of small matrix with stack buffers */
+#define MATNTHRES   16          /* default size threshold for built-in loops */
+
+typedef void dgemm_t (char *, char *, int *, int *, int *, double *, double *,
+                      int *, double *, int *, double *, double *, int *);
+typedef void dgetrf_t(int *, int *, double *, int *, int *, int *);
+typedef void dgetri_t(int *, double *, int *, int *, double *, int *, int *);
+typedef void dgetrs_t(char *, int *, int *, double *, int *, int *, double *,
+                      int *, int *);
+
 #ifdef LAPACK /* with LAPACK/BLAS or MKL */
+static dgemm_t  *blas_dgemm =dgemm_;    /* BLAS/LAPACK entries */
+static dgetrf_t *blas_dgetrf=dgetrf_;
+static dgetri_t *blas_dgetri=dgetri_;
+static dgetrs_t *blas_dgetrs=dgetrs_;
+#define MATBE_BUILD MATBE_BLAS           /* matrix backend of build */
+#else
+static dgemm_t  *blas_dgemm =NULL;
+static dgetrf_t *blas_dgetrf=NULL;
+static dgetri_t *blas_dgetri=NULL;
+static dgetrs_t *blas_dgetrs=NULL;
+#define MATBE_BUILD MATBE_BUILTIN
+#endif
+static int mat_backend=MATBE_BUILD;     /* matrix backend (MATBE_???) */
+static int mat_nthres=MATNTHRES;        /* size threshold for built-in loops */
 
-/* multiply matrix (wrapper of blas dgemm) -------------------------------------
-* multiply matrix by matrix (C=alpha*A*B+beta*C)
-* args   : char   *tr       I  transpose flags ("N":normal,"T":transpose)
-*          int    n,k,m     I  size of (transposed) matrix A,B
-*          double alpha     I  alpha
-*          double *A,*B     I  (transposed) matrix A (n x m), B (m x k)
-*          double beta      I  beta
-*          double *C        IO matrix C (n x k)
-* return : none
-*-----------------------------------------------------------------------------*/
-extern void matmul(const char *tr, int n, int k, int m, double alpha,
-                   const double *A, const double *B, double beta, double *C)
+/* load external BLAS/LAPACK library -----------------------------------------*/
+static int loadblas(const char *lib)
 {
-    int lda=tr[0]=='T'?m:n,ldb=tr[1]=='T'?k:m;
+#ifdef WIN32
+    const char *libs[]={"libopenblas.dll","openblas.dll"};
+    HMODULE h=NULL;
+#else
+    const char *libs[]={"libopenblas.so.0","libopenblas.so"};
+    void *h=NULL;
+#endif
+    int i;
     
-    dgemm_((char *)tr,(char *)tr+1,&n,&k,&m,&alpha,(double *)A,&lda,(double *)B,
-           &ldb,&beta,C,&n);
+    if (blas_dgemm&&blas_dgetrf&&blas_dgetri&&blas_dgetrs) return 1;
+    
+    for (i=-1;i<2&&!h;i++) {
+        if (i<0&&(!lib||!*lib)) continue;
+#ifdef WIN32
+        h=LoadLibraryA(i<0?lib:libs[i]);
+#else
+        h=dlopen(i<0?lib:libs[i],RTLD_NOW|RTLD_LOCAL);
+#endif
+    }
+    if (!h) {
+        trace(2,"blas library load error: %s\n",lib&&*lib?lib:libs[0]);
+        return 0;
+    }
+#ifdef WIN32
+    *(FARPROC *)&blas_dgemm =GetProcAddress(h,"dgemm_");
+    *(FARPROC *)&blas_dgetrf=GetProcAddress(h,"dgetrf_");
+    *(FARPROC *)&blas_dgetri=GetProcAddress(h,"dgetri_");
+    *(FARPROC *)&blas_dgetrs=GetProcAddress(h,"dgetrs_");
+#else
+    *(void **)&blas_dgemm =dlsym(h,"dgemm_");
+    *(void **)&blas_dgetrf=dlsym(h,"dgetrf_");
+    *(void **)&blas_dgetri=dlsym(h,"dgetri_");
+    *(void **)&blas_dgetrs=dlsym(h,"dgetrs_");
+#endif
+    if (!blas_dgemm||!blas_dgetrf||!blas_dgetri||!blas_dgetrs) {
+        trace(2,"blas library no entry: %s\n",lib&&*lib?lib:libs[0]);
+        blas_dgemm=NULL; blas_dgetrf=NULL; blas_dgetri=NULL; blas_dgetrs=NULL;
+        return 0;
+    }
+    return 1;
 }
-/* inverse of matrix -----------------------------------------------------------
-* inverse of matrix (A=A^-1)
-* args   : double *A        IO  matrix (n x n)
-*          int    n         I   size of matrix A
-* return : status (0:ok,0>:error)
+/* set matrix backend ----------------------------------------------------------
+* select backend of matmul(), matinv() and solve() at run time
+* args   : int    backend   I   matrix backend
+*                                 MATBE_DEFAULT: default of build (MATBE_BLAS
+*                                                with -DLAPACK or -DMKL,
+*                                                otherwise MATBE_BUILTIN)
+*                                 MATBE_BUILTIN: built-in loops
+*                                 MATBE_BLOCKED: built-in cache-blocked kernel
+*                                 MATBE_BLAS   : external BLAS/LAPACK
+*          int    nthres    I   size threshold: if all of the matrix sizes are
+*                               under nthres, built-in loops are used
+*                               (0: default (16))
+*          char   *lib      I   BLAS/LAPACK library path for MATBE_BLAS
+*                               (NULL or "": libopenblas)
+* return : status (1:ok,0:error)
+* notes  : the backend is a process-wide setting. set it before starting any
+*          processing thread.
+*          if the library is linked with -DLAPACK or -DMKL, the linked
+*          BLAS/LAPACK is used for MATBE_BLAS and lib is ignored.
+*          the external library shall export dgemm_, dgetrf_, dgetri_ and
+*          dgetrs_ (fortran convention).
 *-----------------------------------------------------------------------------*/
-extern int matinv(double *A, int n)
+extern int setmatbackend(int backend, int nthres, const char *lib)
 {
-    double *work;
-    int info,lwork=n*16,*ipiv=imat(n,1);
+    trace(3,"setmatbackend: backend=%d nthres=%d\n",backend,nthres);
     
-    work=mat(lwork,1);
-    dgetrf_(&n,&n,A,&n,ipiv,&info);
-    if (!info) dgetri_(&n,A,&n,ipiv,work,&lwork,&info);
-    free(ipiv); free(work);
-    return info;
+    if (backend<MATBE_DEFAULT||backend>MATBE_BLAS) return 0;
+    if (backend==MATBE_DEFAULT) backend=MATBE_BUILD;
+    if (backend==MATBE_BLAS&&!loadblas(lib)) return 0;
+    mat_backend=backend;
+    mat_nthres=nthres<=0?MATNTHRES:nthres;
+    return 1;
 }
-/* solve linear equation -------------------------------------------------------
-* solve linear equation (X=A\Y or X=A'\Y)
-* args   : char   *tr       I   transpose flag ("N":normal,"T":transpose)
-*          double *A        I   input matrix A (n x n)
-*          double *Y        I   input matrix Y (n x m)
-*          int    n,m       I   size of matrix A,Y
-*          double *X        O   X=A\Y or X=A'\Y (n x m)
-* return : status (0:ok,0>:error)
-* notes  : matirix stored by column-major order (fortran convention)
-*          X can be same as Y
-*-----------------------------------------------------------------------------*/
-extern int solve(const char *tr, const double *A, const double *Y, int n,
-                 int m, double *X)
+/* select matrix backend by size ---------------------------------------------*/
+static int matsel(int n, int k, int m)
 {
-    double *B=mat(n,n);
-    int info,*ipiv=imat(n,1);
+    if (n<mat_nthres&&k<mat_nthres&&m<mat_nthres) return MATBE_BUILTIN;
+    return mat_backend;
+}
+/* multiply matrix (wrapper of blas dgemm) -----------------------------------*/
+static void matmul_blas(const char *tr, int n, int k, int m, double alpha,
+                        const double *A, const double *B, double beta,
+                        double *C)
+{
+    int lda=tr[0]=='T'?m:n,ldb=tr[1]=='T'?k:m;
     
-    matcpy(B,A,n,n);
-    matcpy(X,Y,n,m);
-    dgetrf_(&n,&n,B,&n,ipiv,&info);
-    if (!info) dgetrs_((char *)tr,&n,&m,B,&n,ipiv,X,&n,&info);
-    free(ipiv); free(B); 
-    return info;
+    blas_dgemm((char *)tr,(char *)tr+1,&n,&k,&m,&alpha,(double *)A,&lda,
+               (double *)B,&ldb,&beta,C,&n);
+}
+/* multiply matrix by cache-blocked kernel -----------------------------------*/
+static void matmul_blk(const char *tr, int n, int k, int m, double alpha,
+                       const double *A, const double *B, double beta,
+                       double *C)
+{
+    static THREADLOCAL double Ap[MATBLK*MATBLK],Bp[MATBLK*MATBLK];
+    double b,*c;
+    const double *a;
+    int i,j,p,i0,j0,p0,ni,nj,np;
+    
+    for (i=0;i<n*k;i++) C[i]=beta==0.0?0.0:beta*C[i];
+    
+    for (p0=0;p0<m;p0+=MATBLK) {
+        np=m-p0<MATBLK?m-p0:MATBLK;
+        for (j0=0;j0<k;j0+=MATBLK) {
+            nj=k-j0<MATBLK?k-j0:MATBLK;
+            
+            /* pack alpha*B(p0:,j0:) by column */
+            for (j=0;j<nj;j++) for (p=0;p<np;p++) {
+                Bp[p+j*np]=alpha*(tr[1]=='N'?B[p0+p+(j0+j)*m]:B[j0+j+(p0+p)*k]);
+            }
+            for (i0=0;i0<n;i0+=MATBLK) {
+                ni=n-i0<MATBLK?n-i0:MATBLK;
+                
+                /* pack A(i0:,p0:) by column */
+                for (p=0;p<np;p++) for (i=0;i<ni;i++) {
+                    Ap[i+p*ni]=tr[0]=='N'?A[i0+i+(p0+p)*n]:A[p0+p+(i0+i)*m];
+                }
+                /* C(i0:,j0:)+=Ap*Bp with contiguous inner loop */
+                for (j=0;j<nj;j++) {
+                    c=C+i0+(j0+j)*n;
+                    for (p=0;p<np;p++) {
+                        a=Ap+p*ni; b=Bp[p+j*np];
+                        for (i=0;i<ni;i++) c[i]+=a[i]*b;
+                    }
+                }
+            }
+        }
+    }
 }
-
-#else /* without LAPACK/BLAS or MKL */
-
 /* multiply matrix ˷,NNʾת,NTʾһתڶת,Դ-*/
 /*ЧΪ C=alpha*A*B+beta*C  n:һ m:һлڶ k:ڶ*/
-extern void matmul(const char *tr, int n, int k, int m, double alpha,
-                   const double *A, const double *B, double beta, double *C)
+static void matmul_loop(const char *tr, int n, int k, int m, double alpha,
+                        const double *A, const double *B, double beta,
+                        double *C)
 {
     double d;
     int i,j,x,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
@@ -1174,16 +1291,84 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
         if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
     }
 }
-/* LU decomposition ----------------------------------------------------------*/
-static int ludcmp(double *A, int n, int *indx, double *d)
+/* multiply matrix -------------------------------------------------------------
+* multiply matrix by matrix (C=alpha*A*B+beta*C)
+* args   : char   *tr       I  transpose flags ("N":normal,"T":transpose)
+*          int    n,k,m     I  size of (transposed) matrix A,B
+*          double alpha     I  alpha
+*          double *A,*B     I  (transposed) matrix A (n x m), B (m x k)
+*          double beta      I  beta
+*          double *C        IO matrix C (n x k)
+* return : none
+* notes  : the backend is selected by setmatbackend()
+*-----------------------------------------------------------------------------*/
+extern void matmul(const char *tr, int n, int k, int m, double alpha,
+                   const double *A, const double *B, double beta, double *C)
+{
+    switch (matsel(n,k,m)) {
+        case MATBE_BLAS   : matmul_blas(tr,n,k,m,alpha,A,B,beta,C); return;
+        case MATBE_BLOCKED: matmul_blk (tr,n,k,m,alpha,A,B,beta,C); return;
+    }
+    matmul_loop(tr,n,k,m,alpha,A,B,beta,C);
+}
+/* multiply 3x3 matrices -------------------------------------------------------
+* multiply 3x3 matrix by 3x3 matrix (C=A*B)
+* args   : char   *tr       I  transpose flags ("N":normal,"T":transpose)
+*          double *A,*B     I  (transposed) matrix A, B (3 x 3)
+*          double *C        O  matrix C (3 x 3)
+* return : none
+* notes  : same as matmul(tr,3,3,3,1.0,A,B,0.0,C) with fixed size unrolled
+*          C shall not be same as A or B
+*-----------------------------------------------------------------------------*/
+extern void matmul3(const char *tr, const double *A, const double *B, double *C)
+{
+    double a[9],b[9];
+    int i,j;
+    
+    for (i=0;i<3;i++) for (j=0;j<3;j++) {
+        a[i+j*3]=tr[0]=='N'?A[i+j*3]:A[j+i*3];
+        b[i+j*3]=tr[1]=='N'?B[i+j*3]:B[j+i*3];
+    }
+    for (j=0;j<9;j+=3) {
+        C[j  ]=a[0]*b[j]+a[3]*b[j+1]+a[6]*b[j+2];
+        C[j+1]=a[1]*b[j]+a[4]*b[j+1]+a[7]*b[j+2];
+        C[j+2]=a[2]*b[j]+a[5]*b[j+1]+a[8]*b[j+2];
+    }
+}
+/* multiply 3x3 matrix by vector -----------------------------------------------
+* multiply 3x3 matrix by 3d vector (c=A*b)
+* args   : char   *tr       I  transpose flag ("N":normal,"T":transpose)
+*          double *A        I  (transposed) matrix A (3 x 3)
+*          double *b        I  vector b (3 x 1)
+*          double *c        O  vector c (3 x 1)
+* return : none
+* notes  : same as matmul(tr[0]=='N'?"NN":"TN",3,1,3,1.0,A,b,0.0,c)
+*          c shall not be same as b
+*-----------------------------------------------------------------------------*/
+extern void matmul3v(const char *tr, const double *A, const double *b,
+                     double *c)
+{
+    if (tr[0]=='N') {
+        c[0]=A[0]*b[0]+A[3]*b[1]+A[6]*b[2];
+        c[1]=A[1]*b[0]+A[4]*b[1]+A[7]*b[2];
+        c[2]=A[2]*b[0]+A[5]*b[1]+A[8]*b[2];
+    }
+    else {
+        c[0]=A[0]*b[0]+A[1]*b[1]+A[2]*b[2];
+        c[1]=A[3]*b[0]+A[4]*b[1]+A[5]*b[2];
+        c[2]=A[6]*b[0]+A[7]*b[1]+A[8]*b[2];
+    }
+}
+/* LU decomposition (vv: work array n x 1) -----------------------------------*/
+static int ludcmp(double *A, int n, int *indx, double *d, double *vv)
 {
-    double big,s,tmp,*vv=mat(n,1);
+    double big,s,tmp;
     int i,imax=0,j,k;
     
     *d=1.0;
     for (i=0;i<n;i++) {
         big=0.0; for (j=0;j<n;j++) if ((tmp=fabs(A[i+j*n]))>big) big=tmp;
-        if (big>0.0) vv[i]=1.0/big; else {free(vv); return -1;}
+        if (big>0.0) vv[i]=1.0/big; else return -1;
     }
     for (j=0;j<n;j++) {
         for (i=0;i<j;i++) {
@@ -1201,12 +1386,11 @@ static int ludcmp(double *A, int n, int *indx, double *d)
             *d=-(*d); vv[imax]=vv[j];
         }
         indx[j]=imax;
-        if (A[j+j*n]==0.0) {free(vv); return -1;}
+        if (A[j+j*n]==0.0) return -1;
         if (j!=n-1) {
             tmp=1.0/A[j+j*n]; for (i=j+1;i<n;i++) A[i+j*n]*=tmp;
         }
     }
-    free(vv);
     return 0;
 }
 /* LU back-substitution ------------------------------------------------------*/
@@ -1224,37 +1408,176 @@ static void lubksb(const double *A, int n, const int *indx, double *b)
         s=b[i]; for (j=i+1;j<n;j++) s-=A[i+j*n]*b[j]; b[i]=s/A[i+i*n];
     }
 }
-/* inverse of matrix ---------------------------------------------------------*/
-extern int matinv(double *A, int n)
+/* inverse of matrix with work arrays (work: n x (n+16), indx: n x 1) --------*/
+static int matinv_(double *A, int n, int *indx, double *work)
 {
-    double d,*B;
-    int i,j,*indx;
+    double d,*B=work,*vv=work+n*n;
+    int i,j,info,lwork=n*16;
     
-    indx=imat(n,1); B=mat(n,n); matcpy(B,A,n,n);
-    if (ludcmp(B,n,indx,&d)) {free(indx); free(B); return -1;}
+    if (matsel(n,n,n)==MATBE_BLAS) {
+        blas_dgetrf(&n,&n,A,&n,indx,&info);
+        if (!info) blas_dgetri(&n,A,&n,indx,work,&lwork,&info);
+        return info;
+    }
+    matcpy(B,A,n,n);
+    if (ludcmp(B,n,indx,&d,vv)) return -1;
     for (j=0;j<n;j++) {
         for (i=0;i<n;i++) A[i+j*n]=0.0;
         A[j+j*n]=1.0;
         lubksb(B,n,indx,A+j*n);
     }
-    free(indx); free(B);
     return 0;
 }
-/* solve linear equation -----------------------------------------------------*/
+/* inverse of matrix -----------------------------------------------------------
+* inverse of matrix (A=A^-1)
+* args   : double *A        IO  matrix (n x n)
+*          int    n         I   size of matrix A
+* return : status (0:ok,0>:error)
+*-----------------------------------------------------------------------------*/
+extern int matinv(double *A, int n)
+{
+    double *work,buff[MAXSMALL*(MAXSMALL+16)];
+    int info,*indx,ibuff[MAXSMALL];
+    
+    if (n<=MAXSMALL) return matinv_(A,n,ibuff,buff);
+    
+    work=mat(n,n+16); indx=imat(n,1);
+    info=matinv_(A,n,indx,work);
+    free(indx); free(work);
+    return info;
+}
+/* 1-norm of matrix ----------------------------------------------------------*/
+static double matnorm1(const double *A, int n)
+{
+    double s,smax=0.0;
+    int i,j;
+    
+    for (j=0;j<n;j++) {
+        for (i=0,s=0.0;i<n;i++) s+=fabs(A[i+j*n]);
+        if (s>smax) smax=s;
+    }
+    return smax;
+}
+/* inverse of spd matrix with work arrays (work: n x (n+16), indx: n x 1) ----*/
+static int matinvspd_(double *A, int n, int *indx, double *work, double *cond)
+{
+    double *L=work,s,anorm=0.0;
+    int i,j,k,info=0;
+    
+    if (cond) anorm=matnorm1(A,n);
+    
+    /* cholesky decomposition: A=L*L' */
+    for (j=0;j<n;j++) {
+        s=A[j+j*n]; for (k=0;k<j;k++) s-=L[j+k*n]*L[j+k*n];
+        if (s<=0.0) {info=-1; break;}
+        L[j+j*n]=sqrt(s);
+        for (i=j+1;i<n;i++) {
+            s=A[i+j*n]; for (k=0;k<j;k++) s-=L[i+k*n]*L[j+k*n];
+            L[i+j*n]=s/L[j+j*n];
+        }
+    }
+    if (info) { /* not positive definite: fallback to LU decomposition */
+        trace(4,"matinvspd: not positive definite n=%d\n",n);
+        info=matinv_(A,n,indx,work);
+    }
+    else {
+        /* L=L^-1 in place */
+        for (j=0;j<n;j++) {
+            L[j+j*n]=1.0/L[j+j*n];
+            for (i=j+1;i<n;i++) {
+                s=0.0; for (k=j;k<i;k++) s-=L[i+k*n]*L[k+j*n];
+                L[i+j*n]=s/L[i+i*n];
+            }
+        }
+        /* A^-1=L^-T*L^-1 */
+        for (j=0;j<n;j++) for (i=0;i<=j;i++) {
+            s=0.0; for (k=j;k<n;k++) s+=L[k+i*n]*L[k+j*n];
+            A[i+j*n]=A[j+i*n]=s;
+        }
+    }
+    if (cond) *cond=info?0.0:anorm*matnorm1(A,n);
+    return info;
+}
+/* inverse of symmetric positive definite matrix -------------------------------
+* inverse of symmetric positive definite matrix by cholesky decomposition
+* (A=A^-1)
+* args   : double *A        IO  symmetric positive definite matrix (n x n)
+*          int    n         I   size of matrix A
+*          double *cond     O   condition number in 1-norm (NULL: no output)
+*                               (0.0: singular)
+* return : status (0:ok,0>:error)
+* notes  : about a third of the operations of matinv()
+*          if A is not numerically positive definite, it falls back to LU
+*          decomposition as matinv()
+*-----------------------------------------------------------------------------*/
+extern int matinvspd(double *A, int n, double *cond)
+{
+    double *work,buff[MAXSMALL*(MAXSMALL+16)];
+    int info,*indx,ibuff[MAXSMALL];
+    
+    if (n<=MAXSMALL) return matinvspd_(A,n,ibuff,buff,cond);
+    
+    work=mat(n,n+16); indx=imat(n,1);
+    info=matinvspd_(A,n,indx,work,cond);
+    free(indx); free(work);
+    return info;
+}
+/* solve linear equation -------------------------------------------------------
+* solve linear equation (X=A\Y or X=A'\Y)
+* args   : char   *tr       I   transpose flag ("N":normal,"T":transpose)
+*          double *A        I   input matrix A (n x n)
+*          double *Y        I   input matrix Y (n x m)
+*          int    n,m       I   size of matrix A,Y
+*          double *X        O   X=A\Y or X=A'\Y (n x m)
+* return : status (0:ok,0>:error)
+* notes  : matirix stored by column-major order (fortran convention)
+*          X can be same as Y
+*-----------------------------------------------------------------------------*/
 extern int solve(const char *tr, const double *A, const double *Y, int n,
                  int m, double *X)
 {
     double *B=mat(n,n);
-    int info;
+    int info,*ipiv;
     
     matcpy(B,A,n,n);
-    if (!(info=matinv(B,n))) matmul(tr[0]=='N'?"NN":"TN",n,m,n,1.0,B,Y,0.0,X);
+    if (matsel(n,m,n)==MATBE_BLAS) {
+        ipiv=imat(n,1);
+        matcpy(X,Y,n,m);
+        blas_dgetrf(&n,&n,B,&n,ipiv,&info);
+        if (!info) blas_dgetrs((char *)tr,&n,&m,B,&n,ipiv,X,&n,&info);
+        free(ipiv);
+    }
+    else if (!(info=matinv(B,n))) {
+        matmul(tr[0]=='N'?"NN":"TN",n,m,n,1.0,B,Y,0.0,X);
+    }
     free(B);
     return info;
 }
-#endif
 /* end of matrix routines ----------------------------------------------------*/
 
+/* least square estimation for small number of parameters --------------------*/
+static int lsq_small(const double *A, const double *y, int n, int m,
+                     double *x, double *Q)
+{
+    double Ay[MAXSMALL],work[MAXSMALL*(MAXSMALL+16)],d,cond;
+    int i,j,k,info,indx[MAXSMALL];
+    
+    for (i=0;i<n;i++) {
+        d=0.0; for (k=0;k<m;k++) d+=A[i+k*n]*y[k];
+        Ay[i]=d;
+        for (j=i;j<n;j++) { /* Q=A*A' by upper triangle */
+            d=0.0; for (k=0;k<m;k++) d+=A[i+k*n]*A[j+k*n];
+            Q[i+j*n]=Q[j+i*n]=d;
+        }
+    }
+    if ((info=matinvspd_(Q,n,indx,work,&cond))) return info;
+    trace(5,"lsq: n=%d m=%d cond=%.3e\n",n,m,cond);
+    for (i=0;i<n;i++) {
+        d=0.0; for (k=0;k<n;k++) d+=Q[i+k*n]*Ay[k];
+        x[i]=d;
+    }
+    return 0;
+}
 /* least square estimation -----------------------------------------------------
 * least square estimation by solving normal equation (x=(A*A')^-1*A*y)
 * args   : double *A        I   transpose of (weighted) design matrix (n x m)
@@ -1265,18 +1588,23 @@ extern int solve(const char *tr, const double *A, const double *Y, int n,
 * return : status (0:ok,0>:error)
 * notes  : for weighted least square, replace A and y by A*w and w*y (w=W^(1/2))
 *          matirix stored by column-major order (fortran convention)
+*          normal matrix A*A' is inverted by cholesky decomposition
 *-----------------------------------------------------------------------------*/
 extern int lsq(const double *A, const double *y, int n, int m, double *x,
                double *Q)
 {
-    double *Ay;
+    double *Ay,cond;
     int info;
     
     if (m<n) return -1;
+    if (n<=MAXSMALL) return lsq_small(A,y,n,m,x,Q);
     Ay=mat(n,1);
     matmul("NN",n,1,m,1.0,A,y,0.0,Ay); /* Ay=A*y (BPL)*/
     matmul("NT",n,n,m,1.0,A,A,0.0,Q);  /* Q=A*A' (B^ PB)*/
-    if (!(info=matinv(Q,n))) matmul("NN",n,1,n,1.0,Q,Ay,0.0,x); /* x=Q^-1*Ay */
+    if (!(info=matinvspd(Q,n,&cond))) {
+        trace(5,"lsq: n=%d m=%d cond=%.3e\n",n,m,cond);
+        matmul("NN",n,1,n,1.0,Q,Ay,0.0,x); /* x=Q^-1*Ay */
+    }
     free(Ay);
     return info;
 }
@@ -1297,49 +1625,193 @@ extern int lsq(const double *A, const double *y, int n, int m, double *x,
 * notes  : matirix stored by column-major order (fortran convention)
 *          if state x[i]==0.0, not updates state x[i]/P[i+i*n]
 *-----------------------------------------------------------------------------*/
+/* symmetric covariance update (upper triangle of Pp) ------------------------*/
+static void symupd(const double *P, const double *F, const double *K,
+                   const double *G, int n, int m, double *Pp)
+{
+    double f,k;
+    int i,j,l;
+    
+    /* Pp=P-K*F' (F=P*H=(H'*P)') */
+    for (j=0;j<n;j++) {
+        for (i=0;i<=j;i++) Pp[i+j*n]=P[i+j*n];
+        for (l=0;l<m;l++) {
+            f=F[j+l*n];
+            for (i=0;i<=j;i++) Pp[i+j*n]-=K[i+l*n]*f;
+        }
+    }
+    if (!G) return;
+    
+    /* Joseph form: Pp=(I-K*H')*P*(I-K*H')'+K*R*K'=P-K*F'-F*K'+(K*S)*K' */
+    for (j=0;j<n;j++) for (l=0;l<m;l++) {
+        k=K[j+l*n];
+        for (i=0;i<=j;i++) Pp[i+j*n]+=(G[i+l*n]-F[i+l*n])*k;
+    }
+}
+/* F=P*H and Q=H'*F+Q with column-sparse H (nzi[nzp[j]:nzp[j+1]-1]: non-zero
+   row indices of H(:,j) in ascending order) ---------------------------------*/
+static void sparsemul(const double *P, const double *H, int n, int m,
+                      const int *nzp, const int *nzi, double *F, double *Q)
+{
+    double d,h,*f;
+    const double *p;
+    int i,j,k,l;
+    
+    for (j=0;j<m;j++) {
+        f=F+j*n;
+        for (i=0;i<n;i++) f[i]=0.0;
+        for (k=nzp[j];k<nzp[j+1];k++) {
+            p=P+nzi[k]*n; h=H[nzi[k]+j*n];
+            for (i=0;i<n;i++) f[i]+=p[i]*h;
+        }
+    }
+    for (j=0;j<m;j++) for (i=0;i<m;i++) {
+        d=0.0;
+        for (k=nzp[i];k<nzp[i+1];k++) {
+            l=nzi[k]; d+=H[l+i*n]*F[l+j*n];
+        }
+        Q[i+j*m]+=d;
+    }
+}
 static int filter_(const double *x, const double *P, const double *H,
-                   const double *v, const double *R, int n, int m,
-                   double *xp, double *Pp)
+                   const double *v, const double *R, int n, int m, int mode,
+                   const int *nzp, const int *nzi, double *xp, double *Pp,
+                   double *work, int *iwork)
 {
-    double *F=mat(n,m),*Q=mat(m,m),*K=mat(n,m),*I=eye(n);
-    int info;
+    double *F=work,*Q=F+n*m,*K=Q+m*m,*I=K+n*m,*W=I+n*n,*S=W+m*(m+16),*G=S+m*m;
+    int i,info;
     
     matcpy(Q,R,m,m);
     matcpy(xp,x,n,1);
-    matmul("NN",n,m,n,1.0,P,H,0.0,F);       /* Q=H'*P*H+R */
-    matmul("TN",m,m,n,1.0,H,F,1.0,Q);
-    if (!(info=matinv(Q,m))) {
+    if (nzp) {
+        sparsemul(P,H,n,m,nzp,nzi,F,Q);     /* Q=H'*P*H+R (sparse H) */
+    }
+    else {
+        matmul("NN",n,m,n,1.0,P,H,0.0,F);   /* Q=H'*P*H+R */
+        matmul("TN",m,m,n,1.0,H,F,1.0,Q);
+    }
+    if (mode==KFOPT_JOSEPH) matcpy(S,Q,m,m);
+    
+    /* Q=(H'*P*H+R)^-1 (cholesky decomposition for symmetric update modes) */
+    if (mode==KFOPT_STD) info=matinv_(Q,m,iwork,W);
+    else info=matinvspd_(Q,m,iwork,W,NULL);
+    if (!info) {
         matmul("NN",n,m,m,1.0,F,Q,0.0,K);   /* K=P*H*Q^-1 */
         matmul("NN",n,1,m,1.0,K,v,1.0,xp);  /* xp=x+K*v */
-        matmul("NT",n,n,m,-1.0,K,H,1.0,I);  /* Pp=(I-K*H')*P */
-        matmul("NN",n,n,n,1.0,I,P,0.0,Pp);
+        if (mode==KFOPT_SYM) {
+            symupd(P,F,K,NULL,n,m,Pp);      /* Pp=P-K*(H'*P) */
+        }
+        else if (mode==KFOPT_JOSEPH) {
+            matmul("NN",n,m,m,1.0,K,S,0.0,G);
+            symupd(P,F,K,G,n,m,Pp);
+        }
+        else {
+            for (i=0;i<n*n;i++) I[i]=0.0;
+            for (i=0;i<n;i++) I[i+i*n]=1.0;
+            matmul("NT",n,n,m,-1.0,K,H,1.0,I);  /* Pp=(I-K*H')*P */
+            matmul("NN",n,n,n,1.0,I,P,0.0,Pp);
+        }
     }
-    free(F); free(Q); free(K); free(I);
     return info;
 }
 extern int filter(double *x, double *P, const double *H, const double *v,
                   const double *R, int n, int m)
+{
+    filtws_t ws={0};
+    int info;
+    
+    info=filterws(x,P,H,v,R,n,m,&ws);
+    freefiltws(&ws);
+    return info;
+}
+/* free kalman filter workspace ------------------------------------------------
+* free memory of kalman filter workspace
+* args   : filtws_t *ws     IO  kalman filter workspace
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freefiltws(filtws_t *ws)
+{
+    free(ws->d); ws->d=NULL; ws->nd=0;
+    free(ws->i); ws->i=NULL; ws->ni=0;
+}
+/* reserve kalman filter workspace -------------------------------------------*/
+static void reservews(filtws_t *ws, int nd, int ni)
+{
+    if (nd>ws->nd) {
+        free(ws->d); ws->d=mat(nd,1); ws->nd=nd;
+    }
+    if (ni>ws->ni) {
+        free(ws->i); ws->i=imat(ni,1); ws->ni=ni;
+    }
+}
+/* kalman filter with workspace ------------------------------------------------
+* kalman filter state update same as filter() with caller-owned workspace
+* args   : double *x        IO  states vector (n x 1)
+*          double *P        IO  covariance matrix of states (n x n)
+*          double *H        I   transpose of design matrix (n x m)
+*          double *v        I   innovation (measurement - model) (m x 1)
+*          double *R        I   covariance matrix of measurement error (m x m)
+*          int    n,m       I   number of states and measurements
+*          filtws_t *ws     IO  kalman filter workspace (zero-initialized or
+*                               previously used)
+*            ws->mode       I   covariance update mode
+*                               KFOPT_STD   : Pp=(I-K*H')*P
+*                               KFOPT_SYM   : Pp=P-K*(H'*P)
+*                               KFOPT_JOSEPH: Pp=(I-K*H')*P*(I-K*H')'+K*R*K'
+* return : status (0:ok,<0:error)
+* notes  : the workspace grows on demand and is reused across calls, so no
+*          memory is allocated once it has reached the size of the largest
+*          update. with KFOPT_STD, results are identical to filter().
+*          KFOPT_SYM and KFOPT_JOSEPH compute only the upper triangle of Pp in
+*          O(n^2*m) instead of O(n^3) and return an exactly symmetric P.
+*          they also invert H'*P*H+R by cholesky decomposition.
+*          if H is sparse as in the double-differenced or undifferenced
+*          phase measurements (position/iono/trop block plus one or two
+*          bias states per column), P*H and H'*P*H are formed only from the
+*          non-zero elements of H in O(n*nnz). the summation order is kept,
+*          so this does not change the results.
+*          free the workspace by freefiltws().
+*-----------------------------------------------------------------------------*/
+extern int filterws(double *x, double *P, const double *H, const double *v,
+                    const double *R, int n, int m, filtws_t *ws)
 {
     double *x_,*xp_,*P_,*Pp_,*H_;
-    int i,j,k,info,*ix;
+    int i,j,k,nnz,info,*ix,*nzp,*nzi;
     
     /* create list of non-zero states */
-    ix=imat(n,1); for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) ix[k++]=i;
-    x_=mat(k,1); xp_=mat(k,1); P_=mat(k,k); Pp_=mat(k,k); H_=mat(k,m);
+    for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) k++;
+    reservews(ws,2*k+3*k*k+4*k*m+2*m*m+m*(m+16),n+2*m+1+k*m);
+    ix=ws->i; nzp=ix+n+m; nzi=nzp+m+1;
+    for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) ix[k++]=i;
+    x_=ws->d; xp_=x_+k; P_=xp_+k; Pp_=P_+k*k; H_=Pp_+k*k;
     /* compress array by removing zero elements to save computation time */
     for (i=0;i<k;i++) {
         x_[i]=x[ix[i]];
         for (j=0;j<k;j++) P_[i+j*k]=P[ix[i]+ix[j]*n];
         for (j=0;j<m;j++) H_[i+j*k]=H[ix[i]+j*n];
     }
+    /* index non-zero elements of design matrix by column */
+    for (j=nnz=0;j<m;j++) {
+        nzp[j]=nnz;
+        for (i=0;i<k;i++) if (H_[i+j*k]!=0.0) nzi[nnz++]=i;
+    }
+    nzp[m]=nnz;
+    
     /* do kalman filter state update on compressed arrays */
-    info=filter_(x_,P_,H_,v,R,k,m,xp_,Pp_);
+    info=filter_(x_,P_,H_,v,R,k,m,ws->mode,nnz*2<k*m?nzp:NULL,nzi,xp_,Pp_,
+                 H_+k*m,ix+n);
+    if (info) return info;
+    
     /* copy values from compressed arrays back to full arrays */
     for (i=0;i<k;i++) {
         x[ix[i]]=xp_[i];
-        for (j=0;j<k;j++) P[ix[i]+ix[j]*n]=Pp_[i+j*k];
+        if (ws->mode==KFOPT_STD) {
+            for (j=0;j<k;j++) P[ix[i]+ix[j]*n]=Pp_[i+j*k];
+        }
+        else {
+            for (j=i;j<k;j++) P[ix[i]+ix[j]*n]=P[ix[j]+ix[i]*n]=Pp_[i+j*k];
+        }
     }
-    free(ix); free(x_); free(xp_); free(P_); free(Pp_); free(H_);
     return info;
 }
 /* smoother --------------------------------------------------------------------
@@ -1356,25 +1828,35 @@ extern int filter(double *x, double *P, const double *H, const double *v,
 *          double *Qs       O   smoothed solutions covariance matrix (n x n)
 * return : status (0:ok,0>:error)
 * notes  : see reference [4] 5.2
+*          covariance matrices are inverted by cholesky decomposition
 *          matirix stored by column-major order (fortran convention)
 *-----------------------------------------------------------------------------*/
 extern int smoother(const double *xf, const double *Qf, const double *xb,
                     const double *Qb, int n, double *xs, double *Qs)
 {
-    double *invQf=mat(n,n),*invQb=mat(n,n),*xx=mat(n,1);
+    double *invQf,*invQb,*xx,buff[MAXSMALL*(2*MAXSMALL+1)],condf,condb;
     int i,info=-1;
     
+    if (n<=MAXSMALL) {
+        invQf=buff; invQb=buff+n*n; xx=buff+2*n*n;
+    }
+    else {
+        invQf=mat(n,n); invQb=mat(n,n); xx=mat(n,1);
+    }
     matcpy(invQf,Qf,n,n);
     matcpy(invQb,Qb,n,n);
-    if (!matinv(invQf,n)&&!matinv(invQb,n)) {
+    if (!matinvspd(invQf,n,&condf)&&!matinvspd(invQb,n,&condb)) {
+        trace(5,"smoother: n=%d condf=%.3e condb=%.3e\n",n,condf,condb);
         for (i=0;i<n*n;i++) Qs[i]=invQf[i]+invQb[i];
-        if (!(info=matinv(Qs,n))) {
+        if (!(info=matinvspd(Qs,n,NULL))) {
             matmul("NN",n,1,n,1.0,invQf,xf,0.0,xx);
             matmul("NN",n,1,n,1.0,invQb,xb,1.0,xx);
             matmul("NN",n,1,n,1.0,Qs,xx,0.0,xs);
         }
     }
-    free(invQf); free(invQb); free(xx);
+    if (n>MAXSMALL) {
+        free(invQf); free(invQb); free(xx);
+    }
     return info;
 }
 /* print matrix ----------------------------------------------------------------
@@ -1833,11 +2315,11 @@ extern void time2str(gtime_t t, char *s, int n)
 * args   : gtime_t t        I   gtime_t struct
 *          int    n         I   number of decimals
 * return : time string
-* notes  : not reentrant, do not use multiple in a function
+* notes  : the buffer is thread-local. do not use multiple in a function
 *-----------------------------------------------------------------------------*/
 extern char *time_str(gtime_t t, int n)
 {
-    static char buff[64];
+    static THREADLOCAL char buff[64];
     time2str(t,buff,n);
     return buff;
 }
@@ -2020,7 +2502,7 @@ extern void ecef2enu(const double *pos, const double *r, double *e)
     double E[9];
     
     xyz2enu(pos,E);
-    matmul("NN",3,1,3,1.0,E,r,0.0,e);
+    matmul3v("N",E,r,e);
 }
 /* transform local vector to ecef coordinate -----------------------------------
 * transform local tangental coordinate vector to ecef
@@ -2034,7 +2516,7 @@ extern void enu2ecef(const double *pos, const double *e, double *r)
     double E[9];
     
     xyz2enu(pos,E);
-    matmul("TN",3,1,3,1.0,E,e,0.0,r);
+    matmul3v("T",E,e,r);
 }
 /* transform covariance to local tangental coordinate --------------------------
 * transform ecef covariance to local tangental coordinate
@@ -2054,12 +2536,12 @@ extern void covenu(const double *pos, const double *P, double *Q)
     double E[9],EP[9];
     
     xyz2enu(pos,E);
-    matmul("NN",3,3,3,1.0,E,P,0.0,EP);
+    matmul3("NN",E,P,EP);
     /*ݸĲδʵ˶ԴСΪ3x3ľEP;Pͨ˵Ĳ洢ھQС
     //NTʾNTʾһתڶת
     //alphaΪ1.0Խš
     //betaΪ0.0ʾCԭеۼӳ˻ϵΪ0ֻ洢¼ĳ˻*/
-    matmul("NT",3,3,3,1.0,EP,E,0.0,Q);
+    matmul3("NT",EP,E,Q);
 }
 /* transform local enu coordinate covariance to xyz-ecef -----------------------
 * transform local enu covariance to xyz-ecef coordinate
@@ -2073,8 +2555,8 @@ extern void covecef(const double *pos, const double *Q, double *P)
     double E[9],EQ[9];
     
     xyz2enu(pos,E);
-    matmul("TN",3,3,3,1.0,E,Q,0.0,EQ);
-    matmul("NN",3,3,3,1.0,EQ,E,0.0,P);
+    matmul3("TN",E,Q,EQ);
+    matmul3("NN",EQ,E,P);
 }
 /* coordinate rotation matrix ------------------------------------------------*/
 #define Rx(t,X) do { \
@@ -2237,38 +2719,16 @@ static void nut_iau1980(double t, const double *f, double *dpsi, double *deps)
     *dpsi*=1E-4*AS2R; /* 0.1 mas -> rad */
     *deps*=1E-4*AS2R;
 }
-/* eci to ecef transformation matrix -------------------------------------------
-* compute eci to ecef transformation matrix
-* args   : gtime_t tutc     I   time in utc
-*          double *erpv     I   erp values {xp,yp,ut1_utc,lod} (rad,rad,s,s/d)
-*          double *U        O   eci to ecef transformation matrix (3 x 3)
-*          double *gmst     IO  greenwich mean sidereal time (rad)
-*                               (NULL: no output)
-* return : none
-* note   : see ref [3] chap 5
-*          not thread-safe
-*-----------------------------------------------------------------------------*/
-extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
+/* precession and nutation ---------------------------------------------------*/
+static void prenut(gtime_t tutc, double *NP, double *eqe)
 {
     const double ep2000[]={2000,1,1,12,0,0};
-    static gtime_t tutc_;
-    static double U_[9],gmst_;
     gtime_t tgps;
-    double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,f[5];
-    double R1[9],R2[9],R3[9],R[9],W[9],N[9],P[9],NP[9];
-    int i;
-    
-    trace(4,"eci2ecef: tutc=%s\n",time_str(tutc,3));
-    
-    if (fabs(timediff(tutc,tutc_))<0.01) { /* read cache */
-        for (i=0;i<9;i++) U[i]=U_[i];
-        if (gmst) *gmst=gmst_; 
-        return;
-    }
-    tutc_=tutc;
+    double eps,ze,th,z,t,t2,t3,dpsi,deps,f[5];
+    double R1[9],R2[9],R3[9],R[9],N[9],P[9];
     
     /* terrestrial time */
-    tgps=utc2gpst(tutc_);
+    tgps=utc2gpst(tutc);
     t=(timediff(tgps,epoch2time(ep2000))+19.0+32.184)/86400.0/36525.0;
     t2=t*t; t3=t2*t;
     
@@ -2281,36 +2741,128 @@ extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
     z =(2306.2181*t+1.09468*t2+0.018203*t3)*AS2R;
     eps=(84381.448-46.8150*t-0.00059*t2+0.001813*t3)*AS2R;
     Rz(-z,R1); Ry(th,R2); Rz(-ze,R3);
-    matmul("NN",3,3,3,1.0,R1,R2,0.0,R);
-    matmul("NN",3,3,3,1.0,R, R3,0.0,P); /* P=Rz(-z)*Ry(th)*Rz(-ze) */
+    matmul3("NN",R1,R2,R);
+    matmul3("NN",R, R3,P); /* P=Rz(-z)*Ry(th)*Rz(-ze) */
     
     /* iau 1980 nutation */
     nut_iau1980(t,f,&dpsi,&deps);
     Rx(-eps-deps,R1); Rz(-dpsi,R2); Rx(eps,R3);
-    matmul("NN",3,3,3,1.0,R1,R2,0.0,R);
-    matmul("NN",3,3,3,1.0,R ,R3,0.0,N); /* N=Rx(-eps)*Rz(-dspi)*Rx(eps) */
+    matmul3("NN",R1,R2,R);
+    matmul3("NN",R ,R3,N); /* N=Rx(-eps)*Rz(-dspi)*Rx(eps) */
+    matmul3("NN",N ,P ,NP);
+    
+    /* equation of equinoxes */
+    eqe[0]=dpsi*cos(eps);
+    eqe[1]=(0.00264*sin(f[4])+0.000063*sin(2.0*f[4]))*AS2R;
+    
+    trace(5,"P=\n"); tracemat(5,P,3,3,15,12);
+    trace(5,"N=\n"); tracemat(5,N,3,3,15,12);
+}
+/* eci to ecef transformation matrix by precession-nutation ------------------*/
+static void eci2ecef_np(gtime_t tutc, const double *erpv, const double *NP,
+                        const double *eqe, double *U, double *gmst)
+{
+    double gmst_,gast,R1[9],R2[9],R3[9],R[9],W[9];
     
     /* greenwich aparent sidereal time (rad) */
-    gmst_=utc2gmst(tutc_,erpv[2]);
-    gast=gmst_+dpsi*cos(eps);
-    gast+=(0.00264*sin(f[4])+0.000063*sin(2.0*f[4]))*AS2R;
+    gmst_=utc2gmst(tutc,erpv[2]);
+    gast=gmst_+eqe[0];
+    gast+=eqe[1];
     
     /* eci to ecef transformation matrix */
     Ry(-erpv[0],R1); Rx(-erpv[1],R2); Rz(gast,R3);
-    matmul("NN",3,3,3,1.0,R1,R2,0.0,W );
-    matmul("NN",3,3,3,1.0,W ,R3,0.0,R ); /* W=Ry(-xp)*Rx(-yp) */
-    matmul("NN",3,3,3,1.0,N ,P ,0.0,NP);
-    matmul("NN",3,3,3,1.0,R ,NP,0.0,U_); /* U=W*Rz(gast)*N*P */
+    matmul3("NN",R1,R2,W );
+    matmul3("NN",W ,R3,R ); /* W=Ry(-xp)*Rx(-yp) */
+    matmul3("NN",R ,NP,U ); /* U=W*Rz(gast)*N*P */
     
-    for (i=0;i<9;i++) U[i]=U_[i];
-    if (gmst) *gmst=gmst_; 
+    if (gmst) *gmst=gmst_;
     
     trace(5,"gmst=%.12f gast=%.12f\n",gmst_,gast);
-    trace(5,"P=\n"); tracemat(5,P,3,3,15,12);
-    trace(5,"N=\n"); tracemat(5,N,3,3,15,12);
     trace(5,"W=\n"); tracemat(5,W,3,3,15,12);
     trace(5,"U=\n"); tracemat(5,U,3,3,15,12);
 }
+/* eci to ecef transformation matrix -------------------------------------------
+* compute eci to ecef transformation matrix
+* args   : gtime_t tutc     I   time in utc
+*          double *erpv     I   erp values {xp,yp,ut1_utc,lod} (rad,rad,s,s/d)
+*          double *U        O   eci to ecef transformation matrix (3 x 3)
+*          double *gmst     IO  greenwich mean sidereal time (rad)
+*                               (NULL: no output)
+* return : none
+* note   : see ref [3] chap 5
+*          use eci2ecefc() to reuse precession-nutation among calls
+*-----------------------------------------------------------------------------*/
+extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
+{
+    double NP[9],eqe[2];
+    
+    trace(4,"eci2ecef: tutc=%s\n",time_str(tutc,3));
+    
+    prenut(tutc,NP,eqe);
+    eci2ecef_np(tutc,erpv,NP,eqe,U,gmst);
+}
+/* precession-nutation with earth orientation cache --------------------------*/
+static void prenutc(eoc_t *eoc, gtime_t tutc, double *NP, double *eqe)
+{
+    const double *p,*q;
+    double dt,a;
+    int i;
+    
+    /* interpolate precession-nutation table */
+    if (eoc->tint>0.0&&eoc->n>=2) {
+        dt=timediff(tutc,eoc->t0);
+        if (dt>=0.0&&dt<=eoc->tint*(eoc->n-1)) {
+            i=(int)(dt/eoc->tint);
+            if (i>eoc->n-2) i=eoc->n-2;
+            a=dt/eoc->tint-i;
+            p=eoc->tbl+i*11; q=p+11;
+            for (i=0;i<9;i++) NP[i]=p[i]+a*(q[i]-p[i]);
+            for (i=0;i<2;i++) eqe[i]=p[9+i]+a*(q[9+i]-p[9+i]);
+            return;
+        }
+    }
+    lock(&eoc->lock);
+    if (eoc->tnp.time&&fabs(timediff(tutc,eoc->tnp))<=eoc->tol) {
+        for (i=0;i<9;i++) NP[i]=eoc->NP[i];
+        for (i=0;i<2;i++) eqe[i]=eoc->eqe[i];
+        eoc->nhit++;
+        unlock(&eoc->lock);
+        return;
+    }
+    eoc->nmiss++;
+    unlock(&eoc->lock);
+    
+    prenut(tutc,NP,eqe);
+    
+    lock(&eoc->lock);
+    eoc->tnp=tutc;
+    for (i=0;i<9;i++) eoc->NP[i]=NP[i];
+    for (i=0;i<2;i++) eoc->eqe[i]=eqe[i];
+    unlock(&eoc->lock);
+}
+/* eci to ecef transformation matrix with earth orientation cache --------------
+* compute eci to ecef transformation matrix with earth orientation cache
+* args   : eoc_t  *eoc      IO  earth orientation cache (NULL: no cache)
+*          other args are same as eci2ecef()
+* return : none
+* notes  : precession-nutation is interpolated by the table of the cache or
+*          reused if the time differs within eoc->tol. earth rotation and
+*          polar motion are computed for each call.
+*-----------------------------------------------------------------------------*/
+extern void eci2ecefc(eoc_t *eoc, gtime_t tutc, const double *erpv, double *U,
+                      double *gmst)
+{
+    double NP[9],eqe[2];
+    
+    trace(4,"eci2ecefc: tutc=%s\n",time_str(tutc,3));
+    
+    if (!eoc) {
+        eci2ecef(tutc,erpv,U,gmst);
+        return;
+    }
+    prenutc(eoc,tutc,NP,eqe);
+    eci2ecef_np(tutc,erpv,NP,eqe,U,gmst);
+}
 /* decode antenna parameter field --------------------------------------------*/
 static int decodef(char *p, int n, double *v)
 {
@@ -2482,6 +3034,8 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
     else {
         stat=readngspcv(file,pcvs);
     }
+    pcvindex(pcvs);
+    
     for (i=0;i<pcvs->n;i++) {
         pcv=pcvs->pcv+i;
         trace(4,"sat=%2d type=%20s code=%s off=%8.4f %8.4f %8.4f  %8.4f %8.4f %8.4f\n",
@@ -2490,6 +3044,173 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
     }
     return stat;
 }
+/* hash of antenna type ------------------------------------------------------*/
+static uint32_t pcvhash(const char *str)
+{
+    uint32_t h=2166136261u;
+    
+    for (;*str;str++) {
+        h^=(uint8_t)*str;
+        h*=16777619u;
+    }
+    return h;
+}
+/* split antenna type into antenna and radome --------------------------------*/
+static int pcvtypes(const char *type, char *buff, char **types)
+{
+    char *p;
+    int n=0;
+    
+    strncpy(buff,type,MAXANT-1); buff[MAXANT-1]='\0';
+    
+    for (p=buff;*p&&n<2;) {
+        while (*p==' ') p++;
+        if (!*p) break;
+        types[n++]=p;
+        while (*p&&*p!=' ') p++;
+        if (*p) *p++='\0';
+    }
+    return n;
+}
+/* search receiver antenna by linear scan ------------------------------------*/
+static int searchrcvpcv(char **types, int n, const pcvs_t *pcvs, int *fb)
+{
+    int i,j;
+    
+    *fb=0;
+    
+    /* search receiver antenna with radome at first */
+    for (i=0;i<pcvs->n;i++) {
+        for (j=0;j<n;j++) if (!strstr(pcvs->pcv[i].type,types[j])) break;
+        if (j>=n) return i;
+    }
+    /* search receiver antenna without radome */
+    for (i=0;i<pcvs->n;i++) {
+        if (strstr(pcvs->pcv[i].type,types[0])!=pcvs->pcv[i].type) continue;
+        *fb=1;
+        return i;
+    }
+    return -1;
+}
+/* search receiver antenna by hash table of antenna types --------------------*/
+static int searchpcvkey(pcvidx_t *idx, char **types, int n, const pcvs_t *pcvs,
+                        int *fb)
+{
+    pcvkey_t *key;
+    char str[MAXANT];
+    int i,k,nmax;
+    
+    if (n>1) sprintf(str,"%s %s",types[0],types[1]);
+    else strcpy(str,types[0]);
+    
+    lock(&idx->lock);
+    
+    /* extend hash table for load factor <0.5 */
+    if (idx->nkey*2>=idx->nkmax) {
+        nmax=idx->nkmax<=0?64:idx->nkmax*2;
+        if (!(key=(pcvkey_t *)calloc(nmax,sizeof(pcvkey_t)))) {
+            unlock(&idx->lock);
+            return searchrcvpcv(types,n,pcvs,fb);
+        }
+        for (i=0;i<idx->nkmax;i++) {
+            if (!idx->key[i].type[0]) continue;
+            k=pcvhash(idx->key[i].type)&(nmax-1);
+            while (key[k].type[0]) k=(k+1)&(nmax-1);
+            key[k]=idx->key[i];
+        }
+        free(idx->key);
+        idx->key=key;
+        idx->nkmax=nmax;
+    }
+    k=pcvhash(str)&(idx->nkmax-1);
+    while (idx->key[k].type[0]&&strcmp(idx->key[k].type,str)) {
+        k=(k+1)&(idx->nkmax-1);
+    }
+    key=idx->key+k;
+    
+    /* bind antenna parameter to antenna type at first search */
+    if (!key->type[0]) {
+        strcpy(key->type,str);
+        key->idx=searchrcvpcv(types,n,pcvs,&key->fb);
+        idx->nkey++;
+    }
+    i=key->idx;
+    *fb=key->fb;
+    
+    unlock(&idx->lock);
+    return i;
+}
+/* get valid antenna parameter index -----------------------------------------*/
+static pcvidx_t *getpcvidx(const pcvs_t *pcvs)
+{
+    pcvidx_t *idx=pcvs->idx;
+    
+    if (!idx||idx->pcv!=pcvs->pcv||idx->n!=pcvs->n) return NULL;
+    return idx;
+}
+/* free antenna parameter index ----------------------------------------------*/
+static void freepcvidx(pcvs_t *pcvs)
+{
+    if (!pcvs->idx) return;
+    
+    freelock(&pcvs->idx->lock);
+    free(pcvs->idx->sidx);
+    free(pcvs->idx->key);
+    free(pcvs->idx);
+    pcvs->idx=NULL;
+}
+/* index antenna parameters ----------------------------------------------------
+* build index of antenna parameters for searchpcv()
+* args   : pcvs_t *pcvs       IO  antenna parameters
+* return : status (1:ok,0:memory allocation error)
+* notes  : satellite antennas are indexed by satellite number in the order of
+*          antenna parameters. receiver antennas are bound to antenna types in
+*          hash table at the first search of each type.
+*          searchpcv() falls back to linear scan if the number or the address
+*          of antenna parameters differs from the indexed ones.
+*          readpcv() calls it after reading antenna parameters.
+*-----------------------------------------------------------------------------*/
+extern int pcvindex(pcvs_t *pcvs)
+{
+    pcvidx_t *idx;
+    int i,sat,k[MAXSAT];
+    
+    trace(3,"pcvindex: n=%d\n",pcvs->n);
+    
+    freepcvidx(pcvs);
+    
+    if (!(idx=(pcvidx_t *)calloc(1,sizeof(pcvidx_t)))) return 0;
+    
+    if (pcvs->n>0&&!(idx->sidx=imat(pcvs->n,1))) {
+        free(idx);
+        return 0;
+    }
+    for (i=0;i<pcvs->n;i++) {
+        if ((sat=pcvs->pcv[i].sat)>=1&&sat<=MAXSAT) idx->off[sat]++;
+    }
+    for (i=0;i<MAXSAT;i++) {
+        idx->off[i+1]+=idx->off[i];
+        k[i]=idx->off[i];
+    }
+    for (i=0;i<pcvs->n;i++) {
+        if ((sat=pcvs->pcv[i].sat)>=1&&sat<=MAXSAT) idx->sidx[k[sat-1]++]=i;
+    }
+    idx->pcv=pcvs->pcv;
+    idx->n=pcvs->n;
+    initlock(&idx->lock);
+    pcvs->idx=idx;
+    return 1;
+}
+/* free antenna parameters -----------------------------------------------------
+* free antenna parameters and index
+* args   : pcvs_t *pcvs       IO  antenna parameters
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freepcv(pcvs_t *pcvs)
+{
+    freepcvidx(pcvs);
+    free(pcvs->pcv); pcvs->pcv=NULL; pcvs->n=pcvs->nmax=0;
+}
 /* search antenna parameter ----------------------------------------------------
 * read satellite antenna phase center position
 * args   : int    sat         I   satellite number (0: receiver antenna)
@@ -2497,19 +3218,24 @@ extern int readpcv(const char *file, pcvs_t *pcvs)
 *          gtime_t time       I   time to search parameters
 *          pcvs_t *pcvs       IO  antenna parameters
 * return : antenna parameter (NULL: no antenna)
+* notes  : search by index if indexed by pcvindex()
 *-----------------------------------------------------------------------------*/
 extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs)
 {
+    pcvidx_t *idx=getpcvidx(pcvs);
     pcv_t *pcv;
-    char buff[MAXANT],*types[2],*p;
-    int i,j,n=0;
+    char buff[MAXANT],*types[2];
+    int i,n,fb;
     
     trace(4,"searchpcv: sat=%2d type=%s\n",sat,type);
     
     if (sat) { /* search satellite antenna */
-        for (i=0;i<pcvs->n;i++) {
-            pcv=pcvs->pcv+i;
+        if (idx&&(sat<1||sat>MAXSAT)) return NULL;
+        n=idx?idx->off[sat]-idx->off[sat-1]:pcvs->n;
+        
+        for (i=0;i<n;i++) {
+            pcv=pcvs->pcv+(idx?idx->sidx[idx->off[sat-1]+i]:i);
             if (pcv->sat!=sat) continue;
             if (pcv->ts.time!=0&&timediff(pcv->ts,time)>0.0) continue;
             if (pcv->te.time!=0&&timediff(pcv->te,time)<0.0) continue;
@@ -2517,24 +3243,14 @@ extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
         }
     }
     else {
-        strcpy(buff,type);
-        for (p=strtok(buff," ");p&&n<2;p=strtok(NULL," ")) types[n++]=p;
-        if (n<=0) return NULL;
+        if ((n=pcvtypes(type,buff,types))<=0) return NULL;
         
-        /* search receiver antenna with radome at first */
-        for (i=0;i<pcvs->n;i++) {
-            pcv=pcvs->pcv+i;
-            for (j=0;j<n;j++) if (!strstr(pcv->type,types[j])) break;
-            if (j>=n) return pcv;
-        }
-        /* search receiver antenna without radome */
-        for (i=0;i<pcvs->n;i++) {
-            pcv=pcvs->pcv+i;
-            if (strstr(pcv->type,types[0])!=pcv->type) continue;
-            
-            trace(2,"pcv without radome is used type=%s\n",type);
-            return pcv;
-        }
+        if (idx) i=searchpcvkey(idx,types,n,pcvs,&fb);
+        else     i=searchrcvpcv(types,n,pcvs,&fb);
+        
+        if (i<0) return NULL;
+        if (fb) trace(2,"pcv without radome is used type=%s\n",type);
+        return pcvs->pcv+i;
     }
     return NULL;
 }
@@ -2854,6 +3570,173 @@ extern void uniqnav(nav_t *nav)
     uniqeph (nav);
     uniqgeph(nav);
     uniqseph(nav);
+    
+    /* index ephemeris */
+    ephindex(nav);
+}
+/* ephemeris index key -------------------------------------------------------*/
+typedef struct {
+    gtime_t toe;        /* toe (or t0 for sbas) */
+    int sat,i;          /* satellite and index of ephemeris */
+} ephkey_t;
+
+static int cmpephkey(const void *p1, const void *p2)
+{
+    ephkey_t *q1=(ephkey_t *)p1,*q2=(ephkey_t *)p2;
+    if (q1->sat!=q2->sat) return q1->sat-q2->sat;
+    if (q1->toe.time!=q2->toe.time) return q1->toe.time<q2->toe.time?-1:1;
+    if (q1->toe.sec !=q2->toe.sec ) return q1->toe.sec <q2->toe.sec ?-1:1;
+    return q1->i-q2->i;
+}
+/* get ephemeris index key (type: 0:eph,1:geph,2:seph) -----------------------*/
+static int ephkey(const nav_t *nav, int type, int i, ephkey_t *key)
+{
+    switch (type) {
+        case 0 : key->sat=nav->eph [i].sat; key->toe=nav->eph [i].toe; break;
+        case 1 : key->sat=nav->geph[i].sat; key->toe=nav->geph[i].toe; break;
+        default: key->sat=nav->seph[i].sat; key->toe=nav->seph[i].t0 ; break;
+    }
+    key->i=i;
+    return 1<=key->sat&&key->sat<=MAXSAT;
+}
+/* get ephemeris array and number --------------------------------------------*/
+static const void *ephsrc(const nav_t *nav, int type, int *n)
+{
+    switch (type) {
+        case 0: *n=nav->n ; return nav->eph ;
+        case 1: *n=nav->ng; return nav->geph;
+    }
+    *n=nav->ns; return nav->seph;
+}
+/* get valid ephemeris index -------------------------------------------------*/
+static const ephidx_t *getephidx(const nav_t *nav, int type)
+{
+    const void *src;
+    int n;
+    
+    if (type<0||type>2) return NULL;
+    src=ephsrc(nav,type,&n);
+    return nav->eidx[type].idx&&nav->eidx[type].src==src&&
+           nav->eidx[type].n==n?nav->eidx+type:NULL;
+}
+/* free ephemeris index ------------------------------------------------------*/
+static void freeephidx(ephidx_t *x)
+{
+    free(x->idx); x->idx=NULL; x->src=NULL; x->n=0;
+}
+/* index ephemerides -----------------------------------------------------------
+* build indices of ephemerides in navigation data sorted by satellite and toe
+* to select ephemeris by binary search instead of linear scan
+* args   : nav_t *nav    IO     navigation data
+* return : none
+* notes  : call it again after adding or reallocating ephemerides. call
+*          updephindex() after overwriting an ephemeris in place.
+*          ephemeris selection falls back to linear scan if the number or
+*          the address of the ephemeris array differs from the indexed one.
+*-----------------------------------------------------------------------------*/
+extern void ephindex(nav_t *nav)
+{
+    ephkey_t *key;
+    ephidx_t *x;
+    const void *src;
+    int i,j,k,n,type;
+    
+    trace(3,"ephindex: n=%d ng=%d ns=%d\n",nav->n,nav->ng,nav->ns);
+    
+    for (type=0;type<3;type++) {
+        x=nav->eidx+type;
+        freeephidx(x);
+        if (!(src=ephsrc(nav,type,&n))||n<=0) continue;
+        
+        if (!(key=(ephkey_t *)malloc(sizeof(ephkey_t)*n))||
+            !(x->idx=imat(n,1))) {
+            trace(1,"ephindex malloc error type=%d n=%d\n",type,n);
+            free(key);
+            continue;
+        }
+        for (i=k=0;i<n;i++) {
+            if (ephkey(nav,type,i,key+k)) k++;
+        }
+        qsort(key,k,sizeof(ephkey_t),cmpephkey);
+        
+        for (i=j=0;i<=MAXSAT;i++) {
+            while (j<k&&key[j].sat<=i) j++;
+            x->off[i]=j;
+        }
+        for (i=0;i<k;i++) x->idx[i]=key[i].i;
+        x->src=src;
+        x->n=n;
+        free(key);
+    }
+}
+/* update ephemeris index ------------------------------------------------------
+* update ephemeris index after overwriting an ephemeris in place
+* args   : nav_t *nav    IO     navigation data
+*          int    type   I      ephemeris type (0:eph,1:geph,2:seph)
+*          int    i      I      index of overwritten ephemeris
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void updephindex(nav_t *nav, int type, int i)
+{
+    ephidx_t *x;
+    ephkey_t key,keyq;
+    int p,q,a,b,s,k;
+    
+    if (!getephidx(nav,type)||i<0||i>=nav->eidx[type].n) return;
+    x=nav->eidx+type;
+    k=x->off[MAXSAT];
+    
+    /* remove old entry */
+    for (p=0;p<k;p++) if (x->idx[p]==i) break;
+    if (p<k) {
+        for (s=1;x->off[s]<=p;s++) ;
+        memmove(x->idx+p,x->idx+p+1,sizeof(int)*(k-p-1));
+        for (;s<=MAXSAT;s++) x->off[s]--;
+        k--;
+    }
+    /* insert new entry by binary search */
+    if (!ephkey(nav,type,i,&key)) return;
+    a=x->off[key.sat-1]; b=x->off[key.sat];
+    while (a<b) {
+        q=(a+b)/2;
+        ephkey(nav,type,x->idx[q],&keyq);
+        if (cmpephkey(&keyq,&key)<0) a=q+1; else b=q;
+    }
+    memmove(x->idx+a+1,x->idx+a,sizeof(int)*(k-a));
+    x->idx[a]=i;
+    for (s=key.sat;s<=MAXSAT;s++) x->off[s]++;
+}
+/* search ephemeris index ------------------------------------------------------
+* search ephemerides of a satellite with |toe-time|<=tmax in ephemeris index
+* args   : nav_t  *nav   I      navigation data
+*          int    type   I      ephemeris type (0:eph,1:geph,2:seph)
+*          int    sat    I      satellite number
+*          gtime_t time  I      time (gpst)
+*          double tmax   I      max time difference (s)
+*          int    **idx  O      indices of ephemerides sorted by toe
+* return : number of ephemerides (-1: no valid index)
+*-----------------------------------------------------------------------------*/
+extern int ephindexwin(const nav_t *nav, int type, int sat, gtime_t time,
+                       double tmax, const int **idx)
+{
+    const ephidx_t *x;
+    ephkey_t key;
+    int a,b,e,q;
+    
+    if (sat<=0||sat>MAXSAT||!(x=getephidx(nav,type))) return -1;
+    
+    a=x->off[sat-1]; b=e=x->off[sat];
+    while (a<b) { /* first toe>=time-tmax */
+        q=(a+b)/2;
+        ephkey(nav,type,x->idx[q],&key);
+        if (timediff(key.toe,time)<-tmax) a=q+1; else b=q;
+    }
+    for (b=a;b<e;b++) {
+        ephkey(nav,type,x->idx[b],&key);
+        if (timediff(key.toe,time)>tmax) break;
+    }
+    *idx=x->idx+a;
+    return b-a;
 }
 /* compare observation data -------------------------------------------------*/
 static int cmpobs(const void *p1, const void *p2)
@@ -3056,6 +3939,9 @@ extern void freenav(nav_t *nav, int opt)
     if (opt&0x01) {free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;}
     if (opt&0x02) {free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;}
     if (opt&0x04) {free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;}
+    if (opt&0x01) freeephidx(nav->eidx  );
+    if (opt&0x02) freeephidx(nav->eidx+1);
+    if (opt&0x04) freeephidx(nav->eidx+2);
     if (opt&0x08) {free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;}
     if (opt&0x10) {free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;}
     if (opt&0x20) {free(nav->alm ); nav->alm =NULL; nav->na=nav->namax=0;}
@@ -3437,6 +4323,72 @@ extern void createdir(const char *path)
     
     mkdir_r(buff);
 }
+/* map file to memory ----------------------------------------------------------
+* map file to memory read-only
+* args   : char   *file     I   file path
+*          size_t *size     O   file size (bytes)
+* return : pointer to mapped file (NULL: error or empty file)
+* notes  : the mapped file should be unmapped by unmapfile()
+*-----------------------------------------------------------------------------*/
+extern const uint8_t *mapfile(const char *file, size_t *size)
+{
+#ifdef WIN32
+    HANDLE hf,hm;
+    DWORD hi=0,lo;
+    void *p;
+    
+    trace(3,"mapfile: file=%s\n",file);
+    
+    if ((hf=CreateFile((LPCTSTR)file,GENERIC_READ,FILE_SHARE_READ,NULL,
+                       OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL))==
+        INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    lo=GetFileSize(hf,&hi);
+    *size=(size_t)(((uint64_t)hi<<32)+lo);
+    
+    if (*size==0||!(hm=CreateFileMapping(hf,NULL,PAGE_READONLY,0,0,NULL))) {
+        CloseHandle(hf);
+        return NULL;
+    }
+    p=MapViewOfFile(hm,FILE_MAP_READ,0,0,0);
+    CloseHandle(hm);
+    CloseHandle(hf);
+    return (const uint8_t *)p;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+    
+    trace(3,"mapfile: file=%s\n",file);
+    
+    if ((fd=open(file,O_RDONLY))<0) return NULL;
+    
+    if (fstat(fd,&st)||st.st_size<=0) {
+        close(fd);
+        return NULL;
+    }
+    *size=(size_t)st.st_size;
+    p=mmap(NULL,*size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    return p==MAP_FAILED?NULL:(const uint8_t *)p;
+#endif
+}
+/* unmap file from memory ------------------------------------------------------
+* unmap file mapped by mapfile()
+* args   : uint8_t *p       I   pointer to mapped file
+*          size_t size      I   file size (bytes)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void unmapfile(const uint8_t *p, size_t size)
+{
+    if (!p) return;
+#ifdef WIN32
+    UnmapViewOfFile(p);
+#else
+    munmap((void *)p,size);
+#endif
+}
 /* replace string ------------------------------------------------------------*/
 static int repstr(char *str, const char *pat, const char *rep)
 {
@@ -3921,6 +4873,71 @@ extern void antmodel_s(const pcv_t *pcv, double nadir, double *dant)
     }
     trace(4,"antmodel_s: dant=%6.3f %6.3f\n",dant[0],dant[1]);
 }
+/* initialize antenna model table ----------------------------------------------
+* precompute antenna phase center model for evaluation of many directions
+* args   : pcv_t    *pcv    I   antenna phase center parameters
+*          double   *del    I   antenna delta {e,n,u} (m) (NULL: no delta)
+*          int      opt     I   option (0:only offset,1:offset+pcv)
+*          pcvtbl_t *tbl    O   antenna model table
+* return : none
+* notes  : offsets are summed with antenna delta and variations are tabulated
+*          with increments to next nodes (zenith angle 0,5,...,90 deg)
+*-----------------------------------------------------------------------------*/
+extern void initpcvtbl(const pcv_t *pcv, const double *del, int opt,
+                       pcvtbl_t *tbl)
+{
+    int i,j;
+    
+    for (i=0;i<NFREQ;i++) {
+        for (j=0;j<3;j++) tbl->off[i][j]=pcv->off[i][j]+(del?del[j]:0.0);
+        for (j=0;j<19;j++) tbl->var[i][j]=opt?pcv->var[i][j]:0.0;
+        for (j=0;j<18;j++) tbl->dvar[i][j]=tbl->var[i][j+1]-tbl->var[i][j];
+        tbl->dvar[i][18]=0.0;
+    }
+    tbl->opt=opt;
+}
+/* interpolate antenna phase center variation by table -----------------------*/
+static double interptbl(const double *var, const double *dvar, double a)
+{
+    int i=(int)a;
+    if (i<0) return var[0]; else if (i>=18) return var[18];
+    return var[i]+dvar[i]*(a-i);
+}
+/* receiver antenna model by table ---------------------------------------------
+* compute antenna offsets for directions of satellites by antenna model table
+* args   : pcvtbl_t *tbl    I   antenna model table by initpcvtbl()
+*          double *e        I   unit vectors receiver to satellites {e,n,u}
+*                               (e[i*3+(0:2)]: satellite i)
+*          int     n        I   number of satellites
+*          double *dant     O   range offsets for each frequency (m)
+*                               (dant[i*NFREQ+j]: satellite i, frequency j)
+* return : none
+* notes  : same as antmodel() except for directions given by unit vectors
+*-----------------------------------------------------------------------------*/
+extern void antmodeln(const pcvtbl_t *tbl, const double *e, int n,
+                      double *dant)
+{
+    const double *ei;
+    double a=0.0,cosz;
+    int i,j;
+    
+    trace(4,"antmodeln: n=%d opt=%d\n",n,tbl->opt);
+    
+    for (i=0;i<n;i++) {
+        ei=e+i*3;
+        if (tbl->opt) {
+            cosz=ei[2]<-1.0?-1.0:(ei[2]>1.0?1.0:ei[2]);
+            a=acos(cosz)*(R2D/5.0);
+        }
+        for (j=0;j<NFREQ;j++) {
+            dant[j+i*NFREQ]=-(tbl->off[j][0]*ei[0]+tbl->off[j][1]*ei[1]+
+                              tbl->off[j][2]*ei[2]);
+            if (tbl->opt) {
+                dant[j+i*NFREQ]+=interptbl(tbl->var[j],tbl->dvar[j],a);
+            }
+        }
+    }
+}
 /* sun and moon position in eci (ref [4] 5.1.1, 5.2.1) -----------------------*/
 static void sunmoonpos_eci(gtime_t tut, double *rsun, double *rmoon)
 {
@@ -3993,10 +5010,155 @@ extern void sunmoonpos(gtime_t tutc, const double *erpv, double *rsun,
     eci2ecef(tutc,erpv,U,&gmst_);
     
     /* sun and moon postion in ecef */
-    if (rsun ) matmul("NN",3,1,3,1.0,U,rs,0.0,rsun );
-    if (rmoon) matmul("NN",3,1,3,1.0,U,rm,0.0,rmoon);
+    if (rsun ) matmul3v("N",U,rs,rsun );
+    if (rmoon) matmul3v("N",U,rm,rmoon);
     if (gmst ) *gmst=gmst_;
 }
+/* sun and moon position with earth orientation cache ---------------------------
+* get sun and moon position in ecef with earth orientation cache
+* args   : eoc_t  *eoc      IO  earth orientation cache (NULL: no cache)
+*          other args are same as sunmoonpos()
+* return : none
+* notes  : the positions of last call are returned for the same time and erp
+*          values
+*-----------------------------------------------------------------------------*/
+extern void sunmoonposc(eoc_t *eoc, gtime_t tutc, const double *erpv,
+                        double *rsun, double *rmoon, double *gmst)
+{
+    gtime_t tut;
+    double rs[3],rm[3],U[9],gmst_;
+    int i,smf=(rsun?1:0)|(rmoon?2:0);
+    
+    trace(4,"sunmoonposc: tutc=%s\n",time_str(tutc,3));
+    
+    if (!eoc) {
+        sunmoonpos(tutc,erpv,rsun,rmoon,gmst);
+        return;
+    }
+    lock(&eoc->lock);
+    if (eoc->tsm.time&&timediff(tutc,eoc->tsm)==0.0&&(eoc->smf&smf)==smf&&
+        eoc->erpv[0]==erpv[0]&&eoc->erpv[1]==erpv[1]&&eoc->erpv[2]==erpv[2]) {
+        for (i=0;i<3;i++) {
+            if (rsun ) rsun [i]=eoc->rsun [i];
+            if (rmoon) rmoon[i]=eoc->rmoon[i];
+        }
+        if (gmst) *gmst=eoc->gmst;
+        eoc->nhit++;
+        unlock(&eoc->lock);
+        return;
+    }
+    unlock(&eoc->lock);
+    
+    tut=timeadd(tutc,erpv[2]); /* utc -> ut1 */
+    
+    /* sun and moon position in eci */
+    sunmoonpos_eci(tut,rsun?rs:NULL,rmoon?rm:NULL);
+    
+    /* eci to ecef transformation matrix */
+    eci2ecefc(eoc,tutc,erpv,U,&gmst_);
+    
+    /* sun and moon postion in ecef */
+    if (rsun ) matmul3v("N",U,rs,rsun );
+    if (rmoon) matmul3v("N",U,rm,rmoon);
+    if (gmst ) *gmst=gmst_;
+    
+    lock(&eoc->lock);
+    eoc->tsm=tutc;
+    for (i=0;i<3;i++) {
+        eoc->erpv[i]=erpv[i];
+        eoc->rsun [i]=rsun ?rsun [i]:0.0;
+        eoc->rmoon[i]=rmoon?rmoon[i]:0.0;
+    }
+    eoc->gmst=gmst_;
+    eoc->smf=smf;
+    unlock(&eoc->lock);
+}
+/* initialize earth orientation cache ------------------------------------------
+* initialize cache of precession-nutation and sun and moon positions shared by
+* eci2ecefc() and sunmoonposc() calls
+* args   : nav_t  *nav      IO  navigation data
+*          double tol       I   tolerance of time to reuse precession-nutation
+*                               (s) (0: reuse only for the same time)
+* return : status (1:ok,0:memory allocation error)
+* notes  : the cache is thread-safe except eoctable()
+*-----------------------------------------------------------------------------*/
+extern int eocinit(nav_t *nav, double tol)
+{
+    gtime_t t0={0};
+    
+    trace(3,"eocinit: tol=%.3g\n",tol);
+    
+    eocfree(nav);
+    
+    if (!(nav->eoc=(eoc_t *)malloc(sizeof(eoc_t)))) {
+        trace(1,"eocinit: malloc error\n");
+        return 0;
+    }
+    nav->eoc->tol=tol;
+    nav->eoc->tnp=nav->eoc->tsm=nav->eoc->t0=t0;
+    nav->eoc->smf=0;
+    nav->eoc->tint=0.0;
+    nav->eoc->n=0;
+    nav->eoc->tbl=NULL;
+    nav->eoc->nhit=nav->eoc->nmiss=0;
+    initlock(&nav->eoc->lock);
+    return 1;
+}
+/* generate precession-nutation table ------------------------------------------
+* generate table of precession-nutation for time span to interpolate it in
+* eci2ecefc() and sunmoonposc() calls for batch processing
+* args   : nav_t  *nav      IO  navigation data (with eocinit() called)
+*          gtime_t ts       I   start time (utc)
+*          gtime_t te       I   end time (utc)
+*          double tint      I   interval of table nodes (s)
+* return : status (1:ok,0:error)
+* notes  : linear interpolation error of precession-nutation is less than
+*          1E-12 rad for tint<=300 s. out of the time span, precession-nutation
+*          is computed or reused as without table.
+*          should not be called concurrently with other calls using the cache
+*-----------------------------------------------------------------------------*/
+extern int eoctable(nav_t *nav, gtime_t ts, gtime_t te, double tint)
+{
+    eoc_t *eoc=nav->eoc;
+    double *tbl;
+    int i,n;
+    
+    trace(3,"eoctable: ts=%s tint=%.0f\n",time_str(ts,0),tint);
+    
+    if (!eoc||tint<=0.0||timediff(te,ts)<0.0) return 0;
+    
+    n=(int)ceil(timediff(te,ts)/tint)+1;
+    if (n<2) n=2;
+    if (!(tbl=(double *)malloc(sizeof(double)*11*n))) {
+        trace(1,"eoctable: malloc error n=%d\n",n);
+        return 0;
+    }
+    for (i=0;i<n;i++) {
+        prenut(timeadd(ts,tint*i),tbl+i*11,tbl+i*11+9);
+    }
+    free(eoc->tbl);
+    eoc->tbl=tbl;
+    eoc->t0=ts;
+    eoc->tint=tint;
+    eoc->n=n;
+    return 1;
+}
+/* free earth orientation cache ------------------------------------------------
+* free cache of precession-nutation and sun and moon positions
+* args   : nav_t  *nav      IO  navigation data
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void eocfree(nav_t *nav)
+{
+    if (!nav->eoc) return;
+    
+    trace(3,"eocfree: hit=%u miss=%u\n",nav->eoc->nhit,nav->eoc->nmiss);
+    
+    freelock(&nav->eoc->lock);
+    free(nav->eoc->tbl);
+    free(nav->eoc);
+    nav->eoc=NULL;
+}
 /* uncompress file -------------------------------------------------------------
 * uncompress (uncompress/unzip/uncompact hatanaka-compression/tar) file
 * args   : char   *file     I   input file
@@ -243,6 +243,11 @@ extern "C" {
 #else
 #define DTTOL       0.025               /* tolerance of time difference (s) */
 #endif
+#define DTTOLSC     1E-3                /* tolerance of time to reuse cached sat state (s) */
+#define DTTOLEOC    1.0                 /* tolerance of time to reuse precession-nutation (s) */
+#define TINTEOC     300.0               /* interval of precession-nutation table (s) */
+#define MAXGLOSTEP  32                  /* max number of cached glonass integration steps */
+#define NMAXPEPH    10                  /* order of precise ephemeris interpolation */
 /*o,nļʱܳʱֵ*/
 #define MAXDTOE     7200.0              /* max time difference to GPS Toe (s) */
 #define MAXDTOE_QZS 7200.0              /* max time difference to QZSS Toe (s) */
@@ -279,6 +284,7 @@ extern "C" {
 #define MAXLEAPS    64                  /* max number of leap seconds table */
 #define MAXGISLAYER 32                  /* max number of GIS data layers */
 #define MAXRCVCMD   4096                /* max length of receiver commands */
+#define MAXINVALIDTM 100                /* max number of invalid time marks */
 
 #define RNX2VER     2.10                /* RINEX ver.2 default output version */
 #define RNX3VER     3.00                /* RINEX ver.3 default output version */
@@ -433,6 +439,15 @@ extern "C" {
 #define GLO_ARMODE_AUTOCAL 2            /* GLO AR mode: autocal */
 #define GLO_ARMODE_FIXHOLD 3            /* GLO AR mode: fix and hold */
 
+#define KFOPT_STD    0                  /* filter cov update: (I-K*H')*P */
+#define KFOPT_SYM    1                  /* filter cov update: P-K*(H'*P) sym */
+#define KFOPT_JOSEPH 2                  /* filter cov update: Joseph form sym */
+
+#define MATBE_DEFAULT 0                 /* matrix backend: default of build */
+#define MATBE_BUILTIN 1                 /* matrix backend: built-in loops */
+#define MATBE_BLOCKED 2                 /* matrix backend: cache-blocked */
+#define MATBE_BLAS   3                  /* matrix backend: BLAS/LAPACK */
+
 #define SBSOPT_LCORR 1                  /* SBAS option: long term correction */
 #define SBSOPT_FCORR 2                  /* SBAS option: fast correction */
 #define SBSOPT_ICORR 4                  /* SBAS option: ionosphere correction */
@@ -535,6 +550,7 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define freelock(f) DeleteCriticalSection(f)
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -542,6 +558,7 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define freelock(f) pthread_mutex_destroy(f)
 #define FILEPATHSEP '/'
 #endif
 
@@ -600,9 +617,33 @@ typedef struct {        /* antenna parameter type */
                         /* el=90,85,...,0 or nadir=0,1,2,3,... (deg) */
 } pcv_t;
 
+typedef struct {        /* receiver antenna type key type */
+    char type[MAXANT];  /* antenna type and radome ("": empty slot) */
+    int idx;            /* index of antenna parameter (-1: no antenna) */
+    int fb;             /* antenna without radome used (1:on) */
+} pcvkey_t;
+
+typedef struct {        /* antenna parameter index type */
+    const pcv_t *pcv;   /* indexed antenna parameters */
+    int n;              /* number of indexed antenna parameters */
+    int off[MAXSAT+1];  /* index offsets of satellites (off[sat-1]-off[sat]-1) */
+    int *sidx;          /* satellite antenna indices sorted by satellite */
+    pcvkey_t *key;      /* hash table of receiver antenna types */
+    int nkey,nkmax;     /* number of keys and size of hash table */
+    lock_t lock;        /* lock flag of hash table */
+} pcvidx_t;
+
+typedef struct {        /* antenna phase center model table type */
+    double off[NFREQ][3]; /* phase center offsets with antenna delta (m) */
+    double var[NFREQ][19]; /* phase center variations at nodes (m) */
+    double dvar[NFREQ][19]; /* increments of variations to next nodes (m) */
+    int opt;            /* option (0:only offset,1:offset+pcv) */
+} pcvtbl_t;
+
 typedef struct {        /* antenna parameters type */
     int n,nmax;         /* number of data/allocated */
     pcv_t *pcv;         /* antenna parameters data */
+    pcvidx_t *idx;      /* antenna parameter index (NULL: no index) */
 } pcvs_t;
 
 typedef struct {        /* almanac type */
@@ -811,6 +852,73 @@ typedef struct {        /* SSR correction type */
     uint8_t update;     /* update flag (0:no update,1:update) */
 } ssr_t;
 
+typedef struct {        /* ephemeris index type */
+    int n;              /* number of ephemerides when indexed */
+    const void *src;    /* ephemeris array when indexed */
+    int *idx;           /* ephemeris indices sorted by satellite and toe */
+    int off[MAXSAT+1];  /* index offsets of satellites (off[sat-1]-off[sat]-1) */
+} ephidx_t;
+
+typedef struct {        /* satellite state type */
+    gtime_t time;       /* time of state (gpst) */
+    const void *eph;    /* ephemeris of state */
+    gtime_t toe;        /* toe of ephemeris */
+    int iode;           /* iode of ephemeris */
+    int svh;            /* sat health flag */
+    double rs[6];       /* sat position and velocity (ecef) (m|m/s) */
+    double dts[2];      /* sat clock bias and drift (s|s/s) */
+    double var;         /* sat position and clock error variance (m^2) */
+} satstate_t;
+
+typedef struct {        /* glonass orbit state type */
+    const void *eph;    /* ephemeris of state */
+    gtime_t toe;        /* toe of ephemeris */
+    int iode;           /* iode of ephemeris */
+    int n[2];           /* number of integration steps {backward,forward} */
+    double x[2][MAXGLOSTEP][6]; /* states after steps {backward,forward} (m|m/s) */
+} glostate_t;
+
+typedef struct {        /* glonass orbit state table type */
+    glostate_t *st;     /* glonass orbit states (NSATGLO) */
+    int nref;           /* number of caches sharing the table */
+    lock_t lock;        /* lock flag */
+} glotbl_t;
+
+typedef struct {        /* precise ephemeris interpolation window type */
+    const void *peph;   /* precise ephemeris of window */
+    int ne;             /* number of precise ephemeris */
+    int i0;             /* start index of window (-1: no window) */
+    double w[NMAXPEPH+1]; /* barycentric weights of nodes */
+    double cosa[NMAXPEPH+1],sina[NMAXPEPH+1]; /* earth rotation of nodes from node 0 */
+} pephwin_t;
+
+typedef struct {        /* satellite state cache type */
+    double tol;         /* tolerance of time to reuse cached state (s) */
+    uint32_t nhit,nmiss; /* number of cache hits and misses */
+    satstate_t sat[MAXSAT][2]; /* cached states of satellites */
+    glotbl_t *glo;      /* glonass orbit state table (shared by caches) */
+    pephwin_t pwin;     /* precise ephemeris interpolation window */
+    int pidx,cidx;      /* cursors of precise ephemeris and clock */
+} satcache_t;
+
+typedef struct {        /* earth orientation cache type */
+    double tol;         /* tolerance of time to reuse precession-nutation (s) */
+    gtime_t tnp;        /* utc time of precession-nutation ({0}: no cache) */
+    double NP[9];       /* precession-nutation matrix */
+    double eqe[2];      /* terms of equation of equinoxes (rad) */
+    gtime_t tsm;        /* utc time of sun and moon positions ({0}: no cache) */
+    double erpv[3];     /* erp values {xp,yp,ut1_utc} of sun and moon positions */
+    double rsun[3],rmoon[3]; /* sun and moon positions (ecef) (m) */
+    double gmst;        /* gmst of sun and moon positions (rad) */
+    int smf;            /* flags of sun and moon positions (1:sun,2:moon) */
+    gtime_t t0;         /* utc time of first table node */
+    double tint;        /* interval of table nodes (s) (0: no table) */
+    int n;              /* number of table nodes */
+    double *tbl;        /* precession-nutation table {NP,eqe} (11 x n) */
+    uint32_t nhit,nmiss; /* number of cache hits and misses */
+    lock_t lock;        /* lock flag */
+} eoc_t;
+
 typedef struct {
     int n, nmax;         /* number of broadcast ephemeris - 㲥 */
     int ng, ngmax;       /* number of GLONASS ephemeris - GLONASS */
@@ -848,6 +956,10 @@ typedef struct {
     sbsion_t sbsion[MAXBAND + 1]; /* SBAS ionosphere corrections - SBASĵ */
     dgps_t dgps[MAXSAT]; /* DGPS corrections - DGPSGPS */
     ssr_t ssr[MAXSAT];  /* SSR corrections - SSRض */
+    ephidx_t eidx[3];   /* ephemeris indices {eph,geph,seph} */
+    satcache_t *sc;     /* satellite state cache (NULL: no cache)
+                           (updated through const nav_t *, one per thread) */
+    eoc_t *eoc;         /* earth orientation cache (NULL: no cache) */
 } nav_t;
 
 typedef struct {        /* station parameter type */
@@ -966,6 +1078,37 @@ typedef struct {        /* RINEX control struct type */
     char   opt[256];    /* rinex dependent options */
 } rnxctr_t;
 
+typedef struct {        /* RINEX OBS stream position type */
+    long   off;         /* file offset */
+    int    nep;         /* number of input epochs before offset */
+    int    n1;          /* number of obs data of last input record */
+    gtime_t time1;      /* time of last input epoch before offset */
+    double dtime1;      /* interval of last input epoch (s) */
+    uint8_t slips[MAXSAT][NFREQ+NEXOBS]; /* cycle slips of screened epochs */
+} rnxpos_t;
+
+typedef struct {        /* RINEX OBS stream type */
+    FILE   *fp;         /* file pointer */
+    char   tmpfile[1024]; /* uncompressed temporary file ("": none) */
+    double ver;         /* RINEX version */
+    int    tsys;        /* time system */
+    int    rcv;         /* receiver number */
+    char   tobs[8][MAXOBSTYPE][4]; /* rinex obs types */
+    char   opt[256];    /* RINEX options */
+    gtime_t ts,te;      /* observation time start/end (time==0: no limit) */
+    double tint;        /* observation time interval (s) (0:all) */
+    sta_t  *sta;        /* station parameters (NULL: no input) */
+    long   body;        /* file offset of observation data body */
+    obsd_t *data;       /* buffer of pending and input epochs */
+    int    n;           /* number of obs data of pending epoch (-1: none) */
+    rnxpos_t pos;       /* stream position of pending epoch */
+    int    nep;         /* number of input epochs */
+    int    n1;          /* number of obs data of last input record */
+    gtime_t time1;      /* time of last input epoch */
+    double dtime1;      /* interval of last input epoch (s) */
+    uint8_t slips[MAXSAT][NFREQ+NEXOBS]; /* cycle slips of screened epochs */
+} rnxobs_t;
+
 typedef struct {        /* download URL type */
     char type[32];      /* data type */
     char path[1024];    /* URL path */
@@ -1050,6 +1193,15 @@ typedef struct {        /* 
     double odisp[2][6 * 11]; /* ϫز {վ,׼վ} */
     int freqopt;        /* L2-AR */
     char pppopt[256];   /* pppѡ */
+    int kfopt;          /* kalman filter cov update (KFOPT_???) */
+    int nslice;         /* number of time slices of post-processing (0,1:off) */
+    double tslice;      /* warm-up overlap of time slices (s) */
+    int slicechk;       /* check time slices by single-pass (0:off,1:on) */
+    int obswin;         /* look-ahead window of streamed obs input (epochs)
+                           (0:load all obs data) */
+    int matbe;          /* matrix backend (MATBE_???) */
+    int matnth;         /* size threshold of matrix backend (0:default) */
+    int nthread;        /* number of ambiguity search threads (0,1:single) */
 } prcopt_t;
 
 typedef struct {        /* ѡ */
@@ -1087,6 +1239,8 @@ typedef struct {        /* 
     char geexe[MAXSTRPATH];    /* Google Earthִļ· */
     char solstat[MAXSTRPATH];  /* ͳļ· */
     char trace[MAXSTRPATH];    /* ׷ļ· */
+    char pcache[MAXSTRPATH];   /* product cache directory ("": no cache) */
+    char blaslib[MAXSTRPATH];  /* BLAS/LAPACK library ("": libopenblas) */
 } filopt_t;
 
 typedef struct {        /* RINEX options type */
@@ -1182,6 +1336,38 @@ typedef struct {        /* ambiguity control type */
     char flags[MAXSAT]; /* fix flags */
 } ambc_t;
 
+typedef struct {        /* kalman filter workspace type */
+    int mode;           /* covariance update mode (KFOPT_???) */
+    int nd,ni;          /* allocated size of work arrays */
+    double *d;          /* work array of double (nd x 1) */
+    int *i;             /* work array of int (ni x 1) */
+} filtws_t;
+
+typedef struct {        /* lambda workspace type */
+    int nd;             /* allocated size of work array */
+    double *d;          /* work array of double (nd x 1) */
+    int maxnode;        /* max number of search nodes (0:default) */
+    int nthread;        /* number of search threads (0,1:single thread) */
+    int deadline;       /* deadline enable flag (0:off,1:on) */
+    uint32_t tdead;     /* deadline of search (tickget() value) */
+    int nnode;          /* number of visited search nodes */
+    int opt;            /* search status (1:optimal,0:best-effort) */
+    const int *key;     /* ambiguity keys to reuse Z-transform (NULL:no reuse) */
+    int nz,nzmax;       /* number of cached ambiguities, allocated size */
+    int *zkey;          /* keys of cached ambiguities (nzmax*2 x 1) */
+    double *Zc,*Zic;    /* cached Z-transform and inverse (nzmax x nzmax) */
+    int nwarm,nfull;    /* number of warm-started and full reductions */
+} lambdaws_t;
+
+typedef struct {        /* tidal displacement cache type */
+    double tint;        /* interval of nodes (s) (0:no cache) */
+    int n;              /* number of valid nodes (0:empty) */
+    double k0;          /* node index of first node (node time=k*tint) */
+    double sm[4][7];    /* sun/moon positions (ecef) (m) and gmst (rad) */
+    double erpv[4][3];  /* erp values {xp,yp,ut1_utc} at nodes (rad|s) */
+    int nnode,ncall;    /* number of evaluated nodes and calls */
+} tidec_t;
+
 typedef struct {        /* RTK control/result type (RTK /)sol_tprcopt_tṹ */
     sol_t  sol;         /* RTK solution (RTK ) */
     double rb[6];       /* base position/velocity (ecef) (m|m/s)
@@ -1214,6 +1400,11 @@ typedef struct {        /* RTK control/result type (RTK 
                            ѡ */
     int initial_mode;   /* initial positioning mode
                            ʼλģʽ */
+    filtws_t fws;       /* kalman filter workspace */
+    lambdaws_t lws;     /* lambda workspace */
+    tidec_t tidec[2];   /* tidal displacement caches (0:rover,1:base) */
+    obsd_t obsb[MAXOBS]; /* base obs for time-interpolation of residuals */
+    int nb;             /* number of base obs for time-interpolation */
 } rtk_t;
 
 typedef struct {        /* receiver raw data control type */
@@ -1297,6 +1488,51 @@ typedef struct {        /* stream server type */
     lock_t lock;        /* lock flag */
 } strsvr_t;
 
+typedef struct postpos_tag { /* post-processing context type */
+    int global;         /* open/close process-wide trace, solution status and
+                           geoid in the session (0:off,1:on) */
+    const struct postpos_tag *shared; /* context holding products shared by
+                           sessions (NULL: read products in the session) */
+    pcvs_t pcvss;       /* satellite antenna parameters */
+    pcvs_t pcvsr;       /* receiver antenna parameters */
+    obs_t obss;         /* observation data */
+    struct obsstr_tag *ostr; /* streamed obs input (NULL: obs data loaded) */
+    nav_t navs;         /* navigation data */
+    sbs_t sbss;         /* sbas messages */
+    sta_t stas[MAXRCV]; /* station infomation */
+    int nepoch;         /* number of observation epochs */
+    int nitm;           /* number of invalid time marks */
+    int iobsu;          /* current rover observation data index */
+    int iobsr;          /* current reference observation data index */
+    int isbs;           /* current sbas message index */
+    int iitm;           /* current invalid time mark index */
+    int revs;           /* analysis direction (0:forward,1:backward) */
+    int aborts;         /* abort status */
+    sol_t *solf;        /* forward solutions */
+    sol_t *solb;        /* backward solutions */
+    double *rbf;        /* forward base positions */
+    double *rbb;        /* backward base positions */
+    int isolf;          /* current forward solutions index */
+    int isolb;          /* current backward solutions index */
+    char proc_rov [64]; /* rover for current processing */
+    char proc_base[64]; /* base station for current processing */
+    char rtcm_file[1024]; /* rtcm data file */
+    char rtcm_path[1024]; /* rtcm data path */
+    gtime_t invalidtm[MAXINVALIDTM]; /* invalid time marks */
+    rtcm_t rtcm;        /* rtcm control struct */
+    FILE *fp_rtcm;      /* rtcm data file pointer */
+} postpos_t;
+
+typedef struct {        /* post-processing batch job type */
+    gtime_t ts,te;      /* processing start/end time (0:no limit) */
+    double ti;          /* processing interval (s) (0:all) */
+    prcopt_t popt;      /* processing options */
+    char rov [64];      /* rover id (keyword %r) */
+    char base[64];      /* base station id (keyword %b) */
+    char outfile[1024]; /* output file (keywords replaced) */
+    int stat;           /* status (0:ok,-1:error,1:aborted,2:not processed) */
+} ppjob_t;
+
 typedef struct {        /* RTK server type */
     int state;          /* server state (0:stop,1:running) */
     int cycle;          /* processing cycle (ms) */
@@ -1407,13 +1643,22 @@ EXPORT int  normv3(const double *a, double *b);
 EXPORT void matcpy(double *A, const double *B, int n, int m);
 EXPORT void matmul(const char *tr, int n, int k, int m, double alpha,
                    const double *A, const double *B, double beta, double *C);
+EXPORT void matmul3(const char *tr, const double *A, const double *B,
+                    double *C);
+EXPORT void matmul3v(const char *tr, const double *A, const double *b,
+                     double *c);
 EXPORT int  matinv(double *A, int n);
+EXPORT int  matinvspd(double *A, int n, double *cond);
 EXPORT int  solve (const char *tr, const double *A, const double *Y, int n,
                    int m, double *X);
+EXPORT int  setmatbackend(int backend, int nthres, const char *lib);
 EXPORT int  lsq   (const double *A, const double *y, int n, int m, double *x,
                    double *Q);
 EXPORT int  filter(double *x, double *P, const double *H, const double *v,
                    const double *R, int n, int m);
+EXPORT int  filterws(double *x, double *P, const double *H, const double *v,
+                     const double *R, int n, int m, filtws_t *ws);
+EXPORT void freefiltws(filtws_t *ws);
 EXPORT int  smoother(const double *xf, const double *Qf, const double *xb,
                      const double *Qb, int n, double *xs, double *Qs);
 EXPORT void matprint (const double *A, int n, int m, int p, int q);
@@ -1467,6 +1712,8 @@ EXPORT void covenu  (const double *pos, const double *P, double *Q);
 EXPORT void covecef (const double *pos, const double *Q, double *P);
 EXPORT void xyz2enu (const double *pos, double *E);
 EXPORT void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst);
+EXPORT void eci2ecefc(eoc_t *eoc, gtime_t tutc, const double *erpv, double *U,
+                      double *gmst);
 EXPORT void deg2dms (double deg, double *dms, int ndec);
 EXPORT double dms2deg(const double *dms);
 
@@ -1474,6 +1721,10 @@ EXPORT double dms2deg(const double *dms);
 EXPORT void readpos(const char *file, const char *rcv, double *pos);
 EXPORT int  sortobs(obs_t *obs);
 EXPORT void uniqnav(nav_t *nav);
+EXPORT void ephindex(nav_t *nav);
+EXPORT void updephindex(nav_t *nav, int type, int i);
+EXPORT int  ephindexwin(const nav_t *nav, int type, int sat, gtime_t time,
+                        double tmax, const int **idx);
 EXPORT int  screent(gtime_t time, gtime_t ts, gtime_t te, double tint);
 EXPORT int  readnav(const char *file, nav_t *nav);
 EXPORT int  savenav(const char *file, const nav_t *nav);
@@ -1503,6 +1754,8 @@ EXPORT int gettracelevel(void);
 EXPORT int execcmd(const char *cmd);
 EXPORT int expath (const char *path, char *paths[], int nmax);
 EXPORT void createdir(const char *path);
+EXPORT const uint8_t *mapfile(const char *file, size_t *size);
+EXPORT void unmapfile(const uint8_t *p, size_t size);
 
 /* positioning models --------------------------------------------------------*/
 EXPORT double satazel(const double *pos, const double *e, double *azel);
@@ -1530,17 +1783,32 @@ EXPORT int seliflc(int optnf, int sys);
 
 /* antenna models ------------------------------------------------------------*/
 EXPORT int  readpcv(const char *file, pcvs_t *pcvs);
+EXPORT int  pcvindex(pcvs_t *pcvs);
+EXPORT void freepcv(pcvs_t *pcvs);
 EXPORT pcv_t *searchpcv(int sat, const char *type, gtime_t time,
                         const pcvs_t *pcvs);
 EXPORT void antmodel(const pcv_t *pcv, const double *del, const double *azel,
                      int opt, double *dant);
 EXPORT void antmodel_s(const pcv_t *pcv, double nadir, double *dant);
+EXPORT void initpcvtbl(const pcv_t *pcv, const double *del, int opt,
+                       pcvtbl_t *tbl);
+EXPORT void antmodeln(const pcvtbl_t *tbl, const double *e, int n,
+                      double *dant);
 
 /* earth tide models ---------------------------------------------------------*/
 EXPORT void sunmoonpos(gtime_t tutc, const double *erpv, double *rsun,
                        double *rmoon, double *gmst);
+EXPORT void sunmoonposc(eoc_t *eoc, gtime_t tutc, const double *erpv,
+                        double *rsun, double *rmoon, double *gmst);
+EXPORT int  eocinit(nav_t *nav, double tol);
+EXPORT int  eoctable(nav_t *nav, gtime_t ts, gtime_t te, double tint);
+EXPORT void eocfree(nav_t *nav);
 EXPORT void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
                      const double *odisp, double *dr);
+EXPORT void inittidec(tidec_t *tc, double tint);
+EXPORT void tidedispc(tidec_t *tc, eoc_t *eoc, gtime_t tutc, const double *rr,
+                      int opt, const erp_t *erp, const double *odisp,
+                      double *dr);
 
 /* geiod models --------------------------------------------------------------*/
 EXPORT int opengeoid(int model, const char *file);
@@ -1578,6 +1846,12 @@ EXPORT int  init_rnxctr (rnxctr_t *rnx);
 EXPORT void free_rnxctr (rnxctr_t *rnx);
 EXPORT int  open_rnxctr (rnxctr_t *rnx, FILE *fp);
 EXPORT int  input_rnxctr(rnxctr_t *rnx, FILE *fp);
+EXPORT int  open_rnxobs (rnxobs_t *rnx, const char *file, int rcv, gtime_t ts,
+                         gtime_t te, double tint, const char *opt, nav_t *nav,
+                         sta_t *sta);
+EXPORT void close_rnxobs(rnxobs_t *rnx);
+EXPORT int  seek_rnxobs (rnxobs_t *rnx, const rnxpos_t *pos);
+EXPORT int  input_rnxobs(rnxobs_t *rnx, obsd_t *data, rnxpos_t *pos);
 
 /* ephemeris and clock functions ---------------------------------------------*/
 EXPORT double eph2clk (gtime_t time, const eph_t  *eph);
@@ -1591,6 +1865,9 @@ EXPORT void seph2pos(gtime_t time, const seph_t *seph, double *rs, double *dts,
                      double *var);
 EXPORT int  peph2pos(gtime_t time, int sat, const nav_t *nav, int opt,
                      double *rs, double *dts, double *var);
+EXPORT int  peph2poss(const gtime_t *time, const int *sat, int n,
+                      const nav_t *nav, int opt, double *rs, double *dts,
+                      double *var, int *stat);
 EXPORT void satantoff(gtime_t time, const double *rs, int sat, const nav_t *nav,
                       double *dant);
 EXPORT int  satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
@@ -1599,10 +1876,19 @@ EXPORT int  satpos(gtime_t time, gtime_t teph, int sat, int ephopt,
 EXPORT void satposs(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                     int sateph, double *rs, double *dts, double *var, int *svh);
 EXPORT void setseleph(int sys, int sel);
+EXPORT void setephindex(int mode);
+EXPORT int  satcacheinit(nav_t *nav, double tol);
+EXPORT int  satcacheshare(nav_t *nav, const nav_t *src);
+EXPORT void satcachefree(nav_t *nav);
 EXPORT int  getseleph(int sys);
 EXPORT void readsp3(const char *file, nav_t *nav, int opt);
 EXPORT int  readsap(const char *file, gtime_t time, nav_t *nav);
 EXPORT int  readdcb(const char *file, nav_t *nav, const sta_t *sta);
+EXPORT int  readpephcache(char **files, int n, int opt, const char *dir,
+                          nav_t *nav);
+EXPORT int  readpcvcache(const char *file, const char *dir, pcvs_t *pcvs);
+EXPORT int  readdcbcache(const char *file, const char *dir, nav_t *nav,
+                         const sta_t *sta);
 EXPORT int  readfcb(const char *file, nav_t *nav);
 EXPORT void alm2pos(gtime_t time, const alm_t *alm, double *rs, double *dts);
 
@@ -1784,6 +2070,9 @@ EXPORT int lambda(int n, int m, const double *a, const double *Q, double *F,
 EXPORT int lambda_reduction(int n, const double *Q, double *Z);
 EXPORT int lambda_search(int n, int m, const double *a, const double *Q,
                          double *F, double *s);
+EXPORT int lambdaws(int n, int m, const double *a, const double *Q, double *F,
+                    double *s, lambdaws_t *ws);
+EXPORT void freelambdaws(lambdaws_t *ws);
 
 /* standard positioning ------------------------------------------------------*/
 EXPORT int pntpos(const obsd_t *obs, int n, const nav_t *nav,
@@ -1811,6 +2100,14 @@ EXPORT int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
                    const filopt_t *fopt, char **infile, int n, char *outfile,
                    const char *rov, const char *base);
+EXPORT void postposinit(postpos_t *pp, int global);
+EXPORT int  postposrun(postpos_t *pp, gtime_t ts, gtime_t te, double ti,
+                       double tu, const prcopt_t *popt, const solopt_t *sopt,
+                       const filopt_t *fopt, char **infile, int n,
+                       char *outfile, const char *rov, const char *base);
+EXPORT int  postposbatch(ppjob_t *job, int njob, int nthread,
+                         const prcopt_t *popt, const solopt_t *sopt,
+                         const filopt_t *fopt, char **infile, int n);
 
 /* stream server functions ---------------------------------------------------*/
 EXPORT void strsvrinit (strsvr_t *svr, int nout);
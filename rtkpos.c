@@ -46,6 +46,12 @@
 *                           add detecting cycle slips by L1-Lx GF phase jump
 *                           delete GLONASS IFB correction in ddres()
 *                           use integer types in stdint.h
+*           2026/10/17 1.17 use receiver antenna model table in zdres()
+*                           evaluate receiver antenna model for all
+*                           satellites at once in zdres()
+*           2026/10/17 1.18 use tidal displacement cache in zdres()
+*                           keep base obs of intpres() in rtk_t for reentrancy
+*                           set ambiguity search threads by opt->nthread
 *-----------------------------------------------------------------------------*/
 #include <stdarg.h>
 #include "rtklib.h"
@@ -69,6 +75,7 @@
 
 #define TTOL_MOVEB  (1.0+2*DTTOL)
                              /* time sync tolerance for moving-baseline (s) */
+#define TINT_TIDE   300.0    /* interval of tidal displacement cache (s) */
 
 /* number of parameters (pos,ionos,tropos,hw-bias,phase-bias,real,estimated) */
 #define NF(opt)     ((opt)->ionoopt==IONOOPT_IFLC?1:(opt)->nf)
@@ -978,16 +985,19 @@ static void zdres_sat(int base, double r, const obsd_t *obs, const nav_t *nav,
         I   rr   = rcvr pos (x,y,z)
         I   opt  = options
         I   index: 0=base,1=rover 
+        IO  tc   = tidal displacement cache of receiver
         O   y[(0:1)+i*2] = zero diff residuals {phase,code} (m)
         O   e    = line of sight unit vectors to sats
         O   azel = [az, el] to sats                                           */
 static int zdres(int base, const obsd_t *obs, int n, const double *rs,
                  const double *dts, const double *var, const int *svh,
                  const nav_t *nav, const double *rr, const prcopt_t *opt,
-                 int index, double *y, double *e, double *azel, double *freq)
+                 int index, tidec_t *tc, double *y, double *e, double *azel,
+                 double *freq)
 {
-    double r,rr_[3],pos[3],dant[NFREQ]={0},disp[3];
-    double mapfh,zhd,zazel[]={0.0,90.0*D2R};
+    pcvtbl_t pcvt;
+    double r,rr_[3],pos[3],disp[3],E[9],rg[MAXOBS*2],enu[MAXOBS*2*3];
+    double dant[MAXOBS*2*NFREQ],mapfh,zhd,zazel[]={0.0,90.0*D2R};
     int i,nf=NF(opt);
     
     trace(3,"zdres   : n=%d rr=%.2f %.2f %.2f\n",n,rr[0], rr[1], rr[2]);
@@ -1002,17 +1012,31 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
     
     /* adjust rcvr pos for earth tide correction */
     if (opt->tidecorr) {
-        tidedisp(gpst2utc(obs[0].time),rr_,opt->tidecorr,&nav->erp,
-                 opt->odisp[base],disp);
+        tidedispc(tc,nav->eoc,gpst2utc(obs[0].time),rr_,opt->tidecorr,
+                  &nav->erp,opt->odisp[base],disp);
         for (i=0;i<3;i++) rr_[i]+=disp[i];
     }
     /* translate rcvr pos from ecef to geodetic */
     ecef2pos(rr_,pos);
+    xyz2enu(pos,E);
+    
+    /* geometric-ranges and line-of-sight vectors to satellites */
+    for (i=0;i<n&&i<MAXOBS*2;i++) {
+        if ((rg[i]=geodist(rs+i*6,rr_,e+i*3))<=0.0) {
+            e[i*3]=e[1+i*3]=e[2+i*3]=0.0;
+        }
+    }
+    n=i;
+    
+    /* receiver antenna phase center corrections of satellites */
+    initpcvtbl(opt->pcvr+index,opt->antdel[index],opt->posopt[1],&pcvt);
+    if (n>0) matmul("NN",3,n,3,1.0,E,e,0.0,enu);
+    antmodeln(&pcvt,enu,n,dant);
     
     /* loop through satellites */
     for (i=0;i<n;i++) {
         /* compute geometric-range and azimuth/elevation angle */
-        if ((r=geodist(rs+i*6,rr_,e+i*3))<=0.0) continue;
+        if ((r=rg[i])<=0.0) continue;
         if (satazel(pos,e+i*3,azel+i*2)<opt->elmin) continue;
         
         /* excluded satellite? */
@@ -1026,13 +1050,10 @@ static int zdres(int base, const obsd_t *obs, int n, const double *rs,
         mapfh=tropmapf(obs[i].time,pos,azel+i*2,NULL);
         r+=mapfh*zhd;
         
-        /* calc receiver antenna phase center correction */
-        antmodel(opt->pcvr+index,opt->antdel[index],azel+i*2,opt->posopt[1],
-                 dant);
-        
         /* calc undifferenced phase/code residual for satellite */
         trace(4,"sat=%d r=%.6f c*dts=%.6f zhd=%.6f map=%.6f\n",obs[i].sat,r,CLIGHT*dts[i*2],zhd,mapfh);
-        zdres_sat(base,r,obs+i,nav,azel+i*2,dant,opt,y+i*nf*2,freq+i*nf);
+        zdres_sat(base,r,obs+i,nav,azel+i*2,dant+i*NFREQ,opt,y+i*nf*2,
+                  freq+i*nf);
     }
     trace(4,"rr_=%.3f %.3f %.3f\n",rr_[0],rr_[1],rr_[2]);
     trace(4,"pos=%.9f %.9f %.3f\n",pos[0]*R2D,pos[1]*R2D,pos[2]);
@@ -1391,18 +1412,17 @@ static int ddres(rtk_t *rtk, const nav_t *nav, const obsd_t *obs, double dt, con
 static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                       rtk_t *rtk, double *y)
 {
-    static obsd_t obsb[MAXOBS];
-    static double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS];
-    static double e[MAXOBS*3],azel[MAXOBS*2],freq[MAXOBS*NFREQ];
-    static int nb=0,svh[MAXOBS*2];
+    obsd_t *obsb=rtk->obsb;
+    double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS];
+    double e[MAXOBS*3],azel[MAXOBS*2],freq[MAXOBS*NFREQ];
     prcopt_t *opt=&rtk->opt;
     double tt=timediff(time,obs[0].time),ttb,*p,*q;
-    int i,j,k,nf=NF(opt);
+    int i,j,k,nf=NF(opt),nb=rtk->nb,svh[MAXOBS*2];
     
     trace(3,"intpres : n=%d tt=%.1f\n",n,tt);
     /* skip interpolation if delta time very small or > max age of diff */
     if (nb==0||fabs(tt)<DTTOL) {
-        nb=n; for (i=0;i<n;i++) obsb[i]=obs[i];
+        rtk->nb=n; for (i=0;i<n;i++) obsb[i]=obs[i];
         return tt;
     }
     ttb=timediff(time,obsb[0].time);
@@ -1410,7 +1430,8 @@ static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
     
     satposs(time,obsb,nb,nav,opt->sateph,rs,dts,var,svh);
     
-    if (!zdres(1,obsb,nb,rs,dts,var,svh,nav,rtk->rb,opt,1,yb,e,azel,freq)) {
+    if (!zdres(1,obsb,nb,rs,dts,var,svh,nav,rtk->rb,opt,1,rtk->tidec+1,
+               yb,e,azel,freq)) {
         return tt;
     }
     for (i=0;i<n;i++) {
@@ -1567,7 +1588,7 @@ static void holdamb(rtk_t *rtk, const double *xa)
     for (i=0;i<nv;i++) R[i+i*nv]=rtk->opt.varholdamb;
         
     /* update states with constraints */
-    if ((info=filter(rtk->x,rtk->P,H,v,R,rtk->nx,nv))) {
+    if ((info=filterws(rtk->x,rtk->P,H,v,R,rtk->nx,nv,&rtk->fws))) {
         errmsg(rtk,"filter error (info=%d)\n",info);
     }
     free(R);free(v); free(H);
@@ -1627,7 +1648,7 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa,int gps,int glo,in
     prcopt_t *opt=&rtk->opt;
     int i,j,nb,nb1,info,nx=rtk->nx,na=rtk->na;
     double *DP,*y,*b,*db,*Qb,*Qab,*QQ,s[2];
-    int *ix;
+    int *ix,*key;
     double coeff[3];
     double QQb[MAXSAT];
 
@@ -1646,7 +1667,7 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa,int gps,int glo,in
     rtk->nb_ar=nb;
     /* nx=# of float states, na=# of fixed states, nb=# of double-diff phase biases */
     y=mat(nb,1); DP=mat(nb,nx-na); b=mat(nb,2); db=mat(nb,1); Qb=mat(nb,nb);
-    Qab=mat(na,nb); QQ=mat(na,nb);
+    Qab=mat(na,nb); QQ=mat(na,nb); key=imat(nb,1);
 
 
     /* phase-bias covariance (Qb) and real-parameters to bias covariance (Qab) */
@@ -1671,7 +1692,13 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa,int gps,int glo,in
     /* lambda/mlambda integer least-square estimation */
     /* return best integer solutions */
     /* b are best integer solutions, s are residuals */
-    if (!(info=lambda(nb,2,y,Qb,b,s))) {
+    /* key of double-difference for reuse of Z-transform across epochs */
+    for (i=0;i<nb;i++) key[i]=ix[i*2]*nx+ix[i*2+1];
+    rtk->lws.key=key;
+    info=lambdaws(nb,2,y,Qb,b,s,&rtk->lws);
+    rtk->lws.key=NULL;
+    if (!info&&!rtk->lws.opt) info=-2; /* best-effort solutions not validated */
+    if (!info) {
         trace(3,"N(1)=     "); tracemat(3,b   ,1,nb,7,2);
         trace(3,"N(2)=     "); tracemat(3,b+nb,1,nb,7,2);
 
@@ -1740,7 +1767,7 @@ static int resamb_LAMBDA(rtk_t *rtk, double *bias, double *xa,int gps,int glo,in
         errmsg(rtk,"lambda error (info=%d)\n",info);
         nb=0;
     }
-    free(ix);
+    free(ix); free(key);
     free(y); free(DP); free(b); free(db); free(Qb); free(Qab); free(QQ);
     
     return nb; /* number of ambiguities */
@@ -1918,7 +1945,7 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
          output is in y[nu:nu+nr], see call for rover below for more details                                                 */
     trace(3,"base station:\n");
     if (!zdres(1,obs+nu,nr,rs+nu*6,dts+nu*2,var+nu,svh+nu,nav,rtk->rb,opt,1,
-               y+nu*nf*2,e+nu*3,azel+nu*2,freq+nu*nf)) {
+               rtk->tidec+1,y+nu*nf*2,e+nu*3,azel+nu*2,freq+nu*nf)) {
         errmsg(rtk,"initial base station position error\n");
         
         free(rs); free(dts); free(var); free(y); free(e); free(azel);
@@ -1975,7 +2002,8 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
                 y    = zero diff residuals (code and phase)
                 e    = line of sight unit vectors to sats
                 azel = [az, el] to sats                                   */
-        if (!zdres(0,obs,nu,rs,dts,var,svh,nav,xp,opt,0,y,e,azel,freq)) {
+        if (!zdres(0,obs,nu,rs,dts,var,svh,nav,xp,opt,0,rtk->tidec,y,e,azel,
+                  freq)) {
             errmsg(rtk,"rover initial position error\n");
             stat=SOLQ_NONE;
             break;
@@ -2002,7 +2030,7 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
                 xp=x+K*v
                 Pp=(I-K*H')*P                  */
         trace(3,"before filter x=");tracemat(3,rtk->x,1,9,13,6);
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if ((info=filterws(xp,Pp,H,v,R,rtk->nx,nv,&rtk->fws))) {
             errmsg(rtk,"filter error (info=%d)\n",info);
             stat=SOLQ_NONE;
             break;
@@ -2011,7 +2039,8 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         trace(4,"x(%d)=",i+1); tracemat(4,xp,1,NR(opt),13,4);
     }
     /* calc zero diff residuals again after kalman filter update */
-    if (stat!=SOLQ_NONE&&zdres(0,obs,nu,rs,dts,var,svh,nav,xp,opt,0,y,e,azel,freq)) {
+    if (stat!=SOLQ_NONE&&zdres(0,obs,nu,rs,dts,var,svh,nav,xp,opt,0,rtk->tidec,
+                               y,e,azel,freq)) {
         
         /* calc double diff residuals again after kalman filter update for float solution */
         nv=ddres(rtk,nav,obs,dt,xp,Pp,sat,y,e,azel,freq,iu,ir,ns,v,NULL,R,vflg);
@@ -2041,7 +2070,8 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         if (manage_amb_LAMBDA(rtk,bias,xa,sat,nf,ns)>1) {
 
             /* find zero-diff residuals for fixed solution */
-            if (zdres(0,obs,nu,rs,dts,var,svh,nav,xa,opt,0,y,e,azel,freq)) {
+            if (zdres(0,obs,nu,rs,dts,var,svh,nav,xa,opt,0,rtk->tidec,y,e,azel,
+                      freq)) {
 
                 /* post-fit residuals for fixed solution (xa includes fixed phase biases, rtk->xa does not) */
                 nv=ddres(rtk,nav,obs,dt,xa,Pp,sat,y,e,azel,freq,iu,ir,ns,v,NULL,R,
@@ -2134,12 +2164,15 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
 * args   : rtk_t    *rtk    IO  TKk control/result struct
 *          prcopt_t *opt    I   positioning options (see rtklib.h)
 * return : none
+* notes  : rtk initialized before should be freed by rtkfree() before
 *-----------------------------------------------------------------------------*/
 extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
 {
     sol_t sol0={{0}};
     ambc_t ambc0={{{0}}};
     ssat_t ssat0={0};
+    filtws_t fws0={0};
+    lambdaws_t lws0={0};
     int i;
     
     trace(3,"rtkinit :\n");
@@ -2165,6 +2198,12 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     rtk->opt=*opt;
     rtk->initial_mode=rtk->opt.mode;
     rtk->sol.thres=(float)opt->thresar[0];
+    rtk->fws=fws0;
+    rtk->fws.mode=opt->kfopt;
+    rtk->lws=lws0;
+    rtk->lws.nthread=opt->nthread;
+    for (i=0;i<2;i++) inittidec(rtk->tidec+i,TINT_TIDE);
+    rtk->nb=0;
 }
 /* free rtk control ------------------------------------------------------------
 * free memory for rtk control struct
@@ -2180,6 +2219,8 @@ extern void rtkfree(rtk_t *rtk)
     free(rtk->P ); rtk->P =NULL;
     free(rtk->xa); rtk->xa=NULL;
     free(rtk->Pa); rtk->Pa=NULL;
+    freefiltws(&rtk->fws);
+    freelambdaws(&rtk->lws);
 }
 /* precise positioning ---------------------------------------------------------
 * input observation data and navigation message, compute rover position by 
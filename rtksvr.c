@@ -42,6 +42,11 @@
 *                            handle multiple ephemeris sets in updatesvr()
 *                            use API sat2freq() to get carrier frequency
 *                            use integer types in stdint.h
+*           2026/10/17  1.23 bound ambiguity search time by server cycle
+*                            index ephemeris and update index in update_eph()
+*                            cache satellite states in svr->nav
+*                            cache earth orientation in svr->nav
+*                            set matrix backend by processing options
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -176,6 +181,8 @@ static void update_eph(rtksvr_t *svr, nav_t *nav, int ephsat, int ephset,
                  timediff(eph1->toc,eph2->toc)!=0.0)) {
                 *eph3=*eph2; /* current ->previous */
                 *eph2=*eph1; /* received->current */
+                updephindex(&svr->nav,0,(int)(eph3-svr->nav.eph));
+                updephindex(&svr->nav,0,(int)(eph2-svr->nav.eph));
                 }
             }
             svr->nmsg[index][1]++;
@@ -189,6 +196,8 @@ static void update_eph(rtksvr_t *svr, nav_t *nav, int ephsat, int ephset,
                    (geph1->iode!=geph3->iode&&geph1->iode!=geph2->iode)) {
                    *geph3=*geph2;
                    *geph2=*geph1;
+                   updephindex(&svr->nav,1,(int)(geph3-svr->nav.geph));
+                   updephindex(&svr->nav,1,(int)(geph2-svr->nav.geph));
                 update_glofcn(svr);
                }
            }
@@ -636,8 +645,10 @@ static void *rtksvrthread(void *arg)
             if (!strstr(svr->rtk.opt.pppopt,"-DIS_FCB")) {
                 corr_phase_bias(obs.data,obs.n,&svr->nav);
             }
-            /* rtk positioning */
+            /* rtk positioning (ambiguity search bounded by server cycle) */
             rtksvrlock(svr);
+            svr->rtk.lws.deadline=1;
+            svr->rtk.lws.tdead=tickget()+svr->cycle;
             rtkpos(&svr->rtk,obs.data,obs.n,&svr->nav);
             rtksvrunlock(svr);
             
@@ -740,6 +751,9 @@ extern int rtksvrinit(rtksvr_t *svr)
     svr->nav.n =MAXSAT *2;
     svr->nav.ng=NSATGLO*2;
     svr->nav.ns=NSATSBS*2;
+    ephindex(&svr->nav);
+    satcacheinit(&svr->nav,DTTOLSC);
+    eocinit(&svr->nav,DTTOLEOC);
     
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
         if (!(svr->obs[i][j].data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) {
@@ -769,9 +783,9 @@ extern void rtksvrfree(rtksvr_t *svr)
 {
     int i,j;
     
-    free(svr->nav.eph );
-    free(svr->nav.geph);
-    free(svr->nav.seph);
+    freenav(&svr->nav,0x01|0x02|0x04);
+    satcachefree(&svr->nav);
+    eocfree(&svr->nav);
     for (i=0;i<3;i++) for (j=0;j<MAXOBSBUF;j++) {
         free(svr->obs[i][j].data);
     }
@@ -857,6 +871,9 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     svr->nsbs=0;
     svr->nsol=0;
     svr->prcout=0;
+    if (!setmatbackend(prcopt->matbe,prcopt->matnth,NULL)) {
+        tracet(2,"rtksvrstart: matrix backend error %d\n",prcopt->matbe);
+    }
     rtkfree(&svr->rtk);
     rtkinit(&svr->rtk,prcopt);
     
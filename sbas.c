@@ -36,6 +36,9 @@
 *                           add prn mask of qzss for qzss L1SAIF
 *           2016/07/29 1.9  crc24q() -> rtk_crc24q()
 *           2020/11/30 1.10 use integer types in stdint.h
+*           2026/10/17 1.11 update ephemeris index in decode_sbstype9()
+*                           delete static zenith delays in sbstropcorr() for
+*                           thread-safety
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -260,6 +263,8 @@ static int decode_sbstype9(const sbsmsg_t *msg, nav_t *nav)
     }
     nav->seph[NSATSBS+i]=nav->seph[i]; /* previous */
     nav->seph[i]=seph;                 /* current */
+    updephindex(nav,2,NSATSBS+i);
+    updephindex(nav,2,i);
 
     trace(5,"decode_sbstype9: prn=%d\n",msg->prn);
     return 1;
@@ -753,9 +758,8 @@ extern double sbstropcorr(gtime_t time, const double *pos, const double *azel,
                           double *var)
 {
     const double k1=77.604,k2=382000.0,rd=287.054,gm=9.784,g=9.80665;
-    static double pos_[3]={0},zh=0.0,zw=0.0;
     int i;
-    double c,met[10],sinel=sin(azel[1]),h=pos[2],m;
+    double c,met[10],sinel=sin(azel[1]),h=pos[2],m,zh,zw;
     
     trace(4,"sbstropcorr: pos=%.3f %.3f azel=%.3f %.3f\n",pos[0]*R2D,pos[1]*R2D,
           azel[0]*R2D,azel[1]*R2D);
@@ -764,17 +768,14 @@ extern double sbstropcorr(gtime_t time, const double *pos, const double *azel,
         *var=0.0;
         return 0.0;
     }
-    if (zh==0.0||fabs(pos[0]-pos_[0])>1E-7||fabs(pos[1]-pos_[1])>1E-7||
-        fabs(pos[2]-pos_[2])>1.0) {
-        getmet(pos[0]*R2D,met);
-        c=cos(2.0*PI*(time2doy(time)-(pos[0]>=0.0?28.0:211.0))/365.25);
-        for (i=0;i<5;i++) met[i]-=met[i+5]*c;
-        zh=1E-6*k1*rd*met[0]/gm;
-        zw=1E-6*k2*rd/(gm*(met[4]+1.0)-met[3]*rd)*met[2]/met[1];
-        zh*=pow(1.0-met[3]*h/met[1],g/(rd*met[3]));
-        zw*=pow(1.0-met[3]*h/met[1],(met[4]+1.0)*g/(rd*met[3])-1.0);
-        for (i=0;i<3;i++) pos_[i]=pos[i];
-    }
+    getmet(pos[0]*R2D,met);
+    c=cos(2.0*PI*(time2doy(time)-(pos[0]>=0.0?28.0:211.0))/365.25);
+    for (i=0;i<5;i++) met[i]-=met[i+5]*c;
+    zh=1E-6*k1*rd*met[0]/gm;
+    zw=1E-6*k2*rd/(gm*(met[4]+1.0)-met[3]*rd)*met[2]/met[1];
+    zh*=pow(1.0-met[3]*h/met[1],g/(rd*met[3]));
+    zw*=pow(1.0-met[3]*h/met[1],(met[4]+1.0)*g/(rd*met[3])-1.0);
+    
     m=1.001/sqrt(0.002001+sinel*sinel);
     *var=0.12*0.12*m*m;
     return (zh+zw)*m;
@@ -53,6 +53,8 @@
 *                            add reading age information in NMEA GGA
 *                            use integer types in stdint.h
 *                            suppress warnings
+*           2026/10/17  1.19 output null course of NMEA RMC under 1 m/s
+*                            instead of static last course
 *-----------------------------------------------------------------------------*/
 #include <ctype.h>
 #include "rtklib.h"
@@ -1341,13 +1343,13 @@ static int outenu(uint8_t *buff, const char *s, const sol_t *sol,
                sep,sqvar(Q[5]),sep,sqvar(Q[2]),sep,sol->age,sep,sol->ratio);
     return (int)(p-(char *)buff);
 }
-/* output solution in the form of NMEA RMC sentence --------------------------*/
+/* output solution in the form of NMEA RMC sentence ---------------------------
+* course over ground is null if speed is under 1 m/s                         */
 extern int outnmea_rmc(uint8_t *buff, const sol_t *sol)
 {
-    static double dirp=0.0;
     gtime_t time;
     double ep[6],pos[3],enuv[3],dms1[3],dms2[3],vel,dir,amag=0.0;
-    char *p=(char *)buff,*q,sum;
+    char *p=(char *)buff,*q,sum,cog[16]="";
     const char *emag="E",*mode="A",*status="V";
     
     trace(3,"outnmea_rmc:\n");
@@ -1367,10 +1369,7 @@ extern int outnmea_rmc(uint8_t *buff, const sol_t *sol)
     if (vel>=1.0) {
         dir=atan2(enuv[0],enuv[1])*R2D;
         if (dir<0.0) dir+=360.0;
-        dirp=dir;
-    }
-    else {
-        dir=dirp;
+        sprintf(cog,"%4.2f",dir);
     }
     if      (sol->stat==SOLQ_DGPS ||sol->stat==SOLQ_SBAS) mode="D";
     else if (sol->stat==SOLQ_FLOAT||sol->stat==SOLQ_FIX ) mode="R";
@@ -1378,10 +1377,10 @@ extern int outnmea_rmc(uint8_t *buff, const sol_t *sol)
     deg2dms(fabs(pos[0])*R2D,dms1,7);
     deg2dms(fabs(pos[1])*R2D,dms2,7);
     p+=sprintf(p,"$%sRMC,%02.0f%02.0f%05.2f,A,%02.0f%010.7f,%s,%03.0f%010.7f,"
-               "%s,%4.2f,%4.2f,%02.0f%02.0f%02d,%.1f,%s,%s,%s",
+               "%s,%4.2f,%s,%02.0f%02.0f%02d,%.1f,%s,%s,%s",
                NMEA_TID,ep[3],ep[4],ep[5],dms1[0],dms1[1]+dms1[2]/60.0,
                pos[0]>=0?"N":"S",dms2[0],dms2[1]+dms2[2]/60.0,pos[1]>=0?"E":"W",
-               vel/KNOT2M,dir,ep[2],ep[1],(int)ep[0]%100,amag,emag,mode,status);
+               vel/KNOT2M,cog,ep[2],ep[1],(int)ep[0]%100,amag,emag,mode,status);
     for (q=(char *)buff+1,sum=0;*q;q++) sum^=*q; /* check-sum */
     p+=sprintf(p,"*%02X\r\n",sum);
     return (int)(p-(char *)buff);
@@ -72,6 +72,7 @@ SOURCES += rtkcmn.c \
 HEADERS += rtklib.h
 
 unix {
+    LIBS += -ldl
     target.path = /usr/lib
     INSTALLS += target
 }
@@ -20,6 +20,8 @@
 * history : 2015/05/10 1.0  separated from ppp.c
 *           2015/06/11 1.1  fix bug on computing days in tide_oload() (#128)
 *           2017/04/11 1.2  fix bug on calling geterp() in timdedisp()
+*           2026/10/17 1.3  add tidal displacement cache tidedispc()
+*                           use earth orientation cache in tidedispc()
 *-----------------------------------------------------------------------------*/
 #include "rtklib.h"
 
@@ -30,6 +32,8 @@
 #define GMS         1.327124E+20    /* sun gravitational constant */
 #define GMM         4.902801E+12    /* moon gravitational constant */
 
+#define MAXDERPC    1E-4            /* max erp change to reuse nodes (as|s) */
+
 /* function prototypes -------------------------------------------------------*/
 #ifdef IERS_MODEL
 extern int dehanttideinel_(double *xsta, int *year, int *mon, int *day,
@@ -204,48 +208,20 @@ static void tide_pole(gtime_t tut, const double *pos, const double *erpv,
     
     trace(5,"tide_pole : denu=%.3f %.3f %.3f\n",denu[0],denu[1],denu[2]);
 }
-/* tidal displacement ----------------------------------------------------------
-* displacements by earth tides
-* args   : gtime_t tutc     I   time in utc
-*          double *rr       I   site position (ecef) (m)
-*          int    opt       I   options (or of the followings)
-*                                 1: solid earth tide
-*                                 2: ocean tide loading
-*                                 4: pole tide
-*                                 8: elimate permanent deformation
-*          double *erp      I   earth rotation parameters (NULL: not used)
-*          double *odisp    I   ocean loading parameters  (NULL: not used)
-*                                 odisp[0+i*6]: consituent i amplitude radial(m)
-*                                 odisp[1+i*6]: consituent i amplitude west  (m)
-*                                 odisp[2+i*6]: consituent i amplitude south (m)
-*                                 odisp[3+i*6]: consituent i phase radial  (deg)
-*                                 odisp[4+i*6]: consituent i phase west    (deg)
-*                                 odisp[5+i*6]: consituent i phase south   (deg)
-*                                (i=0:M2,1:S2,2:N2,3:K2,4:K1,5:O1,6:P1,7:Q1,
-*                                   8:Mf,9:Mm,10:Ssa)
-*          double *dr       O   displacement by earth tides (ecef) (m)
-* return : none
-* notes  : see ref [1], [2] chap 7
-*          see ref [4] 5.2.1, 5.2.2, 5.2.3
-*          ver.2.4.0 does not use ocean loading and pole tide corrections
-*-----------------------------------------------------------------------------*/
-extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
-                     const double *odisp, double *dr)
+/* tidal displacement by sun and moon positions ------------------------------*/
+static void tidesite(gtime_t tutc, const double *rr, int opt,
+                     const double *erpv, const double *odisp, const double *rs,
+                     const double *rm, double gmst, double *dr)
 {
     gtime_t tut;
-    double pos[2],E[9],drt[3],denu[3],rs[3],rm[3],gmst,erpv[5]={0};
+    double pos[2],E[9],drt[3],denu[3];
     int i;
 #ifdef IERS_MODEL
     double ep[6],fhr;
     int year,mon,day;
 #endif
     
-    trace(3,"tidedisp: tutc=%s\n",time_str(tutc,0));
-    
-    if (erp) {
-        geterp(erp,utc2gpst(tutc),erpv);
-    }
-    tut=timeadd(tutc,erpv[2]);
+    tut=timeadd(tutc,erpv?erpv[2]:0.0);
     
     dr[0]=dr[1]=dr[2]=0.0;
     
@@ -256,10 +232,6 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
     xyz2enu(pos,E);
     
     if (opt&1) { /* solid earth tides */
-        
-        /* sun and moon position in ecef */
-        sunmoonpos(tutc,erpv,rs,rm,&gmst);
-        
 #ifdef IERS_MODEL
         time2epoch(tutc,ep);
         year=(int)ep[0];
@@ -268,7 +240,8 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
         fhr =ep[3]+ep[4]/60.0+ep[5]/3600.0;
         
         /* call DEHANTTIDEINEL */
-        dehanttideinel_((double *)rr,&year,&mon,&day,&fhr,rs,rm,drt);
+        dehanttideinel_((double *)rr,&year,&mon,&day,&fhr,(double *)rs,
+                        (double *)rm,drt);
 #else
         tide_solid(rs,rm,pos,E,gmst,opt,drt);
 #endif
@@ -276,13 +249,191 @@ extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
     }
     if ((opt&2)&&odisp) { /* ocean tide loading */
         tide_oload(tut,odisp,denu);
-        matmul("TN",3,1,3,1.0,E,denu,0.0,drt);
+        matmul3v("T",E,denu,drt);
         for (i=0;i<3;i++) dr[i]+=drt[i];
     }
-    if ((opt&4)&&erp) { /* pole tide */
+    if ((opt&4)&&erpv) { /* pole tide */
         tide_pole(tut,pos,erpv,denu);
-        matmul("TN",3,1,3,1.0,E,denu,0.0,drt);
+        matmul3v("T",E,denu,drt);
         for (i=0;i<3;i++) dr[i]+=drt[i];
     }
     trace(5,"tidedisp: dr=%.3f %.3f %.3f\n",dr[0],dr[1],dr[2]);
 }
+/* tidal displacement with earth orientation cache ---------------------------*/
+static void tidedisp_(eoc_t *eoc, gtime_t tutc, const double *rr, int opt,
+                      const erp_t *erp, const double *odisp, double *dr)
+{
+    double rs[3]={0},rm[3]={0},gmst=0.0,erpv[5]={0};
+    
+    trace(3,"tidedisp: tutc=%s\n",time_str(tutc,0));
+    
+    if (erp) {
+        geterp(erp,utc2gpst(tutc),erpv);
+    }
+    if ((opt&1)&&norm(rr,3)>0.0) { /* solid earth tides */
+        
+        /* sun and moon position in ecef */
+        sunmoonposc(eoc,tutc,erpv,rs,rm,&gmst);
+    }
+    tidesite(tutc,rr,opt,erp?erpv:NULL,odisp,rs,rm,gmst,dr);
+}
+/* tidal displacement ----------------------------------------------------------
+* displacements by earth tides
+* args   : gtime_t tutc     I   time in utc
+*          double *rr       I   site position (ecef) (m)
+*          int    opt       I   options (or of the followings)
+*                                 1: solid earth tide
+*                                 2: ocean tide loading
+*                                 4: pole tide
+*                                 8: elimate permanent deformation
+*          double *erp      I   earth rotation parameters (NULL: not used)
+*          double *odisp    I   ocean loading parameters  (NULL: not used)
+*                                 odisp[0+i*6]: consituent i amplitude radial(m)
+*                                 odisp[1+i*6]: consituent i amplitude west  (m)
+*                                 odisp[2+i*6]: consituent i amplitude south (m)
+*                                 odisp[3+i*6]: consituent i phase radial  (deg)
+*                                 odisp[4+i*6]: consituent i phase west    (deg)
+*                                 odisp[5+i*6]: consituent i phase south   (deg)
+*                                (i=0:M2,1:S2,2:N2,3:K2,4:K1,5:O1,6:P1,7:Q1,
+*                                   8:Mf,9:Mm,10:Ssa)
+*          double *dr       O   displacement by earth tides (ecef) (m)
+* return : none
+* notes  : see ref [1], [2] chap 7
+*          see ref [4] 5.2.1, 5.2.2, 5.2.3
+*          ver.2.4.0 does not use ocean loading and pole tide corrections
+*-----------------------------------------------------------------------------*/
+extern void tidedisp(gtime_t tutc, const double *rr, int opt, const erp_t *erp,
+                     const double *odisp, double *dr)
+{
+    tidedisp_(NULL,tutc,rr,opt,erp,odisp,dr);
+}
+/* sun and moon positions and gmst at cache node -----------------------------*/
+static void tidenode(tidec_t *tc, eoc_t *eoc, double k, const erp_t *erp,
+                     double *sm, double *erpv)
+{
+    gtime_t t={0};
+    double tn=k*tc->tint,erpv_[5]={0};
+    int i;
+    
+    t.time=(time_t)floor(tn);
+    t.sec=tn-floor(tn);
+    if (erp) {
+        geterp(erp,utc2gpst(t),erpv_);
+    }
+    sunmoonposc(eoc,t,erpv_,sm,sm+3,sm+6);
+    for (i=0;i<3;i++) erpv[i]=erpv_[i];
+    tc->nnode++;
+}
+/* initialize tidal displacement cache -----------------------------------------
+* initialize tidal displacement cache
+* args   : tidec_t *tc      O   tidal displacement cache
+*          double tint      I   interval of displacement nodes (s) (0:no cache)
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void inittidec(tidec_t *tc, double tint)
+{
+    tidec_t tc0={0};
+    
+    *tc=tc0;
+    tc->tint=tint;
+}
+/* tidal displacement by earth tides with cache --------------------------------
+* displacements by earth tides with sun and moon positions interpolated from
+* the positions at cache nodes
+* args   : tidec_t *tc      IO  tidal displacement cache (NULL: no cache)
+*          eoc_t  *eoc      IO  earth orientation cache (NULL: no cache)
+*          other args are same as tidedisp()
+* return : none
+* notes  : the sun and moon positions (ecef) and gmst for solid earth tides are
+*          computed by sunmoonposc() at nodes of fixed interval tc->tint
+*          aligned to utc time and interpolated by 3rd-order lagrange
+*          polynomial of 4 nodes around the time. for the interval of 300 s,
+*          the errors of the displacements are less than 1E-7 m. the
+*          displacements depending on the site position, ocean tide loading
+*          and pole tide are computed at every call, so the nodes are kept for
+*          any site motion. the nodes are slid forward or backward with the
+*          time, so one node is computed per interval for a monotonic time
+*          sequence. the nodes are computed again if the erp values at the
+*          time differ from the interpolated erp values of the nodes by more
+*          than 1E-4 as or s by change of erp data. smaller changes affect the
+*          displacements less than 1E-8 m.
+*          the cache is not thread-safe and should be owned by each processing
+*          context.
+*-----------------------------------------------------------------------------*/
+extern void tidedispc(tidec_t *tc, eoc_t *eoc, gtime_t tutc, const double *rr,
+                      int opt, const erp_t *erp, const double *odisp,
+                      double *dr)
+{
+    double sm[4][7],ev[4][3],rs[3],rm[3],gmst,erpv[5]={0},erpi[3],t,tk,k,u;
+    double w[4],dg;
+    int i,j,m;
+    
+    if (!tc||tc->tint<=0.0||!(opt&1)||norm(rr,3)<=0.0) {
+        tidedisp_(eoc,tutc,rr,opt,erp,odisp,dr);
+        return;
+    }
+    tc->ncall++;
+    
+    if (erp) {
+        geterp(erp,utc2gpst(tutc),erpv);
+    }
+    t=(double)tutc.time+tutc.sec;
+    k=floor(t/tc->tint)-1.0; /* nodes k,...,k+3 around the time */
+    
+    if (!tc->n||fabs(k-tc->k0)>=4.0) {
+        for (i=0;i<4;i++) tidenode(tc,eoc,k+i,erp,tc->sm[i],tc->erpv[i]);
+    }
+    else if (k!=tc->k0) { /* slide nodes */
+        m=(int)(k-tc->k0);
+        for (i=0;i<4;i++) {
+            for (j=0;j<7;j++) sm[i][j]=tc->sm[i][j];
+            for (j=0;j<3;j++) ev[i][j]=tc->erpv[i][j];
+        }
+        for (i=0;i<4;i++) {
+            if (i+m>=0&&i+m<4) {
+                for (j=0;j<7;j++) tc->sm[i][j]=sm[i+m][j];
+                for (j=0;j<3;j++) tc->erpv[i][j]=ev[i+m][j];
+            }
+            else tidenode(tc,eoc,k+i,erp,tc->sm[i],tc->erpv[i]);
+        }
+    }
+    tc->k0=k;
+    tc->n=4;
+    
+    /* 3rd-order lagrange interpolation (u: normalized time from node k+1) */
+    tk=(k+1.0)*tc->tint;
+    u=((double)tutc.time-floor(tk)+tutc.sec-(tk-floor(tk)))/tc->tint;
+    w[0]=-u*(u-1.0)*(u-2.0)/6.0;
+    w[1]=(u+1.0)*(u-1.0)*(u-2.0)/2.0;
+    w[2]=-(u+1.0)*u*(u-2.0)/2.0;
+    w[3]=(u+1.0)*u*(u-1.0)/6.0;
+    
+    /* recompute nodes by change of erp data */
+    for (j=0;j<3;j++) {
+        erpi[j]=w[0]*tc->erpv[0][j]+w[1]*tc->erpv[1][j]+w[2]*tc->erpv[2][j]+
+                w[3]*tc->erpv[3][j];
+    }
+    if (fabs(erpi[0]-erpv[0])>MAXDERPC*AS2R||
+        fabs(erpi[1]-erpv[1])>MAXDERPC*AS2R||fabs(erpi[2]-erpv[2])>MAXDERPC) {
+        for (i=0;i<4;i++) tidenode(tc,eoc,k+i,erp,tc->sm[i],tc->erpv[i]);
+    }
+    for (j=0;j<3;j++) {
+        rs[j]=w[0]*tc->sm[0][j]+w[1]*tc->sm[1][j]+w[2]*tc->sm[2][j]+
+              w[3]*tc->sm[3][j];
+        rm[j]=w[0]*tc->sm[0][3+j]+w[1]*tc->sm[1][3+j]+w[2]*tc->sm[2][3+j]+
+              w[3]*tc->sm[3][3+j];
+    }
+    /* gmst unwrapped around node k */
+    for (i=0,gmst=0.0;i<4;i++) {
+        dg=tc->sm[i][6]-tc->sm[0][6];
+        if      (dg<-PI) dg+=2.0*PI;
+        else if (dg> PI) dg-=2.0*PI;
+        gmst+=w[i]*dg;
+    }
+    gmst+=tc->sm[0][6];
+    
+    tidesite(tutc,rr,opt,erp?erpv:NULL,odisp,rs,rm,gmst,dr);
+    
+    trace(5,"tidedispc: dr=%.3f %.3f %.3f nnode=%d ncall=%d\n",dr[0],dr[1],
+          dr[2],tc->nnode,tc->ncall);
+}